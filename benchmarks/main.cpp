@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <Analytic.h>
+#include <BandStructure.h>
+#include <Bracketing.h>
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include <Schroedinger.h>
+#include "test.h"
+
+/*! End-to-end benchmarks of whole solves, on the configurations of tests/main.cpp (box, harmonic
+ * oscillator, finite well) scaled up in grid size, number of levels and threads, plus the Kronig-Penney
+ * band structure. Every run is done in a forked child, so that its peak RSS is its own, and reports
+ * wall time, Numerov sweeps and the largest error against the analytic references of tests/test.cpp.
+ *
+ * Output (on stdout, solver diagnostics are discarded):
+ * - strong scaling: a fixed problem on 1, 2, 4, ... threads
+ * - weak scaling: the work (levels or k-points) grows with the threads
+ * - accuracy vs time for every solver configuration over the grid sizes, with its Pareto front
+ *
+ * usage: benchmarks [--quick] [--threads N]
+ */
+
+namespace {
+    enum Config { Scan10 = 0, Scan100 = 1, Bracket = 2, Mixed = 3, Bands = 4 };
+    const char *config_names[] = {"scan/10", "scan/100", "bracket", "mixed", "bands"};
+
+    const double ho_k = 0.5, well_width = 5., well_height = 10.;
+    const int repeats = 3;
+
+    struct Problem {
+        std::string potential;  // "box", "harmonic oscillator", "well", or "kronig-penney" for the bands
+        int nbox;
+        int levels;             // levels, or k-points of the band structure
+    };
+
+    struct Measurement {
+        bool ok;
+        double seconds;         // best of the repeats
+        unsigned long sweeps;   // Numerov sweeps, or Bloch trace evaluations of the band structure
+        long rss;               // peak resident set size, kB
+        double error;           // largest |E - E_analytic|
+    };
+
+    // Analytic level n (n = 0 is the ground state)
+    double reference(const std::string &potential, int n, int nbox) {
+        std::vector<double> x;
+        if (potential == "box")
+            return box_states(n + 1, x, 0., nbox * dx, false).energies[n];
+        if (potential == "well")
+            return finite_well_energy(n, well_width, well_height);
+        return harmonic_states(n + 1, x, std::sqrt(2. * ho_k / mass), false).energies[n];
+    }
+
+    /*! The levels are dealt round robin to the threads. The scan windows reach half way to the
+    neighbouring analytic levels, as the fixed windows of tests/main.cpp; the scan step is a tenth or a
+    hundredth of the window.
+    */
+    Measurement solve_levels(const Problem &p, Config config, int threads) {
+        ContinuousBase base(dx, (unsigned int) p.nbox);
+        Potential V = Potential::Builder(base.getCoords())
+                .setType(p.potential)
+                .setK(ho_k)
+                .setWidth(well_width)
+                .setHeight(well_height)
+                .build();
+
+        std::vector<double> ref(p.levels + 1), energies(p.levels);
+        for (int n = 0; n <= p.levels; n++)
+            ref[n] = reference(p.potential, n, p.nbox);
+        std::vector<unsigned long> sweeps(threads, 0);
+
+        auto worker = [&](int t) {
+            std::vector<double> wavefunction(p.nbox + 1);
+            unsigned long first = numerov_sweeps();
+            for (int n = t; n < p.levels; n += threads) {
+                wavefunction[0] = 0.;
+                wavefunction[1] = 0.01;
+                double lo = (n == 0) ? ref[0] - (ref[1] - ref[0]) / 2. : (ref[n - 1] + ref[n]) / 2.;
+                double hi = (ref[n] + ref[n + 1]) / 2.;
+
+                if (config == Bracket)
+                    energies[n] = solve_Numerov_level(n, p.nbox, V, wavefunction.data());
+                else if (config == Mixed)
+                    energies[n] = solve_Numerov_mixed<float, double>(lo, hi, (hi - lo) / 100., p.nbox, V, wavefunction.data());
+                else
+                    energies[n] = solve_Numerov(lo, hi, (hi - lo) / (config == Scan10 ? 10. : 100.), p.nbox, V, wavefunction.data());
+            }
+            sweeps[t] = numerov_sweeps() - first;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+            pool.emplace_back(worker, t);
+        worker(0);
+        for (auto &t : pool)
+            t.join();
+
+        Measurement m{};
+        m.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (unsigned long s : sweeps)
+            m.sweeps += s;
+        for (int n = 0; n < p.levels; n++)
+            m.error = std::max(m.error, std::fabs(energies[n] - ref[n]));
+        return m;
+    }
+
+    // Kronig-Penney lattice of tests/main.cpp: wells of width 1 between barriers of height 5 and width 1
+    Measurement solve_bands(const Problem &p, int threads) {
+        ContinuousBase cell(-1.005, 0.995, 200u);
+        cell.setBoundary(ContinuousBase::Periodic);
+        Potential V = Potential::Builder(cell.getCoords()).setType("well").setWidth(1.).setHeight(5.).build();
+
+        auto start = std::chrono::steady_clock::now();
+        BandStructure bands(cell, V, 2, threads);
+        BandStructure::Result r = bands.compute(p.levels);
+
+        Measurement m{};
+        m.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        m.sweeps = (unsigned long) r.evaluations;
+        for (std::vector<double>::size_type j = 0; j < r.k.size(); j++)
+            m.error = std::max(m.error, std::fabs(r.energies[j][0] - kronig_penney_energy(r.k[j], 1., 1., 5.)));
+        return m;
+    }
+
+    Measurement run_once(const Problem &p, Config config, int threads) {
+        Measurement m{};
+        int fd[2];
+        if (pipe(fd) != 0) {
+            std::perror("ERROR: pipe");
+            return m;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fd[0]);
+            // the solvers' own warnings would drown the tables
+            std::ofstream discard("/dev/null");
+            std::streambuf *errors = std::cerr.rdbuf(discard.rdbuf());
+            int status = 1;
+            try {
+                Measurement r = (config == Bands) ? solve_bands(p, threads) : solve_levels(p, config, threads);
+                r.ok = true;
+                if (write(fd[1], &r, sizeof(r)) == (ssize_t) sizeof(r))
+                    status = 0;
+            }
+            catch (const std::exception &e) {
+                std::cerr.rdbuf(errors);
+                std::cerr << "ERROR: " << e.what() << std::endl;
+            }
+            _exit(status);
+        }
+
+        close(fd[1]);
+        bool received = pid > 0 && read(fd[0], &m, sizeof(m)) == (ssize_t) sizeof(m);
+        close(fd[0]);
+
+        int status = 1;
+        struct rusage usage = {};
+        if (pid > 0)
+            wait4(pid, &status, 0, &usage);
+        m.ok = received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        m.rss = usage.ru_maxrss;
+        return m;
+    }
+
+    Measurement measure(const Problem &p, Config config, int threads) {
+        Measurement best = run_once(p, config, threads);
+        for (int r = 1; r < repeats && best.ok; r++) {
+            Measurement m = run_once(p, config, threads);
+            if (m.ok && m.seconds < best.seconds)
+                best.seconds = m.seconds;
+            best.rss = std::max(best.rss, m.rss);
+        }
+        return best;
+    }
+
+    std::string label(const Problem &p) {
+        std::string name = (p.potential == "harmonic oscillator") ? "ho" : p.potential;
+        return name + "/" + std::to_string(p.nbox) + "/" + std::to_string(p.levels);
+    }
+
+    void header(std::ostream &out, const std::string &title, const std::string &columns) {
+        out << "\n# " << title << "\n# " << columns << std::endl;
+    }
+
+    void row(std::ostream &out, const Problem &p, Config config, int threads, const Measurement &m, double base) {
+        out << std::left << std::setw(24) << label(p) << std::setw(10) << config_names[config] << std::right
+            << std::setw(4) << threads;
+        if (!m.ok) {
+            out << "  failed" << std::endl;
+            return;
+        }
+        out << std::scientific << std::setprecision(3)
+            << std::setw(12) << m.seconds
+            << std::fixed << std::setprecision(2)
+            << std::setw(9) << base / m.seconds
+            << std::setw(12) << m.sweeps
+            << std::setw(10) << m.rss
+            << std::scientific << std::setprecision(2) << std::setw(11) << m.error
+            << std::defaultfloat << std::endl;
+    }
+
+    std::vector<int> thread_counts(int max_threads) {
+        std::vector<int> counts;
+        for (int t = 1; t < max_threads; t *= 2)
+            counts.push_back(t);
+        counts.push_back(max_threads);
+        return counts;
+    }
+}
+
+int main(int argc, char **argv) {
+    bool quick = false;
+    int max_threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quick")
+            quick = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            max_threads = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: " << argv[0] << " [--quick] [--threads N]" << std::endl;
+            return 1;
+        }
+    }
+
+    // the solvers report on std::cout: keep stdout for the tables only
+    std::ostream out(std::cout.rdbuf());
+    std::ofstream discard("/dev/null");
+    std::cout.rdbuf(discard.rdbuf());
+
+    const int nbox = quick ? 2000 : 8000;
+    const int levels = quick ? 8 : 16;
+    const int kpoints = quick ? 2000 : 20000;
+    const std::vector<int> grids = quick ? std::vector<int>{500, 1000, 2000}
+                                         : std::vector<int>{500, 1000, 2000, 4000, 8000};
+    const std::vector<int> threads = thread_counts(max_threads);
+    const std::string columns = "problem                 config    thr     time[s]  speedup      sweeps   rss[kB]      error";
+
+    out << "# Schroedinger end-to-end benchmarks: " << max_threads << " threads, best of " << repeats << " runs" << std::endl;
+    out << "# problem: potential/nbox/levels (k-points for kronig-penney); speedup is against 1 thread;" << std::endl;
+    out << "# sweeps: Numerov sweeps (Bloch trace evaluations for kronig-penney); error: largest against the analytic levels" << std::endl;
+
+    header(out, "Strong scaling: fixed problem", columns);
+    std::vector< std::pair<Problem, Config> > strong = {
+        {{"box", nbox, levels}, Bracket},
+        {{"harmonic oscillator", nbox, levels}, Bracket},
+        {{"well", nbox, 6}, Bracket},
+        {{"kronig-penney", 200, kpoints}, Bands},
+    };
+    for (auto &s : strong) {
+        double base = 0.;
+        for (int t : threads) {
+            Measurement m = measure(s.first, s.second, t);
+            if (t == 1)
+                base = m.seconds;
+            row(out, s.first, s.second, t, m, base);
+        }
+    }
+
+    header(out, "Weak scaling: work proportional to threads (efficiency = speedup)", columns);
+    for (auto &s : strong) {
+        if (s.first.potential == "well")
+            continue;   // a finite well has only a few bound levels
+        int perThread = (s.second == Bands) ? kpoints / 8 : 2;
+        double base = 0.;
+        for (int t : threads) {
+            Problem p = s.first;
+            p.levels = perThread * t;
+            Measurement m = measure(p, s.second, t);
+            if (t == 1)
+                base = m.seconds;
+            row(out, p, s.second, t, m, base);
+        }
+    }
+
+    header(out, "Accuracy vs time per configuration, over the grid size; * marks the Pareto front",
+           columns + "  front");
+    for (std::string potential : {"box", "harmonic oscillator", "well"}) {
+        for (Config config : {Scan10, Scan100, Bracket, Mixed}) {
+            std::vector<Problem> problems;
+            std::vector<Measurement> results;
+            for (int n : grids) {
+                problems.push_back({potential, n, 4});
+                results.push_back(measure(problems.back(), config, 1));
+            }
+
+            // on the front: no faster run of the same configuration is as accurate
+            std::vector<std::size_t> order(results.size());
+            for (std::size_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            std::sort(order.begin(), order.end(),
+                      [&](std::size_t a, std::size_t b) { return results[a].seconds < results[b].seconds; });
+            std::vector<bool> front(results.size(), false);
+            double best = INFINITY;
+            for (std::size_t i : order) {
+                if (results[i].ok && results[i].error < best) {
+                    front[i] = true;
+                    best = results[i].error;
+                }
+            }
+
+            for (std::size_t i : order) {
+                std::ostringstream line;
+                row(line, problems[i], config, 1, results[i], results[i].seconds);
+                std::string text = line.str();
+                text.pop_back();
+                out << text << (front[i] ? "  *" : "") << std::endl;
+            }
+        }
+    }
+    return 0;
+}
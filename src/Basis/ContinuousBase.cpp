@@ -49,6 +49,31 @@ std::vector<double> ContinuousBase::evaluate()
 	return coord;
 }
 
-std::vector<double> ContinuousBase::getCoords() {
+std::vector<double> ContinuousBase::getCoords() const {
 	return this->coords;
 }
+
+double ContinuousBase::getStart() const {
+	return this->start;
+}
+
+double ContinuousBase::getEnd() const {
+	return this->end;
+}
+
+double ContinuousBase::getMesh() const {
+	return this->mesh;
+}
+
+unsigned int ContinuousBase::getNbox() const {
+	return (unsigned int) this->nbox;
+}
+
+ContinuousBase::Boundary ContinuousBase::getBoundary() const {
+	return this->boundary;
+}
+
+ContinuousBase& ContinuousBase::setBoundary(Boundary b) {
+	this->boundary = b;
+	return *this;
+}
@@ -8,12 +8,23 @@
 
 class ContinuousBase 
 {
+public:
+	// HardWall: the wavefunction vanishes at start and end; Periodic: [start, end) is a unit cell
+	enum Boundary { HardWall = 0, Periodic = 1 };
+
 private:
 	double start, end, mesh, nbox;
+	Boundary boundary = HardWall;
 	std::vector<double> coords;
 	std::vector<double> evaluate();
 public:
-	std::vector<double> getCoords();
+	std::vector<double> getCoords() const;
+	double getStart() const;
+	double getEnd() const;
+	double getMesh() const;
+	unsigned int getNbox() const;
+	Boundary getBoundary() const;
+	ContinuousBase& setBoundary(Boundary);
 	ContinuousBase();	
 	ContinuousBase(double, unsigned int);
 	ContinuousBase(double, double, double);
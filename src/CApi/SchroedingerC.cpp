@@ -0,0 +1,281 @@
+#include "SchroedingerC.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Bracketing.h>
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include <Schroedinger.h>
+#include <Spectrum.h>
+
+struct sch_base {
+    ContinuousBase base;
+    int nbox;
+    double mesh;
+    std::vector<double> coords;
+};
+
+struct sch_potential {
+    const sch_base *base;
+    std::unique_ptr<Potential> owned;   // built-in types; null for a wrapped caller buffer
+    const double *values;
+};
+
+namespace {
+    thread_local std::string last_error;
+
+    // a status with its message
+    struct Failure {
+        int status;
+        std::string message;
+    };
+
+    int fail(int status, const std::string &message) {
+        last_error = message;
+        return status;
+    }
+
+    /*! Runs body, turning exceptions into status codes: nothing thrown crosses the C interface.
+    */
+    template<typename Body>
+    int guard(Body body) {
+        try {
+            int status = body();
+            if (status == SCH_OK)
+                last_error.clear();
+            return status;
+        }
+        catch (const Failure &f) {
+            return fail(f.status, f.message);
+        }
+        catch (const std::invalid_argument &e) {
+            return fail(SCH_INVALID_ARGUMENT, e.what());
+        }
+        catch (const std::bad_alloc &) {
+            return fail(SCH_NO_MEMORY, "out of memory");
+        }
+        catch (const std::exception &e) {
+            return fail(SCH_INTERNAL, e.what());
+        }
+        catch (...) {
+            return fail(SCH_INTERNAL, "unknown error");
+        }
+    }
+
+    void require(bool condition, const char *message) {
+        if (!condition)
+            throw Failure{SCH_INVALID_ARGUMENT, message};
+    }
+
+    void require_buffer(const void *buffer, size_t size, size_t needed, const char *name) {
+        require(buffer != nullptr, (std::string(name) + " is null").c_str());
+        if (reinterpret_cast<std::uintptr_t>(buffer) % alignof(double) != 0)
+            throw Failure{SCH_INVALID_ARGUMENT, std::string(name) + " is not aligned to a double"};
+        if (size < needed)
+            throw Failure{SCH_INVALID_ARGUMENT, std::string(name) + " holds " + std::to_string(size)
+                                                + " values, " + std::to_string(needed) + " needed"};
+    }
+
+    // the Potential of the solvers that need one: a wrapped buffer is copied, once per call
+    Potential as_potential(const sch_potential *potential) {
+        if (potential->owned)
+            return *potential->owned;
+        Potential V = Potential::Builder(potential->base->coords).build();
+        V.setValues(std::vector<double>(potential->values, potential->values + potential->base->nbox));
+        return V;
+    }
+
+    int status_of(SolveResult::Status status) {
+        switch (status) {
+            case SolveResult::Converged:    return SCH_OK;
+            case SolveResult::NotFound:     return SCH_NOT_FOUND;
+            case SolveResult::NotConverged: return SCH_NOT_CONVERGED;
+            default:                        return SCH_INTERNAL;
+        }
+    }
+}
+
+extern "C" {
+
+int sch_abi_version(void)
+{
+    return SCH_ABI_VERSION;
+}
+
+const char *sch_status_message(int status)
+{
+    switch (status) {
+        case SCH_OK:               return "ok";
+        case SCH_INVALID_ARGUMENT: return "invalid argument";
+        case SCH_NOT_FOUND:        return "not found";
+        case SCH_NOT_CONVERGED:    return "not converged";
+        case SCH_NO_MEMORY:        return "out of memory";
+        case SCH_INTERNAL:         return "internal error";
+        default:                   return "unknown status";
+    }
+}
+
+const char *sch_last_error(void)
+{
+    return last_error.c_str();
+}
+
+int sch_base_create(double mesh, int nbox, sch_base **base)
+{
+    return guard([&] {
+        require(base != nullptr, "base is null");
+        *base = nullptr;
+        require(mesh > 0, "mesh must be positive");
+        require(nbox >= 3, "nbox must be at least 3");
+
+        std::unique_ptr<sch_base> made(new sch_base{ContinuousBase(mesh, (unsigned int) nbox), nbox, mesh, {}});
+        made->coords = made->base.getCoords();
+        *base = made.release();
+        return SCH_OK;
+    });
+}
+
+void sch_base_destroy(sch_base *base)
+{
+    delete base;
+}
+
+int sch_base_nbox(const sch_base *base, int *nbox)
+{
+    return guard([&] {
+        require(base != nullptr && nbox != nullptr, "null argument");
+        *nbox = base->nbox;
+        return SCH_OK;
+    });
+}
+
+int sch_base_mesh(const sch_base *base, double *mesh)
+{
+    return guard([&] {
+        require(base != nullptr && mesh != nullptr, "null argument");
+        *mesh = base->mesh;
+        return SCH_OK;
+    });
+}
+
+int sch_base_coords(const sch_base *base, double *coords, size_t size)
+{
+    return guard([&] {
+        require(base != nullptr, "base is null");
+        require_buffer(coords, size, base->coords.size(), "coords");
+        std::copy(base->coords.begin(), base->coords.end(), coords);
+        return SCH_OK;
+    });
+}
+
+int sch_potential_create(const sch_base *base, const char *type, double k, double width, double height,
+                         sch_potential **potential)
+{
+    return guard([&] {
+        require(potential != nullptr, "potential is null");
+        *potential = nullptr;
+        require(base != nullptr && type != nullptr, "null argument");
+
+        std::unique_ptr<Potential> V(new Potential(Potential::Builder(base->coords)
+                .setType(type)
+                .setK(k)
+                .setWidth(width)
+                .setHeight(height)
+                .build()));
+        const double *values = V->getValues().data();
+        *potential = new sch_potential{base, std::move(V), values};
+        return SCH_OK;
+    });
+}
+
+int sch_potential_wrap(const sch_base *base, const double *values, size_t size, sch_potential **potential)
+{
+    return guard([&] {
+        require(potential != nullptr, "potential is null");
+        *potential = nullptr;
+        require(base != nullptr, "base is null");
+        require_buffer(values, size, (size_t) base->nbox, "values");
+        *potential = new sch_potential{base, nullptr, values};
+        return SCH_OK;
+    });
+}
+
+void sch_potential_destroy(sch_potential *potential)
+{
+    delete potential;
+}
+
+int sch_potential_values(const sch_potential *potential, const double **values)
+{
+    return guard([&] {
+        require(potential != nullptr && values != nullptr, "null argument");
+        *values = potential->values;
+        return SCH_OK;
+    });
+}
+
+int sch_solve(const sch_potential *potential, double emin, double emax, double estep,
+              double *wavefunction, size_t size, double *energy)
+{
+    return guard([&] {
+        require(potential != nullptr && energy != nullptr, "null argument");
+        int nbox = potential->base->nbox;
+        require_buffer(wavefunction, size, (size_t) nbox + 1, "wavefunction");
+        require(estep > 0 && emax > emin, "the energy window must satisfy emin < emax and estep > 0");
+        const SolverConfig config = SolverConfig().setMesh(potential->base->mesh);
+
+        wavefunction[0] = 0.;
+        wavefunction[1] = 0.01;
+        SolveResult result = solve_Numerov(emin, emax, estep, nbox, potential->values, wavefunction, SolveControl(),
+                                           config);
+        *energy = result.energy;
+        if (!result.converged())
+            throw Failure{status_of(result.status), SolveResult::describe(result.status)};
+        return SCH_OK;
+    });
+}
+
+int sch_solve_level(const sch_potential *potential, int n, double *wavefunction, size_t size, double *energy)
+{
+    return guard([&] {
+        require(potential != nullptr && energy != nullptr, "null argument");
+        int nbox = potential->base->nbox;
+        require_buffer(wavefunction, size, (size_t) nbox + 1, "wavefunction");
+        require(n >= 0, "the level must not be negative");
+        const SolverConfig config = SolverConfig().setMesh(potential->base->mesh);
+
+        wavefunction[0] = 0.;
+        wavefunction[1] = 0.01;
+        *energy = solve_Numerov_level(n, nbox, as_potential(potential), wavefunction, config);
+        return SCH_OK;
+    });
+}
+
+int sch_solve_spectrum(const sch_potential *potential, int engine, int levels, double *energies,
+                       double *wavefunctions, size_t size)
+{
+    return guard([&] {
+        require(potential != nullptr && energies != nullptr, "null argument");
+        require(engine >= SCH_ENGINE_NUMEROV && engine <= SCH_ENGINE_DVR, "unknown engine");
+        require(levels >= 1, "at least one level");
+        std::size_t points = (std::size_t) potential->base->nbox + 1;
+        if (wavefunctions)
+            require_buffer(wavefunctions, size, levels * points, "wavefunctions");
+
+        Spectrum s = solve_spectrum((Spectrum::Engine) engine, levels, potential->base->base,
+                                    as_potential(potential), wavefunctions != nullptr, SolverConfig());
+        std::copy(s.energies.begin(), s.energies.end(), energies);
+        for (int n = 0; wavefunctions && n < levels; n++)
+            std::copy(s.wavefunctions[n].begin(), s.wavefunctions[n].end(), wavefunctions + n * points);
+        return SCH_OK;
+    });
+}
+
+}
@@ -0,0 +1,99 @@
+#ifndef SCHROEDINGERC_H
+#define SCHROEDINGERC_H
+
+/*! C interface of the solver, for embedding in C and Fortran (bind(C)) codes.
+ *
+ * Stability: only opaque handles, int status codes and plain C types cross the interface; no C++ type, exception
+ * or allocation does. Symbols are only added, never changed: SCH_ABI_VERSION is bumped when one is added, and
+ * sch_abi_version() tells the version of the library actually loaded.
+ *
+ * Buffers: potentials and wavefunctions live in arrays owned by the caller, read and written in place.
+ * - a base of nbox points has potentials of nbox values and wavefunctions of nbox + 1 values (the last one
+ *   is the right wall), in units of double
+ * - sch_potential_wrap() keeps a pointer to the caller values, no copy: sch_solve reads them in place, so
+ *   changes made by the caller between solves are seen by the next solve. sch_solve_level and
+ *   sch_solve_spectrum work on a Potential, into which a wrapped buffer is copied once per call
+ * - the wavefunction (or spectrum) buffers are filled by the solves, no other memory is returned
+ * - buffers only need the alignment of double; SCH_ALIGNMENT (64 bytes) is the alignment the kernels run best with
+ *
+ * Thread safety: handles are immutable once made. Any number of threads may solve with the same base and
+ * potential handles at once, provided that each call has its own output buffers and that a wrapped
+ * potential buffer is not written during a solve. A handle may be destroyed once no call uses it, and
+ * a base must outlive the potentials made on it. Error messages are kept per thread.
+ *
+ * Every function returns SCH_OK or an error status; sch_last_error() describes the last error of the thread.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define SCH_API __declspec(dllexport)
+#else
+#define SCH_API __attribute__((visibility("default")))
+#endif
+
+#define SCH_ABI_VERSION 1
+#define SCH_ALIGNMENT 64
+
+enum sch_status {
+    SCH_OK = 0,
+    SCH_INVALID_ARGUMENT = 1,  /* null or misaligned pointer, wrong size, unknown type or engine */
+    SCH_NOT_FOUND = 2,         /* no level in the energy window */
+    SCH_NOT_CONVERGED = 3,
+    SCH_NO_MEMORY = 4,
+    SCH_INTERNAL = 5
+};
+
+enum sch_engine {
+    SCH_ENGINE_NUMEROV = 0,
+    SCH_ENGINE_FD6 = 1,
+    SCH_ENGINE_DVR = 2
+};
+
+typedef struct sch_base sch_base;
+typedef struct sch_potential sch_potential;
+
+SCH_API int sch_abi_version(void);
+SCH_API const char *sch_status_message(int status);
+/* Message of the last error of the calling thread, "" if none */
+SCH_API const char *sch_last_error(void);
+
+/* Grid of nbox points, spaced by mesh and centered on 0, with hard walls */
+SCH_API int sch_base_create(double mesh, int nbox, sch_base **base);
+SCH_API void sch_base_destroy(sch_base *base);
+SCH_API int sch_base_nbox(const sch_base *base, int *nbox);
+SCH_API int sch_base_mesh(const sch_base *base, double *mesh);
+/* Copies the nbox coordinates into coords, size values long */
+SCH_API int sch_base_coords(const sch_base *base, double *coords, size_t size);
+
+/* Potential of a built-in type ("box", "harmonic oscillator", "finite well" ... as Potential::Builder) */
+SCH_API int sch_potential_create(const sch_base *base, const char *type, double k, double width, double height,
+                                 sch_potential **potential);
+/* Potential read in place from the nbox values of the caller, which must outlive the handle */
+SCH_API int sch_potential_wrap(const sch_base *base, const double *values, size_t size, sch_potential **potential);
+SCH_API void sch_potential_destroy(sch_potential *potential);
+/* The values the solves read: the caller buffer of a wrapped potential */
+SCH_API int sch_potential_values(const sch_potential *potential, const double **values);
+
+/* solve_Numerov: scan of [emin, emax] by estep, then bisection; wavefunction (nbox + 1 values) gets the normalized solution.
+ * The solves run on the mesh of the base, with the default tolerance (1e-10) and units (hbar = m = 1).
+ */
+SCH_API int sch_solve(const sch_potential *potential, double emin, double emax, double estep,
+                      double *wavefunction, size_t size, double *energy);
+/* Level n (0 is the ground state) without energy window (node counting, as solve_Numerov_level) */
+SCH_API int sch_solve_level(const sch_potential *potential, int n, double *wavefunction, size_t size, double *energy);
+/* Lowest levels with an engine (see Spectrum): energies holds levels values, wavefunctions (NULL for none)
+ * levels * (nbox + 1) values, level after level.
+ */
+SCH_API int sch_solve_spectrum(const sch_potential *potential, int engine, int levels, double *energies,
+                               double *wavefunctions, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,6 +8,7 @@ Potential::Potential(std::vector<double> coord, std::string type, double k, doub
     this->width    = width;
     this->height   = height;
     this->type     = type;
+    this->changed  = Region{0, x.size()};
 
     if(type.compare("box potential") == 0 || type.compare("box") == 0 || type.compare("0") == 0)
         this->box_potential();
@@ -40,7 +41,60 @@ void Potential::finite_well_potential()
         this->v[i] = (this->x[i] > -this->width/2.0 && this->x[i] < this->width/2.0) ? 0.0 : this->height;
 }
 
-std::vector<double> Potential::getValues()
+const std::vector<double>& Potential::getValues() const
 {
     return this->v;
 }
+
+void Potential::setValues(const std::vector<double>& values)
+{
+    if (values.size() != this->x.size())
+        throw std::invalid_argument("Potential values must match the number of coordinates.");
+
+    this->changed = changedRegion(this->v, values);
+    this->v       = values;
+    this->type    = "custom";
+}
+
+Potential::Region Potential::getChanged() const
+{
+    return this->changed;
+}
+
+Potential::Region Potential::changedFrom(const Potential& previous) const
+{
+    return changedRegion(previous.v, this->v);
+}
+
+Potential::Region Potential::changedRegion(const std::vector<double>& before, const std::vector<double>& after)
+{
+    if (before.size() != after.size())
+        return Region{0, after.size()};
+
+    std::size_t first = 0, last = after.size();
+    while (first < last && before[first] == after[first])
+        first++;
+    while (last > first && before[last - 1] == after[last - 1])
+        last--;
+    return Region{first, last};
+}
+
+std::string Potential::getType() const
+{
+    return this->type;
+}
+
+double Potential::getK() const
+{
+    return this->k;
+}
+
+double Potential::getWidth() const
+{
+    return this->width;
+}
+
+double Potential::getHeight() const
+{
+    return this->height;
+}
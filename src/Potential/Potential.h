@@ -24,10 +24,23 @@
  * Outputs:
  * - v, the std::vector of output, the value of the potential for every value of x.
  *
+ * setValues() replaces the values in place (e.g. for self-consistent potentials), the type becomes "custom".
+ *
+ * getChanged() reports the grid points where the values changed: the points that differ from the potential
+ * given to Builder::build(previous), or the points changed by the last setValues(); every point after a plain build().
+ * The Numerov sweep runs left to right, so the sweep before changed.first is the same as for the previous potential.
+ *
  * Eventually it throws invalid_argument exception if given parameters are wrong.
  */
 
 class Potential {
+public:
+    //! Grid points [first, last) of a change, empty if first == last
+    struct Region {
+        std::size_t first, last;
+        bool empty() const { return first >= last; }
+    };
+
 private:
     std::vector<double> x;
     std::vector<double> v;
@@ -36,6 +49,7 @@ private:
     double k;
     double width;
     double height;
+    Region changed;
 
     void ho_potential();
     void box_potential();
@@ -43,7 +57,16 @@ private:
 
 public:
     Potential(std::vector<double>, std::string, double, double, double);
-    std::vector<double> getValues();
+    const std::vector<double>& getValues() const;
+    void setValues(const std::vector<double>&);
+    Region getChanged() const;
+    //! Points where the values differ from those of previous (every point if the grids differ)
+    Region changedFrom(const Potential& previous) const;
+    static Region changedRegion(const std::vector<double>& before, const std::vector<double>& after);
+    std::string getType() const;
+    double getK() const;
+    double getWidth() const;
+    double getHeight() const;
     // Base get_x();
 
     class Builder{
@@ -62,6 +85,8 @@ public:
             Builder setType(std::string type);
             // Builder setBase(Base b);
             Potential build();
+            //! Builds, recording in getChanged() the points that differ from previous
+            Potential build(const Potential& previous);
     };
 };
 
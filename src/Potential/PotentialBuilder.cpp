@@ -44,6 +44,12 @@ Potential Potential::Builder::build(){
     }
 }
 
+Potential Potential::Builder::build(const Potential& previous){
+    Potential V = build();
+    V.changed = V.changedFrom(previous);
+    return V;
+}
+
 // Potential::Builder Potential::Builder::setBase(Base b)
 // {
 //     this->base = b;
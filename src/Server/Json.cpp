@@ -0,0 +1,283 @@
+#include "Json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+JsonValue::JsonValue(bool b) : type(Bool), boolean(b) {}
+JsonValue::JsonValue(double d) : type(Number), number(d) {}
+JsonValue::JsonValue(std::string s) : type(String), str(s) {}
+JsonValue::JsonValue(const char* s) : type(String), str(s) {}
+
+JsonValue::Type JsonValue::getType() const {
+    return this->type;
+}
+
+bool JsonValue::asBool() const {
+    if (this->type != Bool)
+        throw std::invalid_argument("JSON value is not a boolean.");
+    return this->boolean;
+}
+
+double JsonValue::asNumber() const {
+    if (this->type != Number)
+        throw std::invalid_argument("JSON value is not a number.");
+    return this->number;
+}
+
+std::string JsonValue::asString() const {
+    if (this->type != String)
+        throw std::invalid_argument("JSON value is not a string.");
+    return this->str;
+}
+
+std::string JsonValue::dump() const {
+    switch (this->type) {
+        case Bool:   return this->boolean ? "true" : "false";
+        case Number: return json_number(this->number);
+        case String: return json_quote(this->str);
+        default:     return "null";
+    }
+}
+
+std::string json_quote(const std::string& s) {
+    std::string out = "\"";
+    for (char ch : s) {
+        switch (ch) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if ((unsigned char) ch < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                    out += buf;
+                }
+                else out += ch;
+        }
+    }
+    return out + "\"";
+}
+
+std::string json_number(double d) {
+    // JSON has no representation for inf/nan
+    if (!std::isfinite(d))
+        return "null";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.17g", d);
+    return buf;
+}
+
+// --- Parser --- //
+
+namespace {
+    class Parser {
+        const std::string& s;
+        std::size_t p = 0;
+
+    public:
+        explicit Parser(const std::string& text) : s(text) {}
+
+        void skipSpaces() {
+            while (p < s.size() && (s[p] == ' ' || s[p] == '\t' || s[p] == '\r' || s[p] == '\n'))
+                p++;
+        }
+
+        bool atEnd() {
+            skipSpaces();
+            return p >= s.size();
+        }
+
+        void expect(char ch) {
+            skipSpaces();
+            if (p >= s.size() || s[p] != ch)
+                throw std::invalid_argument(std::string("Malformed JSON: expected '") + ch + "'.");
+            p++;
+        }
+
+        bool accept(char ch) {
+            skipSpaces();
+            if (p < s.size() && s[p] == ch) {
+                p++;
+                return true;
+            }
+            return false;
+        }
+
+        std::string parseString() {
+            expect('"');
+            std::string out;
+            while (p < s.size() && s[p] != '"') {
+                char ch = s[p++];
+                if (ch != '\\') {
+                    out += ch;
+                    continue;
+                }
+                if (p >= s.size())
+                    break;
+                char esc = s[p++];
+                switch (esc) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': {
+                        if (p + 4 > s.size())
+                            throw std::invalid_argument("Malformed JSON: truncated \\u escape.");
+                        unsigned long code = std::strtoul(s.substr(p, 4).c_str(), nullptr, 16);
+                        p += 4;
+                        // Request keys and values are plain ASCII; anything else is kept as '?'
+                        out += (code < 0x80) ? (char) code : '?';
+                        break;
+                    }
+                    default: out += esc;
+                }
+            }
+            if (p >= s.size())
+                throw std::invalid_argument("Malformed JSON: unterminated string.");
+            p++;
+            return out;
+        }
+
+        JsonValue parseValue() {
+            skipSpaces();
+            if (p >= s.size())
+                throw std::invalid_argument("Malformed JSON: missing value.");
+
+            if (s[p] == '"')
+                return JsonValue(parseString());
+            if (s.compare(p, 4, "true") == 0) {
+                p += 4;
+                return JsonValue(true);
+            }
+            if (s.compare(p, 5, "false") == 0) {
+                p += 5;
+                return JsonValue(false);
+            }
+            if (s.compare(p, 4, "null") == 0) {
+                p += 4;
+                return JsonValue();
+            }
+
+            return JsonValue(parseNumber());
+        }
+
+        //! -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?: strtod alone would also take inf, nan and hex floats
+        double parseNumber() {
+            std::size_t begin = p;
+            if (p < s.size() && s[p] == '-')
+                p++;
+            if (p < s.size() && s[p] == '0')
+                p++;
+            else if (!digits())
+                throw std::invalid_argument("Malformed JSON: unexpected character.");
+            if (p < s.size() && s[p] == '.') {
+                p++;
+                if (!digits())
+                    throw std::invalid_argument("Malformed JSON: digits expected after '.'.");
+            }
+            if (p < s.size() && (s[p] == 'e' || s[p] == 'E')) {
+                p++;
+                if (p < s.size() && (s[p] == '+' || s[p] == '-'))
+                    p++;
+                if (!digits())
+                    throw std::invalid_argument("Malformed JSON: digits expected in the exponent.");
+            }
+
+            double d = std::strtod(s.substr(begin, p - begin).c_str(), nullptr);
+            if (!std::isfinite(d))
+                throw std::invalid_argument("Malformed JSON: number out of range.");
+            return d;
+        }
+
+        bool digits() {
+            std::size_t begin = p;
+            while (p < s.size() && s[p] >= '0' && s[p] <= '9')
+                p++;
+            return p > begin;
+        }
+    };
+}
+
+JsonObject JsonObject::parse(const std::string& text) {
+    Parser parser(text);
+    JsonObject obj;
+
+    parser.expect('{');
+    if (!parser.accept('}')) {
+        do {
+            std::string key = parser.parseString();
+            parser.expect(':');
+            obj.set(key, parser.parseValue());
+        } while (parser.accept(','));
+        parser.expect('}');
+    }
+    if (!parser.atEnd())
+        throw std::invalid_argument("Malformed JSON: trailing characters after object.");
+
+    return obj;
+}
+
+bool JsonObject::has(const std::string& key) const {
+    return this->values.count(key) > 0;
+}
+
+JsonValue JsonObject::get(const std::string& key) const {
+    auto it = this->values.find(key);
+    if (it == this->values.end())
+        throw std::invalid_argument("Missing JSON member \"" + key + "\".");
+    return it->second;
+}
+
+double JsonObject::getNumber(const std::string& key, double fallback) const {
+    return has(key) ? get(key).asNumber() : fallback;
+}
+
+std::string JsonObject::getString(const std::string& key, std::string fallback) const {
+    return has(key) ? get(key).asString() : fallback;
+}
+
+bool JsonObject::getBool(const std::string& key, bool fallback) const {
+    return has(key) ? get(key).asBool() : fallback;
+}
+
+void JsonObject::setField(const std::string& key, const std::string& text) {
+    for (auto& field : this->fields) {
+        if (field.first == key) {
+            field.second = text;
+            return;
+        }
+    }
+    this->fields.push_back(std::make_pair(key, text));
+}
+
+JsonObject& JsonObject::set(const std::string& key, JsonValue value) {
+    this->values[key] = value;
+    setField(key, value.dump());
+    return *this;
+}
+
+JsonObject& JsonObject::setArray(const std::string& key, const std::vector<double>& array) {
+    std::string text = "[";
+    for (std::vector<double>::size_type i = 0; i < array.size(); i++) {
+        if (i > 0) text += ",";
+        text += json_number(array[i]);
+    }
+    text += "]";
+
+    this->values.erase(key);
+    setField(key, text);
+    return *this;
+}
+
+std::string JsonObject::dump() const {
+    std::string out = "{";
+    for (std::vector<int>::size_type i = 0; i < this->fields.size(); i++) {
+        if (i > 0) out += ",";
+        out += json_quote(this->fields[i].first) + ":" + this->fields[i].second;
+    }
+    return out + "}";
+}
@@ -0,0 +1,63 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+/*! Minimal JSON support for the line-delimited request protocol of the server mode.
+ * Only flat objects are parsed: every member must be a string, a number, a boolean or null.
+ * Malformed input throws std::invalid_argument.
+ */
+class JsonValue {
+public:
+    enum Type { Null = 0, Bool = 1, Number = 2, String = 3 };
+
+    JsonValue() {}
+    JsonValue(bool b);
+    JsonValue(double d);
+    JsonValue(std::string s);
+    JsonValue(const char* s);
+
+    Type getType() const;
+    bool asBool() const;
+    double asNumber() const;
+    std::string asString() const;
+    //! Serializes the value back to JSON text (numbers with full double precision).
+    std::string dump() const;
+
+private:
+    Type type       = Null;
+    bool boolean    = false;
+    double number   = 0.;
+    std::string str;
+};
+
+class JsonObject {
+public:
+    static JsonObject parse(const std::string&);
+
+    bool has(const std::string&) const;
+    JsonValue get(const std::string&) const;
+    double getNumber(const std::string&, double) const;
+    std::string getString(const std::string&, std::string) const;
+    bool getBool(const std::string&, bool) const;
+
+    JsonObject& set(const std::string&, JsonValue);
+    //! Sets a member to a JSON array of numbers.
+    JsonObject& setArray(const std::string&, const std::vector<double>&);
+    std::string dump() const;
+
+private:
+    // serialized members, in insertion order, and the parsed scalar values for lookup
+    std::vector< std::pair<std::string, std::string> > fields;
+    std::map<std::string, JsonValue> values;
+
+    void setField(const std::string&, const std::string&);
+};
+
+std::string json_quote(const std::string&);
+std::string json_number(double);
+
+#endif
@@ -0,0 +1,279 @@
+#include "Server.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <Schroedinger.h>
+
+namespace {
+    // largest grid a request may ask for: 10^7 points are 80 MB per array
+    const double max_nbox = 1e7;
+}
+
+Server::Server(std::string cacheDirectory, std::size_t capacity)
+    : capacity(capacity > 0 ? capacity : 1), solutions(capacity, cacheDirectory) {}
+
+std::string Server::handle(const std::string& line, CancelToken token) {
+    JsonObject answer;
+    answer.set("id", JsonValue());
+
+    try {
+        JsonObject request = JsonObject::parse(line);
+        if (request.has("id"))
+            answer.set("id", request.get("id"));
+
+        std::string cmd = request.getString("cmd", "solve");
+        if (cmd == "solve")
+            solve(request, answer, token);
+        else if (cmd == "stats")
+            stats(answer);
+        else
+            throw std::invalid_argument("Unknown command \"" + cmd + "\".");
+    }
+    catch (const std::exception& e) {
+        answer.set("status", "error").set("message", std::string(e.what()));
+    }
+
+    return answer.dump();
+}
+
+void Server::solve(const JsonObject& request, JsonObject& answer, const CancelToken& token) {
+    double mesh = request.getNumber("mesh", dx);
+    double nbox_requested = request.getNumber("nbox", 1000.);
+    double Emin = request.getNumber("emin", 0.);
+    double Emax = request.getNumber("emax", 2.);
+    double Estep = request.getNumber("estep", 0.01);
+
+    if (nbox_requested < 3 || nbox_requested > max_nbox || nbox_requested != std::floor(nbox_requested))
+        throw std::invalid_argument("nbox must be an integer greater than 2 and at most " + json_number(max_nbox) + ".");
+    if (Estep <= 0 || Emax <= Emin)
+        throw std::invalid_argument("Energy bracket must satisfy emin < emax and estep > 0.");
+    if (mesh <= 0)
+        throw std::invalid_argument("mesh must be positive.");
+
+    // every request is solved on its own grid, concurrently with the other connections
+    SolverConfig config;
+    config.setMesh(mesh);
+    if (request.has("tolerance"))
+        config.setTolerance(request.getNumber("tolerance", 0.));
+
+    Spectrum::Engine engine = Spectrum::engine(request.getString("engine", "numerov"));
+    if (engine != Spectrum::Numerov) {
+        spectrum(request, answer, engine, config, (int) nbox_requested);
+        return;
+    }
+
+    SolveControl control;
+    control.setToken(token);
+    if (request.has("timeout")) {
+        // a year at most, so that the deadline fits in a steady_clock time point
+        double timeout = request.getNumber("timeout", 0.);
+        if (!(timeout >= 0) || timeout > 3.2e7)
+            throw std::invalid_argument("timeout must be between 0 and 3.2e7 seconds.");
+        control.setTimeout(timeout);
+    }
+    if (request.has("max_sweeps")) {
+        double sweeps = request.getNumber("max_sweeps", 0.);
+        // (double) LONG_MAX rounds up to 2^63, which does not fit in a long
+        if (sweeps < 0 || sweeps >= (double) std::numeric_limits<long>::max() || sweeps != std::floor(sweeps))
+            throw std::invalid_argument("max_sweeps must be a non negative integer that fits in a long.");
+        control.setSweepBudget((long) sweeps);
+    }
+
+    int nbox = (int) nbox_requested;
+    ContinuousBase base;
+    Potential V = cachedPotential(request, base, mesh, nbox);
+
+    // nbox + 1 values from the starting values of solve_Numerov, the buffer recycled by the WavefunctionPool
+    Wavefunction wavefunction(base);
+
+    SolveResult result = cached_solve_Numerov(this->solutions, Emin, Emax, Estep, base, V, wavefunction.data(), control,
+                                              config);
+
+    if (result.converged()) {
+        answer.set("status", "ok").set("energy", result.energy);
+        if (request.getBool("wavefunction", false))
+            answer.setArray("wavefunction", std::vector<double>(wavefunction.begin(), wavefunction.end()));
+    }
+    else {
+        answer.set("status", SolveResult::describe(result.status))
+              .set("energy", result.energy)
+              .set("emin", result.Emin)
+              .set("emax", result.Emax)
+              .set("bracketed", result.bracketed);
+    }
+    answer.set("sweeps", (double) result.sweeps);
+}
+
+void Server::spectrum(const JsonObject& request, JsonObject& answer, Spectrum::Engine engine, const SolverConfig& config,
+                      int nbox) {
+    double level = request.getNumber("level", 0.);
+    if (level < 0 || level >= nbox || level != std::floor(level))
+        throw std::invalid_argument("level must be a non negative integer below nbox.");
+
+    ContinuousBase base;
+    Potential V = cachedPotential(request, base, config.getMesh(), nbox);
+    bool wavefunction = request.getBool("wavefunction", false);
+    Spectrum s = solve_spectrum(engine, (int) level + 1, base, V, wavefunction, config);
+
+    answer.set("status", "ok").set("energy", s.energies.back());
+    if (wavefunction)
+        answer.setArray("wavefunction", s.wavefunctions.back());
+    answer.set("sweeps", 0.);
+}
+
+void Server::stats(JsonObject& answer) {
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+    answer.set("status", "ok")
+          .set("solves", (double) this->solves)
+          .set("bases", (double) this->bases.entries.size())
+          .set("base_hits", (double) this->baseHits)
+          .set("base_evictions", (double) this->bases.evictions)
+          .set("potentials", (double) this->potentials.entries.size())
+          .set("potential_hits", (double) this->potentialHits)
+          .set("potential_evictions", (double) this->potentials.evictions)
+          .set("solution_hits", (double) this->solutions.getHits())
+          .set("solution_misses", (double) this->solutions.getMisses());
+}
+
+Potential Server::cachedPotential(const JsonObject& request, ContinuousBase& base, double mesh, int nbox) {
+    std::string type = request.getString("potential", "box");
+    double k = request.getNumber("k", 0.5);
+    double width = request.getNumber("width", 5.0);
+    double height = request.getNumber("height", 10.0);
+
+    std::string baseKey = json_number(mesh) + "/" + std::to_string(nbox);
+    std::string potentialKey = type + "/" + json_number(k) + "/" + json_number(width) + "/"
+                               + json_number(height) + "@" + baseKey;
+
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+    this->solves++;
+
+    ContinuousBase *cachedBase = this->bases.find(baseKey);
+    if (cachedBase)
+        this->baseHits++;
+    else
+        cachedBase = &this->bases.insert(baseKey, ContinuousBase(mesh, (unsigned int) nbox), this->capacity);
+    base = *cachedBase;
+
+    if (Potential *cached = this->potentials.find(potentialKey)) {
+        this->potentialHits++;
+        return *cached;
+    }
+
+    Potential V = Potential::Builder(base.getCoords())
+            .setType(type)
+            .setK(k)
+            .setWidth(width)
+            .setHeight(height)
+            .build();
+    this->potentials.insert(potentialKey, V, this->capacity);
+    return V;
+}
+
+void Server::serve(std::istream& in, std::ostream& out) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        out << handle(line) << std::endl;
+    }
+}
+
+void Server::serveSocket(const std::string& path) {
+    sockaddr_un address;
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::invalid_argument("Socket path too long: " + path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw std::runtime_error(std::string("Cannot create socket: ") + std::strerror(errno));
+
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+
+    if (bind(listener, (sockaddr*) &address, sizeof(address)) < 0 || listen(listener, 16) < 0) {
+        std::string reason = std::strerror(errno);
+        close(listener);
+        throw std::runtime_error("Cannot listen on " + path + ": " + reason);
+    }
+
+    std::cerr << "# listening on " << path << std::endl;
+    while (true) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        std::thread(&Server::serveConnection, this, fd).detach();
+    }
+    close(listener);
+}
+
+void Server::serveConnection(int fd) {
+    std::string pending;
+    char chunk[4096];
+
+    // one token for the connection: when the peer hangs up, the solve in progress and the
+    // requests still pending are abandoned
+    CancelToken token;
+    std::atomic<bool> closing(false);
+    std::thread watcher([&]() {
+        pollfd hangup = {fd, 0, 0};
+        while (!closing) {
+            if (poll(&hangup, 1, 20) > 0 && (hangup.revents & (POLLHUP | POLLERR))) {
+                token.cancel();
+                break;
+            }
+        }
+    });
+    auto finish = [&]() {
+        closing = true;
+        watcher.join();
+        close(fd);
+    };
+
+    while (true) {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            break;
+        pending.append(chunk, received);
+
+        std::string::size_type newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+
+            std::string answer = handle(line, token) + "\n";
+            std::string::size_type sent = 0;
+            while (sent < answer.size()) {
+                ssize_t n = send(fd, answer.data() + sent, answer.size() - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    finish();
+                    return;
+                }
+                sent += n;
+            }
+        }
+    }
+    finish();
+}
@@ -0,0 +1,103 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <EigenCache.h>
+#include <Potential.h>
+#include <Spectrum.h>
+#include "Json.h"
+
+/*! Server keeps the solver alive between requests, so that a pipeline doing many small solves
+ * pays process startup and basis/potential construction only once.
+ *
+ * The protocol is line-delimited JSON: every input line is one flat object, every output line is
+ * the answer to the corresponding request. Recognized members of a request:
+ * - "cmd": "solve" (default) or "stats"
+ * - "id": any scalar, echoed back in the answer
+ * - "potential": potential type, as accepted by Potential::Builder::setType (default "box")
+ * - "k", "width", "height": potential parameters (defaults of Potential::Builder)
+ * - "mesh", "nbox": grid of the ContinuousBase (defaults dx, 1000, at most 10^7 points), any mesh for every engine
+ * - "tolerance": tolerance of the Numerov scan and bisection (default that of SolverConfig, 1e-10)
+ * - "emin", "emax", "estep": energy bracket scanned by solve_Numerov (defaults 0, 2, 0.01)
+ * - "wavefunction": if true the normalized wavefunction is returned as an array
+ * - "timeout": seconds the solve may take, "max_sweeps": Numerov sweeps it may spend (unbounded by default)
+ * - "engine": "numerov" (default), "fd6" or "dvr" (see Spectrum); the last two answer the energy of
+ *   "level" (default 0) on any mesh, without energy window, timeout or memoization
+ *
+ * A solve that does not converge is answered with the SolveResult status ("not found", "timeout",
+ * "budget exhausted", "cancelled", ...) instead of "ok", with the bracket reached ("emin", "emax") and
+ * the sweeps spent. On a socket, the requests of a connection are cancelled as soon as the peer hangs up.
+ *
+ * Bases and potentials are cached and reused by later requests, wavefunction buffers are recycled by the
+ * WavefunctionPool, solutions are memoized in an EigenCache (persisted in cacheDirectory, if given). Each of
+ * the three caches keeps at most capacity entries, evicting the least recently used one, so that a long running
+ * server answering a parameter sweep stays bounded; "stats" reports the evictions.
+ * Errors never stop the server: they are answered with "status": "error" and a "message".
+ */
+class Server {
+public:
+    explicit Server(std::string cacheDirectory = "", std::size_t capacity = 1024);
+
+    //! Answers a single request line; thread safe. Cancelling token abandons its solve.
+    std::string handle(const std::string& line, CancelToken token = CancelToken());
+    //! Answers requests from in, one per line, until end of input.
+    void serve(std::istream& in, std::ostream& out);
+    //! Listens on a Unix domain socket at path, every connection is served by its own thread.
+    void serveSocket(const std::string& path);
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+private:
+    //! At most capacity values by key, the least recently used evicted first (as in EigenCache)
+    template<typename Value>
+    struct Lru {
+        std::list< std::pair<std::string, Value> > entries;  // most recently used first
+        std::map<std::string, typename std::list< std::pair<std::string, Value> >::iterator> index;
+        unsigned long evictions = 0;
+
+        Value* find(const std::string& key) {
+            auto it = index.find(key);
+            if (it == index.end())
+                return nullptr;
+            entries.splice(entries.begin(), entries, it->second);
+            return &it->second->second;
+        }
+        Value& insert(const std::string& key, Value value, std::size_t capacity) {
+            entries.emplace_front(key, std::move(value));
+            index[key] = entries.begin();
+            while (entries.size() > capacity) {
+                index.erase(entries.back().first);
+                entries.pop_back();
+                evictions++;
+            }
+            return entries.front().second;
+        }
+    };
+
+    std::mutex cacheMutex;
+    std::size_t capacity;
+    EigenCache solutions;
+    Lru<ContinuousBase> bases;
+    Lru<Potential> potentials;
+
+    unsigned long solves        = 0;
+    unsigned long baseHits      = 0;
+    unsigned long potentialHits = 0;
+
+    void solve(const JsonObject& request, JsonObject& answer, const CancelToken& token);
+    void spectrum(const JsonObject& request, JsonObject& answer, Spectrum::Engine engine, const SolverConfig& config,
+                  int nbox);
+    void stats(JsonObject& answer);
+    Potential cachedPotential(const JsonObject& request, ContinuousBase& base, double mesh, int nbox);
+    void serveConnection(int fd);
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "Analytic.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "Schroedinger.h"
+
+namespace {
+    // points per block: a few rows of a block stay in L1 while the recurrence runs through the levels
+    const std::size_t block = 512;
+
+    /*! Runs kernel(first, last) on the blocks of [0, points), shared among the hardware threads;
+    small grids stay on the calling thread.
+    */
+    template<typename Kernel>
+    void for_blocks(std::size_t points, std::size_t work, Kernel kernel) {
+        std::size_t nblocks = (points + block - 1) / block;
+        std::atomic<std::size_t> next(0);
+        auto worker = [&]() {
+            for (std::size_t b = next++; b < nblocks; b = next++)
+                kernel(b * block, std::min(points, (b + 1) * block));
+        };
+
+        unsigned threads = (work < (1u << 18)) ? 1u : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < std::min<std::size_t>(threads, nblocks); t++)
+            pool.emplace_back(worker);
+        worker();
+        for (auto &t : pool)
+            t.join();
+    }
+
+    /*! Fills the levels of s from level 0 (first) with psi_{n+1} = alpha(n) t psi_n - beta(n) psi_{n-1},
+    psi_{-1} = 0. Row by row over a block, so that the inner loop is a contiguous, vectorizable axpy.
+    */
+    template<typename First, typename Alpha, typename Beta>
+    void recurrence(AnalyticStates &s, int levels, const std::vector<double> &t, First first, Alpha alpha, Beta beta) {
+        const std::size_t P = s.points;
+        s.values.assign((std::size_t) levels * P, 0.);
+        double *out = s.values.data();
+        const double *tt = t.data();
+
+        for_blocks(P, (std::size_t) levels * P, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; i++)
+                out[i] = first(i);
+            for (int n = 0; n + 1 < levels; n++) {
+                const double a = alpha(n), b = beta(n);
+                const double *psi = out + n * P;
+                const double *previous = (n > 0) ? psi - P : nullptr;
+                double *next = out + (n + 1) * P;
+                if (previous) {
+                    for (std::size_t i = lo; i < hi; i++)
+                        next[i] = a * tt[i] * psi[i] - b * previous[i];
+                }
+                else {
+                    for (std::size_t i = lo; i < hi; i++)
+                        next[i] = a * tt[i] * psi[i];
+                }
+            }
+        });
+    }
+
+    bool is_type(const std::string &type, const char *name, const char *alias, const char *number) {
+        return type == name || type == alias || type == number;
+    }
+}
+
+AnalyticStates harmonic_states(int levels, const std::vector<double> &x, double omega, bool values,
+                               const SolverConfig &config) {
+    const double hbar = config.getHbar(), mass = config.getMass();
+    AnalyticStates s;
+    s.points = x.size();
+    for (int n = 0; n < levels; n++)
+        s.energies.push_back(hbar * omega * (n + 0.5));
+    if (!values || levels < 1)
+        return s;
+
+    const double c = std::sqrt(mass * omega / hbar);
+    const double psi0 = std::sqrt(c / std::sqrt(pi));
+    std::vector<double> xi(x.size());
+    for (std::size_t i = 0; i < x.size(); i++)
+        xi[i] = c * x[i];
+
+    auto alpha = [](int n) { return std::sqrt(2. / (n + 1)); };
+    auto beta = [](int n) { return std::sqrt((double) n / (n + 1)); };
+    recurrence(s, levels, xi, [&](std::size_t i) { return psi0 * std::exp(-xi[i] * xi[i] / 2.); }, alpha, beta);
+
+    /* Past |xi| ~ 35 exp(-xi^2 / 2) is below 1e-261, and 0 past 38.6, while the levels whose turning point
+    sqrt(2 n + 1) lies further are of order one there. At those points the recurrence runs on a mantissa, the
+    exponent kept aside as a logarithm, the mantissa rescaled before it overflows. */
+    const double far = 2. * 600., rescale = 1e200, log_rescale = std::log(rescale);
+    for (std::size_t i = 0; i < x.size(); i++) {
+        if (xi[i] * xi[i] < far)
+            continue;
+        double exponent = -xi[i] * xi[i] / 2., previous = 0., psi = psi0;
+        for (int n = 0; n + 1 < levels; n++) {
+            double next = alpha(n) * xi[i] * psi - beta(n) * previous;
+            previous = psi;
+            psi = next;
+            if (std::fabs(psi) > rescale) {
+                psi /= rescale;
+                previous /= rescale;
+                exponent += log_rescale;
+            }
+            double magnitude = (psi == 0.) ? 0. : std::exp(exponent + std::log(std::fabs(psi)));
+            s.values[(n + 1) * s.points + i] = std::copysign(magnitude, psi);
+        }
+    }
+    return s;
+}
+
+AnalyticStates box_states(int levels, const std::vector<double> &x, double start, double length, bool values,
+                          const SolverConfig &config) {
+    const double hbar = config.getHbar(), mass = config.getMass();
+    AnalyticStates s;
+    s.points = x.size();
+    for (int n = 0; n < levels; n++)
+        s.energies.push_back((n + 1) * (n + 1) * pi * pi * hbar * hbar / 2. / mass / length / length);
+    if (!values || levels < 1)
+        return s;
+
+    // sin((n + 1) theta) from sin(theta) with the Chebyshev recurrence; zero outside the walls
+    const double norm = std::sqrt(2. / length);
+    std::vector<double> cosine(x.size()), sine(x.size());
+    for (std::size_t i = 0; i < x.size(); i++) {
+        double theta = pi * (x[i] - start) / length;
+        bool inside = theta >= 0. && theta <= pi;
+        cosine[i] = inside ? std::cos(theta) : 0.;
+        sine[i] = inside ? norm * std::sin(theta) : 0.;
+    }
+
+    recurrence(s, levels, cosine,
+               [&](std::size_t i) { return sine[i]; },
+               [](int) { return 2.; },
+               [](int) { return 1.; });
+    return s;
+}
+
+double finite_well_energy(int n, double width, double height, const SolverConfig &config) {
+    const double hbar = config.getHbar(), mass = config.getMass();
+    double xi = width / 2. * std::sqrt(2. * mass * height) / hbar;
+    double lo = n * pi / 2., hi = std::min((n + 1) * pi / 2., xi);
+    if (lo >= xi)
+        return NAN;
+
+    auto f = [&](double eta) {
+        double lhs = (n % 2 == 0) ? eta * std::tan(eta) : -eta / std::tan(eta);
+        return lhs - std::sqrt(xi * xi - eta * eta);
+    };
+    for (int i = 0; i < 200; i++) {
+        double middle = (lo + hi) / 2.;
+        if (f(middle) < 0.)
+            lo = middle;
+        else
+            hi = middle;
+    }
+    double eta = (lo + hi) / 2.;
+    return 2. * hbar * hbar * eta * eta / width / width / mass;
+}
+
+AnalyticStates finite_well_states(int levels, const std::vector<double> &x, double width, double height, bool values,
+                                  const SolverConfig &config) {
+    const double hbar = config.getHbar(), mass = config.getMass();
+    AnalyticStates s;
+    s.points = x.size();
+    for (int n = 0; n < levels; n++)
+        s.energies.push_back(finite_well_energy(n, width, height, config));
+    if (!values || levels < 1)
+        return s;
+
+    const std::size_t P = s.points;
+    s.values.assign((std::size_t) levels * P, 0.);
+    const double half = width / 2.;
+    for (int n = 0; n < levels && !std::isnan(s.energies[n]); n++) {
+        const double k = std::sqrt(2. * mass * s.energies[n]) / hbar;
+        const double kappa = std::sqrt(2. * mass * (height - s.energies[n])) / hbar;
+        const bool even = (n % 2 == 0);
+        // inside cos(k x) or sin(k x), outside the value at the edge decaying as exp(-kappa (|x| - w/2))
+        const double edge = even ? std::cos(k * half) : std::sin(k * half);
+        const double integral = half + (even ? 1. : -1.) * std::sin(2. * k * half) / (2. * k) + edge * edge / kappa;
+        const double norm = 1. / std::sqrt(integral);
+        const double *xx = x.data();
+        double *out = s.values.data() + n * P;
+
+        for_blocks(P, P, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; i++) {
+                double a = std::fabs(xx[i]);
+                double sign = (even || xx[i] >= 0.) ? 1. : -1.;
+                out[i] = norm * ((a < half) ? (even ? std::cos(k * xx[i]) : std::sin(k * xx[i]))
+                                            : sign * edge * std::exp(-kappa * (a - half)));
+            }
+        });
+    }
+    return s;
+}
+
+AnalyticStates analytic_states(int levels, ContinuousBase base, const Potential &V, bool values,
+                               const SolverConfig &config) {
+    int nbox = (int) base.getNbox();
+    std::vector<double> x(nbox + 1);
+    for (int i = 0; i <= nbox; i++)
+        x[i] = base.getStart() + base.getMesh() * i;
+
+    const std::string type = V.getType();
+    if (is_type(type, "box", "box potential", "0"))
+        return box_states(levels, x, x[0], nbox * base.getMesh(), values, config);
+    if (is_type(type, "harmonic oscillator", "ho", "1"))
+        return harmonic_states(levels, x, std::sqrt(2. * V.getK() / config.getMass()), values, config);
+    if (is_type(type, "finite well potential", "well", "2"))
+        return finite_well_states(levels, x, V.getWidth(), V.getHeight(), values, config);
+
+    AnalyticStates s;
+    s.points = x.size();
+    s.energies.assign(std::max(levels, 0), NAN);
+    return s;
+}
@@ -0,0 +1,61 @@
+#ifndef ANALYTIC_H
+#define ANALYTIC_H
+
+#include <cstddef>
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! Analytic eigenstates of the built-in potentials, for many levels at once on a grid: references for the
+ * validation of the solvers and warm starts (energies to bracket around) for the iterative ones.
+ *
+ * The oscillator and the box are evaluated level after level with three-term recurrences, never with
+ * factorials or powers: the normalized Hermite functions
+ *   psi_{n+1} = sqrt(2 / (n + 1)) xi psi_n - sqrt(n / (n + 1)) psi_{n-1},   xi = sqrt(m omega / hbar) x,
+ * stay of order one for any n, and sin((n + 1) theta) follows the Chebyshev recurrence. Only the start
+ * psi_0 ~ exp(-xi^2 / 2) underflows (to 0 past |xi| ~ 38.6, inside the turning points of the levels above
+ * n ~ 750): past |xi| ~ 35 the recurrence carries the exponent aside, as a logarithm. The inner loops run over
+ * contiguous grid points, so they vectorize; blocks of points are shared among threads. The finite well levels
+ * are bound states of the well on the whole line (no walls). Units are those of config, SolverConfig::current()
+ * if it is left out.
+ *
+ * Signs are the textbook ones: Hermite functions positive for large x, sin for the box, cos (even levels) and
+ * sin (odd levels) inside the finite well.
+ *
+ * AnalyticStates ho = harmonic_states(200, x, 1.);
+ * const double *psi = ho.level(199);
+ */
+struct AnalyticStates {
+    std::vector<double> energies;   // one per level, ascending; NAN for levels the potential does not bind
+    std::vector<double> values;     // level after level: values[n * points + i] is level n at x[i]; empty if not asked for
+    std::size_t points = 0;
+
+    const double* level(int n) const { return values.data() + n * points; }
+};
+
+//! Oscillator V = m omega^2 x^2 / 2
+AnalyticStates harmonic_states(int levels, const std::vector<double> &x, double omega, bool values = true,
+                               const SolverConfig &config = SolverConfig::current());
+//! Hard walls at start and start + length
+AnalyticStates box_states(int levels, const std::vector<double> &x, double start, double length, bool values = true,
+                          const SolverConfig &config = SolverConfig::current());
+//! Finite well: zero between -width / 2 and width / 2, height outside
+AnalyticStates finite_well_states(int levels, const std::vector<double> &x, double width, double height,
+                                  bool values = true, const SolverConfig &config = SolverConfig::current());
+
+/*! Energy of the n-th bound level (n = 0 is the ground state) of the finite well, NAN if it is not bound.
+ * With eta = w/2 sqrt(2 m E) / hbar and xi = w/2 sqrt(2 m V0) / hbar, the levels solve
+ * eta tan(eta) = sqrt(xi^2 - eta^2) (even) or -eta cot(eta) = sqrt(xi^2 - eta^2) (odd), with eta in (n pi/2, (n+1) pi/2).
+ */
+double finite_well_energy(int n, double width, double height, const SolverConfig &config = SolverConfig::current());
+
+/*! The states of a built-in Potential (box, harmonic oscillator, finite well) on the nbox + 1 points of the
+ * wavefunctions of base (walls included), the box being the grid itself. Other potentials (e.g. "custom")
+ * get NAN energies and no values.
+ */
+AnalyticStates analytic_states(int levels, ContinuousBase base, const Potential &V, bool values = true,
+                               const SolverConfig &config = SolverConfig::current());
+
+#endif
@@ -0,0 +1,215 @@
+#include "BandStructure.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "Bracketing.h"
+#include "Schroedinger.h"
+
+BandStructure::BandStructure(ContinuousBase cell, const Potential &V, int nbands, int threads,
+                             const SolverConfig &config)
+    : config(SolverConfig(config).setMesh(cell.getMesh()))
+{
+    if (cell.getBoundary() != ContinuousBase::Periodic)
+        throw std::invalid_argument("BandStructure needs a unit cell with the Periodic boundary.");
+    if (nbands < 1)
+        throw std::invalid_argument("BandStructure needs at least one band.");
+
+    this->nbox    = (int) cell.getNbox();
+    this->nbands  = nbands;
+    this->threads = std::max(1, threads);
+    this->period  = this->nbox * this->config.getMesh();
+
+    const std::vector<double> &values = V.getValues();
+    if (this->nbox < 3 || (int) values.size() < this->nbox)
+        throw std::invalid_argument("BandStructure: the potential does not cover the unit cell.");
+
+    this->potential.assign(values.begin(), values.begin() + nbox);
+    this->potential.push_back(values[0]);
+    this->potential.push_back(values[1]);
+
+    // hard wall levels of the cell: the n-th band is between the (n-1)-th and the n-th of them
+    std::vector<double> wavefunction(nbox + 1);
+    wavefunction[0] = 0.;
+    wavefunction[1] = 0.01;
+    for (int n = 0; n < nbands; n++) {
+        EnergyBracket b = bracket_Numerov(n, nbox, V, wavefunction.data(), NAN, NAN, this->config);
+        this->dirichlet.push_back(refine_Numer(b.Emin, b.Emax, nbox, V, wavefunction.data(), nullptr, this->config));
+    }
+}
+
+/*! The two solutions start from (psi_0, psi_1) = (1, 0) and (0, 1) and are advanced together to
+(psi_nbox, psi_{nbox+1}): the columns of the monodromy matrix, whose trace is u_nbox + w_{nbox+1}.
+*/
+double BandStructure::blochTrace(double Energy) const
+{
+    const double c = this->config.numerovFactor();
+    const double *v = this->potential.data();
+
+    double u0 = 1., u1 = 0., w0 = 0., w1 = 1.;
+    double a_prev = 1. + c * (Energy - v[0]), a = 1. + c * (Energy - v[1]);
+    for (int i = 1; i <= nbox; i++) {
+        double a_next = 1. + c * (Energy - v[i + 1]);
+        double b = 12. - 10. * a;   // 2 (1 - 5 c (E - v_i))
+        double u2 = (b * u1 - a_prev * u0) / a_next;
+        double w2 = (b * w1 - a_prev * w0) / a_next;
+        u0 = u1; u1 = u2;
+        w0 = w1; w1 = w2;
+        a_prev = a; a = a_next;
+    }
+    return (u0 + w1) / 2.;
+}
+
+/*! Root of D(E) = target for band n. D decreases across the even bands and increases across the odd ones,
+so g = +-(D - target) is >= 0 at the bottom of the interval and <= 0 at its top.
+With a guess, the bracket is searched outwards from it in steps doubling from step, otherwise it is the
+whole interval. The bracket is then refined with the Illinois regula falsi, as in refine_Numer.
+*/
+double BandStructure::root(int n, double target, double guess, double step, long &evaluations) const
+{
+    const double sign = (n % 2 == 0) ? 1. : -1.;
+    auto g = [&](double E) { evaluations++; return sign * (blochTrace(E) - target); };
+
+    double lo = (n == 0) ? *std::min_element(potential.begin(), potential.end()) - 1. : dirichlet[n - 1];
+    double hi = dirichlet[n];
+    double a, b, ga, gb;
+
+    if (!std::isnan(guess) && guess > lo && guess < hi) {
+        step = std::max(std::fabs(step), 1e-9 * (hi - lo));
+        double E = guess, gE = g(E);
+        if (gE == 0.)
+            return E;
+        if (gE > 0.) {
+            a = E; ga = gE;
+            for (;; step *= 2) {
+                b = std::min(hi, a + step);
+                gb = g(b);
+                if (gb <= 0. || b >= hi)
+                    break;
+                a = b; ga = gb;
+            }
+        }
+        else {
+            b = E; gb = gE;
+            for (;; step *= 2) {
+                a = std::max(lo, b - step);
+                ga = g(a);
+                if (ga >= 0. || a <= lo)
+                    break;
+                b = a; gb = ga;
+            }
+        }
+    }
+    else {
+        a = lo; ga = g(a);
+        b = hi; gb = g(b);
+    }
+
+    if (ga == 0.)
+        return a;
+    if (gb == 0.)
+        return b;
+    // a closed gap: the band touches the end of the interval and D - target only grazes zero there
+    if (ga < 0. || gb > 0.)
+        return (std::fabs(ga) < std::fabs(gb)) ? a : b;
+
+    double Energy = b;
+    for (int i = 0; i < config.getMaxIterations()
+                    && std::fabs(b - a) > config.getTolerance() * std::max(1., std::fabs(b)); i++) {
+        Energy = (a * gb - b * ga) / (gb - ga);
+        if (!(Energy > std::min(a, b) && Energy < std::max(a, b)))
+            Energy = (a + b) / 2.;
+
+        double gE = g(Energy);
+        if (gE == 0.)
+            break;
+        if (gE * gb < 0.) {
+            a = b;
+            ga = gb;
+        }
+        else {
+            ga /= 2.;
+        }
+        b = Energy;
+        gb = gE;
+    }
+    return Energy;
+}
+
+std::vector<double> BandStructure::solve(double k) const
+{
+    long evaluations = 0;
+    std::vector<double> energies(nbands);
+    for (int n = 0; n < nbands; n++)
+        energies[n] = root(n, std::cos(k * period), NAN, NAN, evaluations);
+    return energies;
+}
+
+BandStructure::Result BandStructure::compute(int nk) const
+{
+    if (nk < 2)
+        throw std::invalid_argument("BandStructure: the k-grid needs at least two points.");
+
+    Result result;
+    result.k.resize(nk);
+    result.energies.assign(nk, std::vector<double>(nbands));
+    for (int j = 0; j < nk; j++)
+        result.k[j] = j * pi / period / (nk - 1);
+
+    int nblocks = std::min(this->threads, nk);
+    std::vector<long> evaluations(nblocks, 0);
+
+    auto block = [&](int t) {
+        int first = (int) ((long) t * nk / nblocks), last = (int) ((long) (t + 1) * nk / nblocks);
+        for (int j = first; j < last; j++) {
+            double target = std::cos(result.k[j] * period);
+            for (int n = 0; n < nbands; n++) {
+                double guess = NAN, step = NAN;
+                if (j > first) {
+                    // linear extrapolation along the band from the previous two momenta
+                    double previous = result.energies[j - 1][n];
+                    double change = (j > first + 1) ? previous - result.energies[j - 2][n] : 0.;
+                    guess = previous + change;
+                    step = (change != 0.) ? change : 1e-3 * (dirichlet[n] - previous);
+                }
+                result.energies[j][n] = root(n, target, guess, step, evaluations[t]);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < nblocks; t++)
+        pool.emplace_back(block, t);
+    block(0);
+    for (auto &t : pool)
+        t.join();
+
+    result.evaluations = 0;
+    for (long e : evaluations)
+        result.evaluations += e;
+    return result;
+}
+
+void BandStructure::write(std::ostream &out, const Result &result)
+{
+    out << "# k  E_0 .. E_" << (result.energies.empty() ? 0 : (int) result.energies[0].size() - 1) << std::endl;
+    std::streamsize precision = out.precision(12);
+    for (std::vector<double>::size_type j = 0; j < result.k.size(); j++) {
+        out << result.k[j];
+        for (double E : result.energies[j])
+            out << "  " << E;
+        out << std::endl;
+    }
+    out.precision(precision);
+}
+
+double BandStructure::getPeriod() const
+{
+    return this->period;
+}
+
+const std::vector<double>& BandStructure::getDirichletLevels() const
+{
+    return this->dirichlet;
+}
@@ -0,0 +1,61 @@
+#ifndef BANDSTRUCTURE_H
+#define BANDSTRUCTURE_H
+
+#include <iostream>
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! BandStructure computes the Bloch bands of a periodic potential from one unit cell.
+ *
+ * The cell is a ContinuousBase with the Periodic boundary: its nbox points x_0 .. x_{nbox-1} repeat with
+ * period a = nbox * mesh, and so do the values of the Potential on it. Bloch states obey
+ * psi_{i + nbox} = exp(i k a) psi_i. The Numerov recurrence maps (psi_{i-1}, psi_i) to (psi_i, psi_{i+1})
+ * by a 2x2 matrix whose product over one period, the monodromy M(E), has determinant 1, so that
+ *   D(E) = tr M(E) / 2 = cos(k a)
+ * gives the bands. D(E) is evaluated with two Numerov solutions over one cell (one fused sweep, O(1)
+ * memory): no eigenvector storage and no complex arithmetic for any k.
+ *
+ * The n-th band lies between the (n-1)-th and the n-th level of the cell with hard walls (found once with
+ * the node counting of bracket_Numerov), and D(E) is monotonic on it: for each k there is exactly one root
+ * in that interval. Along the k-grid every band is followed from the previous k, so the root is usually
+ * bracketed with two evaluations of D and refined in a few more. The k-grid is split in contiguous blocks
+ * run on worker threads; each block starts cold from the hard wall levels. Any mesh: the cell is solved
+ * with the SolverConfig given at construction (the current one by default), on the mesh of the cell.
+ */
+class BandStructure {
+public:
+    struct Result {
+        std::vector<double> k;                        // crystal momenta on [0, pi / a]
+        std::vector< std::vector<double> > energies;  // energies[j][n]: band n at k[j]
+        long evaluations;                             // evaluations of D(E), two Numerov solutions each
+    };
+
+    BandStructure(ContinuousBase cell, const Potential &V, int nbands, int threads = 1,
+                  const SolverConfig &config = SolverConfig::current());
+
+    //! D(E) = tr M(E) / 2; |D| <= 1 inside the bands
+    double blochTrace(double Energy) const;
+    //! Energies of the bands at crystal momentum k, solved from scratch
+    std::vector<double> solve(double k) const;
+    //! Bands on nk evenly spaced momenta from 0 to pi / a
+    Result compute(int nk) const;
+    //! Writes one line per k: k and the band energies
+    static void write(std::ostream &out, const Result &result);
+
+    double getPeriod() const;
+    const std::vector<double>& getDirichletLevels() const;
+
+private:
+    SolverConfig config;
+    int nbox, nbands, threads;
+    double period;
+    std::vector<double> potential;   // nbox + 2 values, the first two repeated at the end
+    std::vector<double> dirichlet;   // nbands hard wall levels of the cell
+
+    double root(int n, double target, double guess, double step, long &evaluations) const;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "Bracketing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Schroedinger.h"
+
+/*! Sign changes of wavefunction[1..nbox]; zeros keep the previous sign.
+For the three-term Numerov recurrence this is a Sturm sequence, so the count equals the number of
+eigenvalues of the discretized problem below Energy. The sweep is energy only (shoot_Numerov).
+*/
+template<typename Real>
+int count_nodes_Numerov(Real Energy, int nbox, const Real *potential, Real *wavefunction, const SolverConfig &config) {
+    int nodes = 0;
+    shoot_Numerov<Real>(Energy, nbox, nbox, potential, wavefunction[0], wavefunction[1], &nodes, nullptr, config);
+    return nodes;
+}
+
+namespace {
+    // Phase integral \int p(x) dx over the classically allowed region, and its derivative in E.
+    void phase_integral(double Energy, const std::vector<double> &potential, double &I, double &dIdE,
+                        const SolverConfig &config) {
+        const double mass = config.getMass(), mesh = config.getMesh();
+        I = 0.;
+        dIdE = 0.;
+        for (double v : potential) {
+            if (Energy > v) {
+                double p = std::sqrt(2. * mass * (Energy - v));
+                I += p * mesh;
+                dIdE += mass / p * mesh;
+            }
+        }
+    }
+
+    // No level is above the same level of a box filled with the highest value of the potential
+    double upper_bound(int n, int nbox, const std::vector<double> &potential, const SolverConfig &config) {
+        double boxLength = nbox * config.getMesh();
+        double Vmax = *std::max_element(potential.begin(), potential.end());
+        return Vmax + (n + 1) * (n + 1) * pi * pi * config.kineticFactor() / boxLength / boxLength;
+    }
+}
+
+double wkb_Energy(int n, int nbox, const Potential &V, const SolverConfig &config) {
+    const std::vector<double> &potential = V.getValues();
+    double Emin = *std::min_element(potential.begin(), potential.end());
+    double Emax = upper_bound(n, nbox, potential, config);
+    double target = (n + 0.5) * pi * config.getHbar();
+    double I, dIdE;
+
+    // the phase integral is monotonic in E: a coarse bisection is enough for a starting point
+    for (int i = 0; i < 30; i++) {
+        double Emiddle = (Emin + Emax) / 2.;
+        phase_integral(Emiddle, potential, I, dIdE, config);
+        if (I < target)
+            Emin = Emiddle;
+        else
+            Emax = Emiddle;
+    }
+    return (Emin + Emax) / 2.;
+}
+
+double wkb_Spacing(double Energy, int nbox, const Potential &V, const SolverConfig &config) {
+    double I, dIdE;
+    phase_integral(Energy, V.getValues(), I, dIdE, config);
+    if (dIdE <= 0.)
+        return upper_bound(0, nbox, V.getValues(), config) - Energy;
+    return pi * config.getHbar() / dIdE;
+}
+
+EnergyBracket bracket_Numerov(int n, int nbox, const Potential &V, double *wavefunction,
+                              double guess, double delta, const SolverConfig &config) {
+    const double *potential = V.getValues().data();
+    return bracket_levels(n, n, nbox, V, [&](double Energy) {
+        return count_nodes_Numerov(Energy, nbox, potential, wavefunction, config);
+    }, guess, delta, config);
+}
+
+EnergyBracket bracket_levels(int index, int n, int nbox, const Potential &V, const std::function<int(double)> &count,
+                             double guess, double delta, const SolverConfig &config) {
+    const std::vector<double> &potential = V.getValues();
+    const double Vmin = *std::min_element(potential.begin(), potential.end());
+    // margin for the difference between the continuum bound and the discretized spectrum
+    double Vtop = upper_bound(n, nbox, potential, config);
+    Vtop += 0.1 * (Vtop - Vmin) + 1.;
+
+    double Eguess = std::isnan(guess) ? wkb_Energy(n, nbox, V, config) : guess;
+    Eguess = std::min(std::max(Eguess, Vmin), Vtop);
+    if (std::isnan(delta))
+        delta = 0.5 * wkb_Spacing(Eguess, nbox, V, config);
+    if (!(delta > 0.))
+        delta = 0.5 * (Vtop - Vmin) / (n + 1);
+
+    EnergyBracket b;
+    b.sweeps = 0;
+    b.Emin = std::max(Vmin, Eguess - delta);
+    b.Emax = std::min(Vtop, Eguess + delta);
+
+    int nodes_min = count(b.Emin);
+    b.sweeps++;
+    // E = min V has no nodes, so this ends at the latest at Vmin
+    for (double step = delta; nodes_min > index; step *= 2) {
+        b.Emax = b.Emin;
+        b.Emin = std::max(Vmin, b.Emin - step);
+        nodes_min = count(b.Emin);
+        b.sweeps++;
+    }
+
+    int nodes_max = count(b.Emax);
+    b.sweeps++;
+    for (double step = delta; nodes_max <= index; step *= 2) {
+        b.Emin = b.Emax;
+        nodes_min = nodes_max;
+        if (b.Emax >= Vtop)
+            Vtop += 2. * (Vtop - Vmin);
+        b.Emax = std::min(Vtop, b.Emax + step);
+        nodes_max = count(b.Emax);
+        b.sweeps++;
+    }
+
+    // bisection on the node count, until only the wanted level is left inside
+    while ((nodes_min != index || nodes_max != index + 1) && b.Emax - b.Emin > config.getTolerance()) {
+        double Emiddle = (b.Emin + b.Emax) / 2.;
+        int nodes = count(Emiddle);
+        b.sweeps++;
+        if (nodes <= index) {
+            b.Emin = Emiddle;
+            nodes_min = nodes;
+        }
+        else {
+            b.Emax = Emiddle;
+            nodes_max = nodes;
+        }
+    }
+    return b;
+}
+
+double refine_Numer(double Emin, double Emax, int nbox, const Potential &V, double *wavefunction, int *sweeps,
+                    const SolverConfig &config) {
+    const double *potential = V.getValues().data();
+    return refine_zero(Emin, Emax, [&](double Energy) {
+        return shoot_Numerov<double>(Energy, nbox, nbox, potential, wavefunction[0], wavefunction[1], nullptr, nullptr,
+                                     config);
+    }, sweeps, config);
+}
+
+double refine_zero(double Emin, double Emax, const std::function<double(double)> &shot, int *sweeps,
+                   const SolverConfig &config) {
+    int count = 0;
+
+    double fa = shot(Emin);
+    double fb = shot(Emax);
+    count += 2;
+
+    double Energy = (fa == 0) ? Emin : Emax;
+    if (fa * fb < 0.) {
+        // Illinois variant of regula falsi: when the same end is retained twice its value is halved,
+        // so the bracket [a, b] (in either order) shrinks from both sides and convergence is superlinear
+        double a = Emin, b = Emax;
+        for (int i = 0; i < config.getMaxIterations()
+                        && std::fabs(b - a) > config.getTolerance() * std::max(1., std::fabs(b)); i++) {
+            Energy = (a * fb - b * fa) / (fb - fa);
+            if (!(Energy > std::min(a, b) && Energy < std::max(a, b)))
+                Energy = (a + b) / 2.;
+
+            double f = shot(Energy);
+            count++;
+
+            if (f == 0.)
+                break;
+            if (f * fb < 0.) {
+                a = b;
+                fa = fb;
+            }
+            else {
+                fa /= 2.;
+            }
+            b = Energy;
+            fb = f;
+        }
+    }
+    else if (fa != 0. && fb != 0.) {
+        std::cerr << "ERROR: no sign change of the solution in refine_Numer [" << Emin << ", " << Emax << "]" << std::endl;
+    }
+
+    if (sweeps)
+        *sweeps += count;
+    return Energy;
+}
+
+double solve_Numerov_level(int n, int nbox, const Potential &V, double *wavefunction, double guess) {
+    return solve_Numerov_level(n, nbox, V, wavefunction, SolverConfig::current(), guess);
+}
+
+double solve_Numerov_level(int n, int nbox, const Potential &V, double *wavefunction, const SolverConfig &config,
+                           double guess) {
+    EnergyBracket b = bracket_Numerov(n, nbox, V, wavefunction, guess, NAN, config);
+    int sweeps = b.sweeps;
+    double Energy = refine_Numer(b.Emin, b.Emax, nbox, V, wavefunction, &sweeps, config);
+
+    fsol_Numerov<double>(Energy, nbox, V.getValues().data(), wavefunction, config);
+    sweeps++;
+
+    std::vector<double> probab(nbox + 1);
+    for (int i = 0; i <= nbox; i++)
+        probab[i] = wavefunction[i] * wavefunction[i];
+    double norm = trap_array(0, nbox, config.getMesh(), probab.data());
+    for (int i = 0; i <= nbox; i++)
+        wavefunction[i] = wavefunction[i] / sqrt(norm);
+
+    std::cout << "# level " << n << "  Energy = " << Energy << "  sweeps = " << sweeps << std::endl;
+    return Energy;
+}
+
+double solve_Numerov_level(int n, const Potential &V, Wavefunction &psi, double guess) {
+    return solve_Numerov_level(n, V, psi, SolverConfig::current(), guess);
+}
+
+double solve_Numerov_level(int n, const Potential &V, Wavefunction &psi, const SolverConfig &config, double guess) {
+    if ((int) V.getValues().size() < psi.getNbox())
+        throw std::invalid_argument("The potential holds fewer values than the wavefunction grid.");
+    return solve_Numerov_level(n, psi.getNbox(), V, psi.data(), SolverConfig(config).setMesh(psi.getMesh()), guess);
+}
+
+template int count_nodes_Numerov<float>(float, int, const float *, float *, const SolverConfig &);
+template int count_nodes_Numerov<double>(double, int, const double *, double *, const SolverConfig &);
+template int count_nodes_Numerov<long double>(long double, int, const long double *, long double *, const SolverConfig &);
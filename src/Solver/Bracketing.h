@@ -0,0 +1,73 @@
+#ifndef BRACKETING_H
+#define BRACKETING_H
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <Potential.h>
+#include "SolverConfig.h"
+#include "Wavefunction.h"
+
+/*! Automatic bracketing of the eigenvalues of the Numerov problem.
+ *
+ * Instead of scanning [Emin, Emax] with a fixed step, the n-th level (n = 0 is the ground state) is
+ * isolated with node counting: by the Sturm oscillation theorem the number of sign changes of the
+ * Numerov solution shot from the left wall at energy E equals the number of eigenvalues below E.
+ * The search starts from a WKB estimate of the level, stays within bounds derived from the potential
+ * (no level is below min V, and the n-th level is below max V plus the n-th level of the empty box),
+ * and bisects on the node count, so it costs O(log) sweeps.
+ */
+
+struct EnergyBracket {
+    double Emin, Emax;  // Emin has n nodes, Emax has n + 1: the bracket holds exactly the n-th level
+    int sweeps;         // Numerov sweeps spent to find it
+};
+
+//! Number of sign changes of the Numerov solution at Energy (from wavefunction[0], wavefunction[1], which is not written).
+template<typename Real> int count_nodes_Numerov(Real, int, const Real *, Real *,
+                                                const SolverConfig &config = SolverConfig::current());
+
+//! WKB estimate of the n-th level: the phase integral of p(x) over the classically allowed region is (n + 1/2) pi hbar.
+double wkb_Energy(int n, int nbox, const Potential &V, const SolverConfig &config = SolverConfig::current());
+//! WKB estimate of the level spacing around Energy, pi hbar / (dI/dE).
+double wkb_Spacing(double Energy, int nbox, const Potential &V, const SolverConfig &config = SolverConfig::current());
+
+/*! Isolates the n-th level. guess (if not NaN) replaces the WKB estimate, e.g. a level from a previous solve,
+ * and delta (if not NaN) the half width of the first bracket around it, half the WKB level spacing by default.
+ * The starting values wavefunction[0], wavefunction[1] must be set; the array holds nbox + 1 values.
+ */
+EnergyBracket bracket_Numerov(int n, int nbox, const Potential &V, double *wavefunction,
+                              double guess = NAN, double delta = NAN,
+                              const SolverConfig &config = SolverConfig::current());
+
+/*! The search of bracket_Numerov for a level of a subproblem (e.g. a parity sector), counted by count(E), the number
+ * of levels of the subproblem below E: the index-th level of the subproblem is the n-th level of V, whose WKB
+ * estimate and bounds start the search.
+ */
+EnergyBracket bracket_levels(int index, int n, int nbox, const Potential &V, const std::function<int(double)> &count,
+                             double guess = NAN, double delta = NAN,
+                             const SolverConfig &config = SolverConfig::current());
+
+/*! Finds the zero of wavefunction[nbox] in a bracket with a sign change (Illinois regula falsi);
+ * sweeps, if not null, is increased by the number of Numerov sweeps done. The sweeps are energy only:
+ * wavefunction gives the starting values and is not written.
+ */
+double refine_Numer(double Emin, double Emax, int nbox, const Potential &V, double *wavefunction, int *sweeps = nullptr,
+                    const SolverConfig &config = SolverConfig::current());
+//! The same on the zero of shot(E), any function of the energy with a sign change in [Emin, Emax]
+double refine_zero(double Emin, double Emax, const std::function<double(double)> &shot, int *sweeps = nullptr,
+                   const SolverConfig &config = SolverConfig::current());
+
+/*! Solves for the n-th level without any energy window: bracket_Numerov, then refine_Numer,
+ * then the wavefunction is normalized to 1 as in solve_Numerov.
+ */
+double solve_Numerov_level(int n, int nbox, const Potential &V, double *wavefunction, double guess = NAN);
+//! The same with the settings of config instead of SolverConfig::current()
+double solve_Numerov_level(int n, int nbox, const Potential &V, double *wavefunction, const SolverConfig &config,
+                           double guess = NAN);
+//! The same on the grid (nbox and mesh) of psi, from psi[0], psi[1]
+double solve_Numerov_level(int n, const Potential &V, Wavefunction &psi, double guess = NAN);
+double solve_Numerov_level(int n, const Potential &V, Wavefunction &psi, const SolverConfig &config, double guess = NAN);
+
+#endif
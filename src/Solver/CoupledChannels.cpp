@@ -0,0 +1,354 @@
+#include "CoupledChannels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "Bracketing.h"
+#include "SymmetricEigen.h"
+
+namespace {
+    /*! n x n kernels: Fixed > 0 is the channel count known at compile time, so that the loops unroll,
+    0 the count at run time.
+    */
+    template<int Fixed>
+    struct Kernel {
+        int runtime;
+
+        int size() const { return Fixed > 0 ? Fixed : runtime; }
+
+        /*! A <- A^{-1} by Gauss-Jordan elimination with pivots on the diagonal, largest first. Each pivot is a
+        diagonal entry of a Schur complement: the number of negative pivots, returned, is the number of negative
+        eigenvalues of A (Sylvester). used holds n flags.
+        */
+        int invert(double *A, char *used) const {
+            const int n = size();
+            int negative = 0;
+            std::fill(used, used + n, 0);
+
+            for (int step = 0; step < n; step++) {
+                int k = 0;
+                double largest = -1.;
+                for (int j = 0; j < n; j++)
+                    if (!used[j] && std::fabs(A[j * n + j]) > largest) {
+                        largest = std::fabs(A[j * n + j]);
+                        k = j;
+                    }
+                used[k] = 1;
+
+                double pivot = A[k * n + k];
+                if (pivot == 0.)
+                    pivot = std::numeric_limits<double>::min();
+                if (pivot < 0.)
+                    negative++;
+
+                double *row = A + k * n;
+                const double inverse = 1. / pivot;
+                row[k] = 1.;
+                for (int j = 0; j < n; j++)
+                    row[j] *= inverse;
+                for (int i = 0; i < n; i++) {
+                    double *other = A + i * n;
+                    const double f = other[k];
+                    if (i == k || f == 0.)
+                        continue;
+                    other[k] = 0.;
+                    for (int j = 0; j < n; j++)
+                        other[j] -= f * row[j];
+                }
+            }
+            return negative;
+        }
+    };
+}
+
+CoupledChannels::CoupledChannels(ContinuousBase base, DiscreteBase channels, const std::vector<Potential> &diagonal,
+                                 const SolverConfig &config)
+    : config(SolverConfig(config).setMesh(base.getMesh()))
+{
+    if (base.getBoundary() != ContinuousBase::HardWall)
+        throw std::invalid_argument("CoupledChannels needs a grid with hard walls.");
+
+    this->quantum = channels.getCoords();
+    this->n = (int) this->quantum.size();
+    this->nbox = (int) base.getNbox();
+    if (this->n < 1 || (int) diagonal.size() != this->n)
+        throw std::invalid_argument("CoupledChannels: one potential per channel.");
+    if (this->nbox < 4)
+        throw std::invalid_argument("CoupledChannels needs at least 4 intervals.");
+
+    const int nn = this->n * this->n;
+    this->v.assign((std::size_t) (nbox + 1) * nn, 0.);
+    for (int a = 0; a < this->n; a++) {
+        const std::vector<double> &values = diagonal[a].getValues();
+        if ((int) values.size() < nbox)
+            throw std::invalid_argument("CoupledChannels: the potential does not cover the grid.");
+        for (int i = 0; i <= nbox; i++)
+            this->v[(std::size_t) i * nn + a * n + a] = values[std::min(i, nbox - 1)];
+    }
+
+    // matching point at the bottom of the channel potentials (the nearest to the middle among equals), where
+    // the states are large and the ratio matrices regular
+    this->m = nbox / 2;
+    double deepest = std::numeric_limits<double>::infinity();
+    for (int i = 2; i <= nbox - 2; i++) {
+        double trace = 0.;
+        for (int a = 0; a < this->n; a++)
+            trace += this->v[(std::size_t) i * nn + a * n + a];
+        if (trace < deepest || (trace == deepest && std::abs(i - nbox / 2) < std::abs(this->m - nbox / 2))) {
+            deepest = trace;
+            this->m = i;
+        }
+    }
+}
+
+CoupledChannels& CoupledChannels::setCoupling(int a, int b, const Potential &W)
+{
+    if (a < 0 || b < 0 || a >= this->n || b >= this->n || a == b)
+        throw std::invalid_argument("CoupledChannels: the coupling is between two different channels.");
+    const std::vector<double> &values = W.getValues();
+    if ((int) values.size() < nbox)
+        throw std::invalid_argument("CoupledChannels: the potential does not cover the grid.");
+
+    const int nn = this->n * this->n;
+    for (int i = 0; i <= nbox; i++)
+        this->v[(std::size_t) i * nn + a * n + b] = this->v[(std::size_t) i * nn + b * n + a] = values[std::min(i, nbox - 1)];
+    return *this;
+}
+
+const std::vector<int>& CoupledChannels::getChannels() const
+{
+    return this->quantum;
+}
+
+/*! One propagation at Energy: R_1 .. R_{m-1} outward, Q_{nbox-1} .. Q_{m+1} inward, then M. ratios, if not null,
+receives R_i^{-1} (i < m) and Q_i^{-1} (i > m), and scales (1 - T_i)^{-1}, n x n per grid point.
+*/
+template<int Fixed>
+void CoupledChannels::propagate(double Energy, Sweep &s, std::vector<double> *ratios, std::vector<double> *scales) const
+{
+    const Kernel<Fixed> kernel{this->n};
+    const int n = kernel.size();
+    const int nn = n * n;
+    const double c = this->config.numerovFactor();
+
+    std::vector<double> R(nn), U(nn);
+    std::vector<char> used(n);
+
+    // U = 12 (1 - T_i)^{-1} - 10
+    auto numerov = [&](int i, double *out) {
+        const double *vi = &this->v[(std::size_t) i * nn];
+        for (int a = 0; a < n; a++)
+            for (int b = 0; b < n; b++)
+                out[a * n + b] = (a == b ? 1. + c * Energy : 0.) - c * vi[a * n + b];
+        kernel.invert(out, used.data());
+        if (scales)
+            std::copy(out, out + nn, scales->begin() + (std::size_t) i * nn);
+        for (int k = 0; k < nn; k++)
+            out[k] *= 12.;
+        for (int a = 0; a < n; a++)
+            out[a * n + a] -= 10.;
+    };
+
+    // both directions leave the inverse of their last ratio matrix in R, and M = U_m - R_{m-1}^{-1} - Q_{m+1}^{-1}
+    s.negative = 0;
+    s.M.assign(nn, 0.);
+    for (int direction = 0; direction < 2; direction++) {
+        const int first = direction == 0 ? 1 : nbox - 1;
+        const int last = direction == 0 ? m - 1 : m + 1;
+        const int step = direction == 0 ? 1 : -1;
+
+        numerov(first, R.data());
+        for (int i = first; ; i += step) {
+            s.negative += kernel.invert(R.data(), used.data());
+            if (ratios)
+                std::copy(R.begin(), R.end(), ratios->begin() + (std::size_t) i * nn);
+            if (i == last)
+                break;
+            numerov(i + step, U.data());
+            for (int k = 0; k < nn; k++)
+                R[k] = U[k] - R[k];
+        }
+        for (int k = 0; k < nn; k++)
+            s.M[k] -= R[k];
+    }
+
+    numerov(m, U.data());
+    for (int k = 0; k < nn; k++)
+        s.M[k] += U[k];
+    for (int a = 0; a < n; a++)
+        for (int b = 0; b < a; b++)
+            s.M[a * n + b] = s.M[b * n + a] = 0.5 * (s.M[a * n + b] + s.M[b * n + a]);
+
+    std::vector<double> M = s.M;
+    s.matching = kernel.invert(M.data(), used.data());
+    s.negative += s.matching;
+}
+
+CoupledChannels::Sweep CoupledChannels::sweep(double Energy, std::vector<double> *ratios, std::vector<double> *scales) const
+{
+    Sweep s;
+    switch (this->n) {
+        case 1: propagate<1>(Energy, s, ratios, scales); break;
+        case 2: propagate<2>(Energy, s, ratios, scales); break;
+        case 3: propagate<3>(Energy, s, ratios, scales); break;
+        case 4: propagate<4>(Energy, s, ratios, scales); break;
+        default: propagate<0>(Energy, s, ratios, scales); break;
+    }
+    return s;
+}
+
+int CoupledChannels::count(double Energy) const
+{
+    return sweep(Energy).negative;
+}
+
+/*! Bisection on the count until the bracket holds the n-th level alone and no pole of the ratio matrices
+(their negative eigenvalues are the same at both ends): there one eigenvalue of M, the index-th, goes from
+positive to negative, continuously, and is refined by regula falsi. Degenerate levels never hold a bracket
+alone: they are bisected down to the tolerance.
+*/
+double CoupledChannels::level(int n, double lower, int &sweeps) const
+{
+    const int nn = this->n * this->n;
+
+    // no level below the lowest Gershgorin bound of V
+    double bottom = std::numeric_limits<double>::infinity(), top = -bottom;
+    for (int i = 1; i < nbox; i++)
+        for (int a = 0; a < this->n; a++) {
+            const double *row = &this->v[(std::size_t) i * nn + a * this->n];
+            double radius = 0.;
+            for (int b = 0; b < this->n; b++)
+                if (b != a)
+                    radius += std::fabs(row[b]);
+            bottom = std::min(bottom, row[a] - radius);
+            top = std::max(top, row[a] + radius);
+        }
+    if (!(this->config.numerovFactor() * (top - bottom) < 1.))
+        throw std::invalid_argument("CoupledChannels: the mesh is too coarse for the depth of the potential.");
+
+    double Emin = std::max(bottom, lower), width = std::max(1., top - bottom);
+    Sweep below = sweep(Emin), above;
+    sweeps++;
+    if (below.negative > n) {
+        Emin = bottom;
+        below = sweep(Emin);
+        sweeps++;
+    }
+    double Emax = Emin + width;
+    for (above = sweep(Emax), sweeps++; above.negative <= n; above = sweep(Emax), sweeps++) {
+        Emin = Emax;
+        below = above;
+        width *= 2.;
+        Emax = Emin + width;
+    }
+
+    const double tolerance = this->config.getTolerance();
+    while (!(below.negative == n && above.negative == n + 1 && below.negative - below.matching == above.negative - above.matching)) {
+        if (Emax - Emin <= tolerance * std::max(1., std::fabs(Emax)))
+            return 0.5 * (Emin + Emax);
+        double Energy = 0.5 * (Emin + Emax);
+        Sweep s = sweep(Energy);
+        sweeps++;
+        if (s.negative > n) {
+            Emax = Energy;
+            above = s;
+        }
+        else {
+            Emin = Energy;
+            below = s;
+        }
+    }
+
+    const int index = below.matching;
+    return refine_zero(Emin, Emax, [&](double Energy) {
+        Sweep s = sweep(Energy);
+        std::vector<double> U;
+        symmetric_eigen(s.M, U, this->n);
+        std::vector<double> eigenvalues(this->n);
+        for (int a = 0; a < this->n; a++)
+            eigenvalues[a] = s.M[a * this->n + a];
+        std::nth_element(eigenvalues.begin(), eigenvalues.begin() + index, eigenvalues.end());
+        return eigenvalues[index];
+    }, &sweeps, this->config);
+}
+
+std::vector<double> CoupledChannels::levels(int count) const
+{
+    std::vector<double> energies;
+    double lower = -std::numeric_limits<double>::infinity();
+    int sweeps = 0;
+    for (int k = 0; k < count; k++) {
+        energies.push_back(level(k, lower, sweeps));
+        lower = energies.back();
+    }
+    return energies;
+}
+
+/*! At the level, F_m is the null vector of M; F_i = R_i^{-1} F_{i+1} to the left of m and Q_i^{-1} F_{i-1} to
+the right, and psi_i = (1 - T_i)^{-1} F_i.
+*/
+CoupledChannels::Level CoupledChannels::solve(int n) const
+{
+    if (n < 0)
+        throw std::invalid_argument("CoupledChannels: levels are counted from 0.");
+
+    Level result;
+    result.sweeps = 0;
+    result.energy = level(n, -std::numeric_limits<double>::infinity(), result.sweeps);
+
+    const int channels = this->n;
+    const int nn = channels * channels;
+    std::vector<double> ratios((std::size_t) (nbox + 1) * nn), scales((std::size_t) (nbox + 1) * nn);
+    Sweep s = sweep(result.energy, &ratios, &scales);
+    result.sweeps++;
+
+    std::vector<double> U;
+    symmetric_eigen(s.M, U, channels);
+    int null = 0;
+    for (int a = 1; a < channels; a++)
+        if (std::fabs(s.M[a * channels + a]) < std::fabs(s.M[null * channels + null]))
+            null = a;
+
+    std::vector<double> F((std::size_t) (nbox + 1) * channels, 0.);
+    for (int a = 0; a < channels; a++)
+        F[(std::size_t) m * channels + a] = U[a * channels + null];
+    for (int i = m - 1; i >= 1; i--)
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++)
+                F[(std::size_t) i * channels + a] += ratios[(std::size_t) i * nn + a * channels + b] * F[(std::size_t) (i + 1) * channels + b];
+    for (int i = m + 1; i <= nbox - 1; i++)
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++)
+                F[(std::size_t) i * channels + a] += ratios[(std::size_t) i * nn + a * channels + b] * F[(std::size_t) (i - 1) * channels + b];
+
+    result.channels.assign(channels, std::vector<double>(nbox + 1, 0.));
+    double norm = 0., largest = 0.;
+    for (int i = 1; i <= nbox - 1; i++)
+        for (int a = 0; a < channels; a++) {
+            double psi = 0.;
+            for (int b = 0; b < channels; b++)
+                psi += scales[(std::size_t) i * nn + a * channels + b] * F[(std::size_t) i * channels + b];
+            result.channels[a][i] = psi;
+            norm += psi * psi;
+            largest = std::max(largest, std::fabs(psi));
+        }
+
+    // normalized, first lobe positive as in solve_Numerov
+    double scale = 1. / std::sqrt(norm * this->config.getMesh());
+    for (int i = 1; i <= nbox - 1; i++) {
+        int a = 0;
+        while (a < channels && std::fabs(result.channels[a][i]) <= 1e-3 * largest)
+            a++;
+        if (a < channels) {
+            if (result.channels[a][i] < 0.)
+                scale = -scale;
+            break;
+        }
+    }
+    for (auto &component : result.channels)
+        for (double &psi : component)
+            psi *= scale;
+    return result;
+}
@@ -0,0 +1,80 @@
+#ifndef COUPLEDCHANNELS_H
+#define COUPLEDCHANNELS_H
+
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <DiscreteBase.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! CoupledChannels solves the bound states of channels coupled by a potential matrix: psi is a vector with one
+ * component per channel (the quantum numbers of a DiscreteBase, e.g. L or spin), and
+ *   psi_a'' = (2m / hbar^2) sum_b (V_ab(x) - E delta_ab) psi_b
+ * on a ContinuousBase grid with hard walls at x_0 and x_nbox. V is symmetric.
+ *
+ * The renormalized Numerov method (Johnson): with T_i = c (V_i - E), c the Numerov factor of the grid, and
+ * F_i = (1 - T_i) psi_i, the Numerov recurrence reads F_{i+1} - U_i F_i + F_{i-1} = 0, U_i = 12 (1 - T_i)^{-1} - 10.
+ * Only the ratio matrices are propagated: R_i = F_{i+1} F_i^{-1} = U_i - R_{i-1}^{-1} outward from the left
+ * wall, and Q_i = F_{i-1} F_i^{-1} = U_i - Q_{i+1}^{-1} inward from the right wall, up to the matching point m,
+ * where the matching matrix M(E) = U_m - R_{m-1}^{-1} - Q_{m+1}^{-1} is singular at the levels.
+ *
+ * The R_i, Q_i and M are the pivots of a block LDL^T factorization of the recurrence, which is decreasing in E,
+ * so the number of their negative eigenvalues (the inertia, given by the pivots of each inversion) is the
+ * number of levels below E: the n-th level is bracketed by bisection on it, with degenerate levels counted
+ * once each, and refined on the eigenvalue of M that crosses zero.
+ *
+ * An inversion costs n^3 per grid point (two per point and energy). The kernels are instantiated for 1 to 4
+ * channels with the size known at compile time, and for any other count with the size at run time.
+ *
+ * CoupledChannels cc(ContinuousBase(0.01, 1000), DiscreteBase(0, 2, 1), {V0, V1});
+ * cc.setCoupling(0, 1, W);
+ * CoupledChannels::Level ground = cc.solve(0);
+ */
+class CoupledChannels {
+public:
+    struct Level {
+        double energy;
+        std::vector< std::vector<double> > channels;  // psi_a at x_0 .. x_nbox; sum_a int |psi_a|^2 dx = 1
+        int sweeps;                                   // propagations over the grid spent to find it
+    };
+
+    //! One Potential per channel on the grid of base: the diagonal of V, no coupling; solved with config on the mesh of base
+    CoupledChannels(ContinuousBase base, DiscreteBase channels, const std::vector<Potential> &diagonal,
+                    const SolverConfig &config = SolverConfig::current());
+
+    //! V_ab = V_ba = W (a, b are channel indices, 0 .. channels - 1)
+    CoupledChannels& setCoupling(int a, int b, const Potential &W);
+
+    //! Number of levels below Energy
+    int count(double Energy) const;
+    //! The n-th level (n = 0 is the ground state) and its channel components
+    Level solve(int n) const;
+    //! The lowest levels, energies only
+    std::vector<double> levels(int count) const;
+
+    //! Quantum numbers of the channels
+    const std::vector<int>& getChannels() const;
+
+private:
+    struct Sweep {
+        int negative;                   // negative eigenvalues of the R_i, Q_i and M
+        int matching;                   // of M alone
+        std::vector<double> M;
+    };
+
+    SolverConfig config;
+    int nbox;
+    int n;                     // channels
+    int m;                     // matching point
+    std::vector<int> quantum;
+    std::vector<double> v;     // V at x_0 .. x_nbox, n x n row major per point
+
+    Sweep sweep(double Energy, std::vector<double> *ratios = nullptr, std::vector<double> *scales = nullptr) const;
+    template<int Fixed> void propagate(double Energy, Sweep &s, std::vector<double> *ratios,
+                                       std::vector<double> *scales) const;
+    //! Energy of the n-th level, searched above lower
+    double level(int n, double lower, int &sweeps) const;
+};
+
+#endif
@@ -0,0 +1,309 @@
+#include "EigenCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "Schroedinger.h"
+
+namespace {
+    const char magic[8] = {'S', 'C', 'H', 'E', 'I', 'G', 'E', 'N'};
+
+    std::string exact(double d) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.17g", d);
+        return buf;
+    }
+
+    std::uint64_t mix(std::uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    //! 128 bit digest of the bit patterns of values, two independent lanes of one word per value
+    std::string digest(const std::vector<double>& values) {
+        std::uint64_t a = 0x9e3779b97f4a7c15ULL, b = 0x2545f4914f6cdd1dULL;
+        for (double value : values) {
+            std::uint64_t word;
+            std::memcpy(&word, &value, sizeof(word));
+            a = mix(a ^ word);
+            b = mix(b + ((word << 29) | (word >> 35)));
+        }
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "%016llx%016llx", (unsigned long long) a, (unsigned long long) b);
+        return buf;
+    }
+
+    //! The values a hit must match: those of a custom potential, none for the others
+    const std::vector<double>& identity(const Potential& V) {
+        static const std::vector<double> none;
+        return (V.getType() == "custom") ? V.getValues() : none;
+    }
+
+    bool same(const std::vector<double>& a, const std::vector<double>& b) {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0);
+    }
+}
+
+EigenCache::EigenCache(std::size_t capacity, std::string directory, Bucket bucket)
+{
+    this->capacity  = (capacity > 0) ? capacity : 1;
+    this->directory = directory;
+    this->bucket    = bucket;
+
+    if (!directory.empty())
+        std::filesystem::create_directories(directory);
+}
+
+std::string EigenCache::describe(const ContinuousBase& base, const Potential& V, double Emin, double Emax,
+                                 double Estep, const double *wavefunction, const SolverConfig& config)
+{
+    std::ostringstream key;
+    key << "v" << version
+        << "|type=" << V.getType()
+        << "|k=" << exact(V.getK())
+        << "|width=" << exact(V.getWidth())
+        << "|height=" << exact(V.getHeight())
+        << "|start=" << exact(base.getStart())
+        << "|end=" << exact(base.getEnd())
+        << "|mesh=" << exact(base.getMesh())
+        << "|nbox=" << base.getNbox()
+        << "|emin=" << exact(Emin)
+        << "|emax=" << exact(Emax)
+        << "|estep=" << exact(Estep)
+        << "|tolerance=" << exact(config.getTolerance())
+        << "|iterations=" << config.getMaxIterations()
+        << "|units=" << exact(config.getHbar()) << "," << exact(config.getMass())
+        << "|seed=" << exact(wavefunction[0]) << "," << exact(wavefunction[1]);
+
+    // a custom potential is not described by its parameters, but by a digest of its values; the values themselves
+    // are kept with the entry, and a hit must match them exactly
+    if (V.getType() == "custom")
+        key << "|values=" << V.getValues().size() << ":" << digest(V.getValues());
+    return key.str();
+}
+
+std::uint64_t EigenCache::hash(const std::string& key)
+{
+    std::uint64_t h = 14695981039346656037ULL;
+    for (unsigned char ch : key) {
+        h ^= ch;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool EigenCache::lookup(const std::string& key, double& energy, std::vector<double>& wavefunction,
+                        const std::vector<double>& potential)
+{
+    std::uint64_t h = this->bucket(key);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->index.find(h);
+        if (it != this->index.end() && it->second->key == key && same(it->second->potential, potential)) {
+            // move to the front of the LRU list
+            this->entries.splice(this->entries.begin(), this->entries, it->second);
+            energy = it->second->energy;
+            wavefunction = it->second->wavefunction;
+            this->hits++;
+            return true;
+        }
+    }
+
+    if (!this->directory.empty() && readFile(key, h, energy, wavefunction, potential)) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        insert(Entry{h, key, energy, wavefunction, potential});
+        this->hits++;
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->misses++;
+    return false;
+}
+
+void EigenCache::store(const std::string& key, double energy, const std::vector<double>& wavefunction,
+                       const std::vector<double>& potential)
+{
+    std::uint64_t h = this->bucket(key);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        insert(Entry{h, key, energy, wavefunction, potential});
+    }
+    if (!this->directory.empty())
+        writeFile(key, h, energy, wavefunction, potential);
+}
+
+void EigenCache::insert(Entry entry)
+{
+    auto it = this->index.find(entry.hash);
+    if (it != this->index.end()) {
+        this->entries.erase(it->second);
+        this->index.erase(it);
+    }
+
+    this->entries.push_front(std::move(entry));
+    this->index[this->entries.front().hash] = this->entries.begin();
+
+    while (this->entries.size() > this->capacity) {
+        this->index.erase(this->entries.back().hash);
+        this->entries.pop_back();
+    }
+}
+
+std::size_t EigenCache::size()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->entries.size();
+}
+
+unsigned long EigenCache::getHits()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->hits;
+}
+
+unsigned long EigenCache::getMisses()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->misses;
+}
+
+std::string EigenCache::path(std::uint64_t h)
+{
+    char name[40];
+    std::snprintf(name, sizeof(name), "v%u-%016llx.eig", version, (unsigned long long) h);
+    return this->directory + "/" + name;
+}
+
+/*! File layout: magic, key length (uint32), key, energy (double), number of values (uint64), values,
+ * number of potential values (uint64), potential values.
+ * A file whose key or potential differs from the requested one (a hash collision), that is truncated or whose
+ * number of values exceeds its size is ignored.
+ */
+bool EigenCache::readFile(const std::string& key, std::uint64_t h, double& energy, std::vector<double>& wavefunction,
+                          const std::vector<double>& potential)
+{
+    std::ifstream in(path(h), std::ios::binary);
+    if (!in)
+        return false;
+
+    char header[sizeof(magic)];
+    std::uint32_t keyLength = 0;
+    if (!in.read(header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0)
+        return false;
+    if (!in.read((char*) &keyLength, sizeof(keyLength)) || keyLength != key.size())
+        return false;
+
+    std::string storedKey(keyLength, '\0');
+    std::uint64_t n = 0;
+    if (!in.read(&storedKey[0], keyLength) || storedKey != key)
+        return false;
+    if (!in.read((char*) &energy, sizeof(energy)) || !in.read((char*) &n, sizeof(n)))
+        return false;
+
+    // the count is checked against the rest of the file before anything is allocated for it
+    std::streamoff here = in.tellg();
+    if (here < 0 || !in.seekg(0, std::ios::end))
+        return false;
+    std::streamoff rest = in.tellg() - here;
+    if (n > (std::uint64_t) rest / sizeof(double) || !in.seekg(here))
+        return false;
+
+    std::vector<double> values(n);
+    if (!in.read((char*) values.data(), n * sizeof(double)))
+        return false;
+
+    std::uint64_t m = 0;
+    if (!in.read((char*) &m, sizeof(m)) || m != potential.size())
+        return false;
+    std::vector<double> stored(m);
+    if (!in.read((char*) stored.data(), m * sizeof(double)) || !same(stored, potential))
+        return false;
+
+    wavefunction.swap(values);
+    return true;
+}
+
+void EigenCache::writeFile(const std::string& key, std::uint64_t h, double energy, const std::vector<double>& wavefunction,
+                           const std::vector<double>& potential)
+{
+    // Written aside and renamed, so that concurrent readers never see a partial file
+    std::ostringstream suffix;
+    suffix << ".tmp" << std::this_thread::get_id();
+    std::string final_path = path(h);
+    std::string tmp_path = final_path + suffix.str();
+
+    std::uint32_t keyLength = (std::uint32_t) key.size();
+    std::uint64_t n = wavefunction.size();
+    std::uint64_t m = potential.size();
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(magic, sizeof(magic));
+        out.write((const char*) &keyLength, sizeof(keyLength));
+        out.write(key.data(), keyLength);
+        out.write((const char*) &energy, sizeof(energy));
+        out.write((const char*) &n, sizeof(n));
+        out.write((const char*) wavefunction.data(), n * sizeof(double));
+        out.write((const char*) &m, sizeof(m));
+        out.write((const char*) potential.data(), m * sizeof(double));
+        if (!out) {
+            std::cerr << "WARNING: cannot write eigenvalue cache entry " << tmp_path << std::endl;
+            std::remove(tmp_path.c_str());
+            return;
+        }
+    }
+    std::rename(tmp_path.c_str(), final_path.c_str());
+}
+
+double cached_solve_Numerov(EigenCache& cache, double Emin, double Emax, double Estep,
+                            const ContinuousBase& base, const Potential& V, double *wavefunction,
+                            const SolverConfig& config)
+{
+    int nbox = (int) base.getNbox();
+    const SolverConfig settings = SolverConfig(config).setMesh(base.getMesh());
+    std::string key = EigenCache::describe(base, V, Emin, Emax, Estep, wavefunction, settings);
+
+    double energy;
+    std::vector<double> values;
+    if (cache.lookup(key, energy, values, identity(V)) && values.size() == (std::size_t) nbox + 1) {
+        std::copy(values.begin(), values.end(), wavefunction);
+        return energy;
+    }
+
+    energy = solve_Numerov(Emin, Emax, Estep, nbox, V, wavefunction, settings);
+    cache.store(key, energy, std::vector<double>(wavefunction, wavefunction + nbox + 1), identity(V));
+    return energy;
+}
+
+SolveResult cached_solve_Numerov(EigenCache& cache, double Emin, double Emax, double Estep,
+                                 const ContinuousBase& base, const Potential& V, double *wavefunction, const SolveControl& control,
+                                 const SolverConfig& config)
+{
+    int nbox = (int) base.getNbox();
+    const SolverConfig settings = SolverConfig(config).setMesh(base.getMesh());
+    std::string key = EigenCache::describe(base, V, Emin, Emax, Estep, wavefunction, settings);
+
+    SolveResult result;
+    std::vector<double> values;
+    if (cache.lookup(key, result.energy, values, identity(V)) && values.size() == (std::size_t) nbox + 1) {
+        std::copy(values.begin(), values.end(), wavefunction);
+        result.status = SolveResult::Converged;
+        result.Emin = result.Emax = result.energy;
+        result.bracketed = true;
+        result.elapsed = control.elapsed();
+        return result;
+    }
+
+    result = solve_Numerov(Emin, Emax, Estep, nbox, V, wavefunction, control, settings);
+    if (result.converged())
+        cache.store(key, result.energy, std::vector<double>(wavefunction, wavefunction + nbox + 1), identity(V));
+    return result;
+}
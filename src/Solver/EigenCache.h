@@ -0,0 +1,99 @@
+#ifndef EIGENCACHE_H
+#define EIGENCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include "SolveControl.h"
+#include "SolverConfig.h"
+
+/*! EigenCache memoizes solutions of the eigenvalue problem, so that identical problems solved again
+ * (in the same process or, with a cache directory, in a later one) skip the Numerov scan.
+ *
+ * A problem is described by a canonical key (see describe()) holding the Potential parameters (a 128 bit
+ * digest of its values, if it is a custom one), the ContinuousBase grid, the energy window, the tolerance,
+ * iteration limit and units of the current SolverConfig (the solve runs on the mesh of the grid) and the
+ * starting values of the wavefunction; entries are addressed by a 64 bit hash of that key (hash() unless another
+ * bucket function is given) and verified against the full key and, for a custom potential, against its values
+ * stored with the entry (byte for byte), so hash collisions never return a wrong solution.
+ *
+ * In memory the cache keeps at most capacity entries, evicting the least recently used one.
+ * If a directory is given every stored entry is also written there as "v<version>-<hash>.eig", and
+ * misses in memory fall back to disk. Keys are versioned: bumping version invalidates old files.
+ * All methods are thread safe.
+ */
+class EigenCache {
+public:
+    static constexpr unsigned int version = 4;
+
+    using Bucket = std::uint64_t (*)(const std::string&);
+
+    explicit EigenCache(std::size_t capacity = 1024, std::string directory = "", Bucket bucket = &EigenCache::hash);
+
+    //! Canonical description of the problem solved by solve_Numerov on base with potential V and the settings of config.
+    static std::string describe(const ContinuousBase& base, const Potential& V, double Emin, double Emax,
+                                double Estep, const double *wavefunction,
+                                const SolverConfig& config = SolverConfig::current());
+    //! FNV-1a hash of a problem description.
+    static std::uint64_t hash(const std::string& key);
+
+    //! A hit needs the same key and the same potential values (empty for a potential described by its parameters)
+    bool lookup(const std::string& key, double& energy, std::vector<double>& wavefunction,
+                const std::vector<double>& potential = std::vector<double>());
+    void store(const std::string& key, double energy, const std::vector<double>& wavefunction,
+               const std::vector<double>& potential = std::vector<double>());
+
+    std::size_t size();
+    unsigned long getHits();
+    unsigned long getMisses();
+
+    EigenCache(const EigenCache&) = delete;
+    EigenCache& operator=(const EigenCache&) = delete;
+
+private:
+    struct Entry {
+        std::uint64_t hash;
+        std::string key;
+        double energy;
+        std::vector<double> wavefunction;
+        std::vector<double> potential;
+    };
+
+    std::size_t capacity;
+    std::string directory;
+    Bucket bucket;
+    std::mutex mutex;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+    unsigned long hits   = 0;
+    unsigned long misses = 0;
+
+    std::string path(std::uint64_t hash);
+    bool readFile(const std::string& key, std::uint64_t hash, double& energy, std::vector<double>& wavefunction,
+                  const std::vector<double>& potential);
+    void writeFile(const std::string& key, std::uint64_t hash, double energy, const std::vector<double>& wavefunction,
+                   const std::vector<double>& potential);
+    void insert(Entry entry);
+};
+
+/*! Same as solve_Numerov with config on the mesh of base, but looks the solution up in cache first and stores it
+ * there on a miss. The wavefunction must hold base.getNbox() + 1 values, with the two starting values already set.
+ */
+double cached_solve_Numerov(EigenCache& cache, double Emin, double Emax, double Estep,
+                            const ContinuousBase& base, const Potential& V, double *wavefunction,
+                            const SolverConfig& config = SolverConfig::current());
+
+/*! Controlled variant: a miss is solved within the bounds of control, and only a converged solution
+ * is stored. A hit is returned as converged, with no sweeps.
+ */
+SolveResult cached_solve_Numerov(EigenCache& cache, double Emin, double Emax, double Estep,
+                                 const ContinuousBase& base, const Potential& V, double *wavefunction, const SolveControl& control,
+                                 const SolverConfig& config = SolverConfig::current());
+
+#endif
@@ -0,0 +1,485 @@
+#include "ImaginaryTime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "SolverConfig.h"
+#include "SymmetricEigen.h"
+
+namespace {
+    const std::size_t block = 64;      // lines of axes 1 and 2 solved together
+    const std::size_t max_parts = 64;  // fixed reduction tree: the result does not depend on threads
+    const double ratio = 4.;           // between the time steps of a cycle
+}
+
+ImaginaryTime::ImaginaryTime(Base base, const std::vector<Potential> &axes, int threads, const SolverConfig &config)
+{
+    std::vector<ContinuousBase> continuous = base.getContinuous();
+    this->dims = (int) continuous.size();
+    if (this->dims < 1 || this->dims > 3)
+        throw std::invalid_argument("ImaginaryTime: the base must have 1, 2 or 3 continuous axes.");
+    if (axes.size() != continuous.size())
+        throw std::invalid_argument("ImaginaryTime: one potential per axis.");
+
+    this->kinetic = config.kineticFactor();
+    this->threads = std::max(1, threads);
+    this->points  = 1;
+    this->volume  = 1.;
+    for (int a = 0; a < this->dims; a++) {
+        ContinuousBase &axis = continuous[a];
+        const int nbox = (int) axis.getNbox();
+        const std::vector<double> &values = axes[a].getValues();
+        if (axis.getBoundary() != ContinuousBase::HardWall)
+            throw std::invalid_argument("ImaginaryTime: the axes must have hard walls.");
+        if (nbox < 3 || (int) values.size() < nbox)
+            throw std::invalid_argument("ImaginaryTime: the potential does not cover the grid of an axis.");
+
+        this->shape.push_back(nbox - 1);
+        this->stride.push_back(this->points);
+        this->points *= (std::size_t) (nbox - 1);
+        this->mesh.push_back(axis.getMesh());
+        this->volume *= axis.getMesh();
+        this->v.emplace_back(values.begin() + 1, values.begin() + nbox);
+        this->vmin.push_back(*std::min_element(this->v.back().begin(), this->v.back().end()));
+    }
+    this->minimum = std::accumulate(this->vmin.begin(), this->vmin.end(), 0.);
+    this->stiffest = 0.;
+    for (int a = 0; a < this->dims; a++)
+        this->stiffest += 4. * this->kinetic / (this->mesh[a] * this->mesh[a]);
+}
+
+ImaginaryTime& ImaginaryTime::setValues(const std::vector<double> &values)
+{
+    if (values.size() != this->points)
+        throw std::invalid_argument("ImaginaryTime: one value per unknown of the grid.");
+    this->extra = values;
+    this->minimum = std::accumulate(this->vmin.begin(), this->vmin.end(), 0.)
+                  + *std::min_element(values.begin(), values.end());
+    return *this;
+}
+
+ImaginaryTime& ImaginaryTime::setTolerance(double variance)
+{
+    if (!(variance > 0.))
+        throw std::invalid_argument("The tolerance must be positive.");
+    this->tolerance = variance;
+    return *this;
+}
+
+ImaginaryTime& ImaginaryTime::setMaxSteps(int steps)
+{
+    if (steps < 1)
+        throw std::invalid_argument("At least one step.");
+    this->maxSteps = steps;
+    return *this;
+}
+
+ImaginaryTime& ImaginaryTime::setSeed(unsigned int seed)
+{
+    this->seed = seed;
+    return *this;
+}
+
+const std::vector<int>& ImaginaryTime::getShape() const
+{
+    return this->shape;
+}
+
+std::size_t ImaginaryTime::getPoints() const
+{
+    return this->points;
+}
+
+//! Runs kernel(task) for every task in [0, ntasks) on the worker threads
+template<typename Kernel>
+void ImaginaryTime::forTasks(std::size_t ntasks, Kernel kernel) const
+{
+    std::atomic<std::size_t> next(0);
+
+    auto worker = [&]() {
+        for (std::size_t t = next++; t < ntasks; t = next++)
+            kernel(t);
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < this->threads && (std::size_t) t < ntasks; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool)
+        t.join();
+}
+
+/*! Splits the lines of axis 0 in at most max_parts parts, runs kernel(first line, end line, sums of the part)
+and adds the count sums of the parts in order: parts are always the same, whatever the number of threads.
+*/
+template<typename Kernel>
+void ImaginaryTime::reduce(int count, double *sums, Kernel kernel) const
+{
+    const std::size_t lines = this->points / this->shape[0];
+    const std::size_t nparts = std::min(max_parts, lines);
+    std::vector<double> partial(nparts * count, 0.);
+
+    forTasks(nparts, [&](std::size_t p) {
+        kernel(p * lines / nparts, (p + 1) * lines / nparts, &partial[p * count]);
+    });
+
+    for (int q = 0; q < count; q++) {
+        sums[q] = 0.;
+        for (std::size_t p = 0; p < nparts; p++)
+            sums[q] += partial[p * count + q];
+    }
+}
+
+//! out = (H f) on a line of axis 0
+void ImaginaryTime::applyLine(const double *f, std::size_t line, double *out) const
+{
+    const int n0 = this->shape[0];
+    const double *g = f + line * n0;
+
+    int index[3] = {0, 0, 0};
+    double vline = 0., diag = 2. * this->kinetic / (this->mesh[0] * this->mesh[0]);
+    std::size_t rest = line;
+    for (int a = 1; a < this->dims; a++) {
+        index[a] = (int) (rest % this->shape[a]);
+        rest /= this->shape[a];
+        vline += this->v[a][index[a]];
+        diag  += 2. * this->kinetic / (this->mesh[a] * this->mesh[a]);
+    }
+
+    const double *V0 = this->v[0].data();
+    for (int m = 0; m < n0; m++)
+        out[m] = (diag + vline + V0[m]) * g[m];
+    if (!this->extra.empty()) {
+        const double *W = this->extra.data() + line * n0;
+        for (int m = 0; m < n0; m++)
+            out[m] += W[m] * g[m];
+    }
+
+    const double c0 = this->kinetic / (this->mesh[0] * this->mesh[0]);
+    for (int m = 1; m < n0; m++)
+        out[m] -= c0 * g[m - 1];
+    for (int m = 0; m + 1 < n0; m++)
+        out[m] -= c0 * g[m + 1];
+
+    for (int a = 1; a < this->dims; a++) {
+        const double c = this->kinetic / (this->mesh[a] * this->mesh[a]);
+        if (index[a] > 0) {
+            const double *h = g - this->stride[a];
+            for (int m = 0; m < n0; m++)
+                out[m] -= c * h[m];
+        }
+        if (index[a] + 1 < this->shape[a]) {
+            const double *h = g + this->stride[a];
+            for (int m = 0; m < n0; m++)
+                out[m] -= c * h[m];
+        }
+    }
+}
+
+/*! d <- P^{-1} d, one tridiagonal (Thomas) solve per line of each axis. The lines of an axis start at
+o * len * inner + p, p < inner = stride: a task solves up to block adjacent p at once.
+*/
+void ImaginaryTime::precondition(double *d, double tau) const
+{
+    for (int a = 0; a < this->dims; a++) {
+        const int len = this->shape[a];
+        const std::size_t inner = this->stride[a];
+        const std::size_t outer = this->points / (inner * len);
+        const double c = this->kinetic / (this->mesh[a] * this->mesh[a]);
+        const double off = -tau * c;
+
+        // elimination coefficients, the same on every line of the axis
+        std::vector<double> upper(len), inverse(len);
+        for (int i = 0; i < len; i++) {
+            double pivot = 1. + tau * (2. * c + this->v[a][i] - this->vmin[a]) - (i > 0 ? off * upper[i - 1] : 0.);
+            inverse[i] = 1. / pivot;
+            upper[i] = off * inverse[i];
+        }
+
+        const std::size_t width = std::min(block, inner);
+        const std::size_t blocks = (inner + width - 1) / width;
+        forTasks(outer * blocks, [&](std::size_t task) {
+            const std::size_t first = (task % blocks) * width;
+            const std::size_t w = std::min(width, inner - first);
+            double *base = d + (task / blocks) * len * inner + first;
+
+            for (std::size_t b = 0; b < w; b++)
+                base[b] *= inverse[0];
+            for (int i = 1; i < len; i++) {
+                double *row = base + i * inner;
+                const double *previous = row - inner;
+                for (std::size_t b = 0; b < w; b++)
+                    row[b] = (row[b] - off * previous[b]) * inverse[i];
+            }
+            for (int i = len - 2; i >= 0; i--) {
+                double *row = base + i * inner;
+                const double *next = row + inner;
+                for (std::size_t b = 0; b < w; b++)
+                    row[b] -= upper[i] * next[b];
+            }
+        });
+    }
+}
+
+//! f <- f - sum_j <lower_j|f> lower_j over the first count states (normalized)
+void ImaginaryTime::orthogonalize(double *f, const std::vector< std::vector<double> > &lower, int count) const
+{
+    if (count == 0)
+        return;
+
+    const int n0 = this->shape[0];
+    std::vector<double> overlap(count);
+    reduce(count, overlap.data(), [&](std::size_t first, std::size_t last, double *sums) {
+        for (int j = 0; j < count; j++) {
+            const double *u = lower[j].data();
+            for (std::size_t i = first * n0; i < last * n0; i++)
+                sums[j] += u[i] * f[i];
+        }
+    });
+
+    const std::size_t lines = this->points / n0;
+    const std::size_t nparts = std::min(max_parts, lines);
+    forTasks(nparts, [&](std::size_t p) {
+        for (int j = 0; j < count; j++) {
+            const double *u = lower[j].data();
+            for (std::size_t i = p * lines / nparts * n0; i < (p + 1) * lines / nparts * n0; i++)
+                f[i] -= overlap[j] * u[i];
+        }
+    });
+}
+
+//! sum |f|^2 = 1
+void ImaginaryTime::normalize(double *f) const
+{
+    const int n0 = this->shape[0];
+    double norm;
+    reduce(1, &norm, [&](std::size_t first, std::size_t last, double *sums) {
+        for (std::size_t i = first * n0; i < last * n0; i++)
+            sums[0] += f[i] * f[i];
+    });
+
+    const double scale = 1. / std::sqrt(norm);
+    const std::size_t lines = this->points / n0;
+    const std::size_t nparts = std::min(max_parts, lines);
+    forTasks(nparts, [&](std::size_t p) {
+        for (std::size_t i = p * lines / nparts * n0; i < (p + 1) * lines / nparts * n0; i++)
+            f[i] *= scale;
+    });
+}
+
+/*! Rayleigh-Ritz on the span of the (orthonormal) states: they are rotated into the eigenvectors of H on it,
+by ascending energy, which separates nearly degenerate levels the single state steps resolve slowly.
+*/
+void ImaginaryTime::rotate(std::vector< std::vector<double> > &states, std::vector<double> &work) const
+{
+    const int n0 = this->shape[0];
+    const int nstates = (int) states.size();
+    std::vector<double> h((std::size_t) nstates * nstates), row(nstates), U;
+
+    for (int j = 0; j < nstates; j++) {
+        const double *psi = states[j].data();
+        double *Hpsi = work.data();
+        reduce(nstates, row.data(), [&](std::size_t first, std::size_t last, double *sums) {
+            for (std::size_t line = first; line < last; line++)
+                applyLine(psi, line, Hpsi + line * n0);
+            for (int i = 0; i < nstates; i++) {
+                const double *u = states[i].data();
+                for (std::size_t k = first * n0; k < last * n0; k++)
+                    sums[i] += u[k] * Hpsi[k];
+            }
+        });
+        for (int i = 0; i < nstates; i++)
+            h[i * nstates + j] = row[i];
+    }
+    for (int i = 0; i < nstates; i++)
+        for (int j = 0; j < i; j++)
+            h[i * nstates + j] = h[j * nstates + i] = 0.5 * (h[i * nstates + j] + h[j * nstates + i]);
+
+    symmetric_eigen(h, U, nstates);
+    std::vector<int> order(nstates);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return h[a * nstates + a] < h[b * nstates + b]; });
+
+    const std::size_t lines = this->points / n0;
+    const std::size_t nparts = std::min(max_parts, lines);
+    forTasks(nparts, [&](std::size_t p) {
+        std::vector<double> old(nstates);
+        for (std::size_t k = p * lines / nparts * n0; k < (p + 1) * lines / nparts * n0; k++) {
+            for (int j = 0; j < nstates; j++)
+                old[j] = states[j][k];
+            for (int i = 0; i < nstates; i++) {
+                double value = 0.;
+                for (int j = 0; j < nstates; j++)
+                    value += U[j * nstates + order[i]] * old[j];
+                states[i][k] = value;
+            }
+        }
+    });
+}
+
+ImaginaryTime::Result ImaginaryTime::run(int nstates)
+{
+    if (nstates < 1 || (std::size_t) nstates > this->points)
+        throw std::invalid_argument("ImaginaryTime: between one state and one per unknown of the grid.");
+
+    const int n0 = this->shape[0];
+    const std::size_t lines = this->points / n0;
+    const std::size_t nparts = std::min(max_parts, lines);
+
+    Result result;
+    result.steps = 0;
+    result.converged = false;
+    result.energies.assign(nstates, 0.);
+    result.variances.assign(nstates, 0.);
+    result.states.assign(nstates, std::vector<double>(this->points));
+    std::vector< std::vector<double> > &states = result.states;
+    std::vector<double> work(this->points);
+
+    // internally sum |psi|^2 = 1; dV enters only the returned states
+    std::mt19937 random(this->seed);
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    for (int s = 0; s < nstates; s++) {
+        for (double &value : states[s])
+            value = uniform(random);
+        orthogonalize(states[s].data(), states, s);
+        normalize(states[s].data());
+    }
+
+    for (int step = 0; ; step++) {
+        bool converged = true;
+        bool moved = false;  // a lower state changed in this step
+
+        for (int s = 0; s < nstates; s++) {
+            double *psi = states[s].data();
+            double *r = work.data();
+            if (moved) {
+                orthogonalize(psi, states, s);
+                normalize(psi);
+            }
+
+            // r = (H - E) psi, E = <psi|H|psi>
+            double sums[4];
+            reduce(2, sums, [&](std::size_t first, std::size_t last, double *acc) {
+                for (std::size_t line = first; line < last; line++) {
+                    applyLine(psi, line, r + line * n0);
+                    for (std::size_t i = line * n0; i < (line + 1) * n0; i++) {
+                        acc[0] += psi[i] * r[i];
+                        acc[1] += psi[i] * psi[i];
+                    }
+                }
+            });
+            const double norm = sums[1];
+            const double E = sums[0] / norm;
+            reduce(1, sums, [&](std::size_t first, std::size_t last, double *acc) {
+                for (std::size_t i = first * n0; i < last * n0; i++) {
+                    r[i] -= E * psi[i];
+                    acc[0] += r[i] * r[i];
+                }
+            });
+            result.energies[s] = E;
+            result.variances[s] = sums[0] / norm;
+
+            if (result.variances[s] < this->tolerance)
+                continue;
+            converged = false;
+            if (step == this->maxSteps)
+                continue;
+
+            // the correction d = P^{-1} r, out of the span of the lower states
+            double *d = r;
+            const double longest = 1. / std::max(E - this->minimum, 1e-12);
+            const int cycle = std::max(1, (int) std::ceil(std::log(longest * this->stiffest) / std::log(ratio)));
+            precondition(d, longest * std::pow(ratio, -(double) (step % cycle)));
+            orthogonalize(d, states, s);
+
+            reduce(4, sums, [&](std::size_t first, std::size_t last, double *acc) {
+                std::vector<double> Hd(n0);
+                for (std::size_t line = first; line < last; line++) {
+                    applyLine(d, line, Hd.data());
+                    const std::size_t offset = line * n0;
+                    for (int m = 0; m < n0; m++) {
+                        acc[0] += psi[offset + m] * d[offset + m];
+                        acc[1] += d[offset + m] * d[offset + m];
+                        acc[2] += psi[offset + m] * Hd[m];
+                        acc[3] += d[offset + m] * Hd[m];
+                    }
+                }
+            });
+
+            // the step: lowest Rayleigh quotient on the span of psi and d (psi orthonormalized against d)
+            const double root = std::sqrt(norm);
+            const double overlap = sums[0] / root;
+            const double dd = sums[1] - overlap * overlap;
+            if (!(dd > 1e-28 * sums[1]))
+                continue;
+            const double q = 1. / std::sqrt(dd);
+            const double m11 = E;
+            const double m12 = q * (sums[2] / root - overlap * E);
+            const double m22 = q * q * (sums[3] - 2. * overlap * sums[2] / root + overlap * overlap * E);
+            const double mu = 0.5 * (m11 + m22) - std::hypot(0.5 * (m11 - m22), m12);
+
+            double v0 = m12, v1 = mu - m11;
+            if (std::fabs(mu - m22) + std::fabs(m12) > std::fabs(v0) + std::fabs(v1)) {
+                v0 = mu - m22;
+                v1 = m12;
+            }
+            const double length = std::hypot(v0, v1);
+            if (!(length > 0.))
+                continue;
+            v0 /= length;
+            v1 /= length;
+            if (v0 < 0.) {
+                v0 = -v0;
+                v1 = -v1;
+            }
+
+            const double alpha = (v0 - v1 * q * overlap) / root;
+            const double beta = v1 * q;
+            forTasks(nparts, [&](std::size_t p) {
+                for (std::size_t i = p * lines / nparts * n0; i < (p + 1) * lines / nparts * n0; i++)
+                    psi[i] = alpha * psi[i] + beta * d[i];
+            });
+            orthogonalize(psi, states, s);
+            normalize(psi);
+            moved = true;
+        }
+
+        if (moved && nstates > 1)
+            rotate(states, work);
+
+        result.steps = step;
+        if (converged || step == this->maxSteps) {
+            result.converged = converged;
+            break;
+        }
+    }
+
+    // ascending energies, states normalized with the volume element
+    std::vector<int> order(nstates);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return result.energies[a] < result.energies[b]; });
+    Result sorted;
+    sorted.steps = result.steps;
+    sorted.converged = result.converged;
+    sorted.energies.resize(nstates);
+    sorted.variances.resize(nstates);
+    sorted.states.resize(nstates);
+    const double scale = 1. / std::sqrt(this->volume);
+    for (int s = 0; s < nstates; s++) {
+        sorted.energies[s] = result.energies[order[s]];
+        sorted.variances[s] = result.variances[order[s]];
+        sorted.states[s] = std::move(result.states[order[s]]);
+        for (double &value : sorted.states[s])
+            value *= scale;
+    }
+
+    if (!sorted.converged)
+        std::cout << "# imaginary time: energy variance above " << this->tolerance << " after " << sorted.steps << " steps" << std::endl;
+    return sorted;
+}
@@ -0,0 +1,93 @@
+#ifndef IMAGINARYTIME_H
+#define IMAGINARYTIME_H
+
+#include <cstddef>
+#include <vector>
+
+#include <Base.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! Lowest states of the hard wall problem on a 1D, 2D or 3D Cartesian Base, by imaginary time propagation:
+ * psi <- psi - t P^{-1} (H - E) psi, then Gram-Schmidt against the lower states, until the energy variance
+ * <psi|(H - E)^2|psi> of every state is below the tolerance. H is the second order finite difference Laplacian
+ * plus the potential; the walls of an axis are x_0 and x_nbox, the unknowns the nbox - 1 points in between.
+ *
+ * P = prod_a (1 + tau (T_a + V_a - min V_a)) is the alternating direction implicit (backward Euler) propagator:
+ * a tridiagonal solve along every grid line, one axis after the other. tau cycles geometrically from
+ * 1 / (E - min V) down to 1 / max T, so that every band of the spectrum is damped by some step of the cycle.
+ * Each step t is the adaptive one: the Rayleigh quotient is minimized over psi and the propagated correction,
+ * so the energy never rises and the fixed point is an exact eigenvector of the discretized H, for any tau.
+ * After each step the states are rotated into the eigenvectors of H on their span (Rayleigh-Ritz).
+ *
+ * The potential is one Potential per axis, built on the coordinates of that axis (nbox values, as for the
+ * 1D solvers), V(x, y, z) = V_x(x) + V_y(y) + V_z(z), optionally plus setValues() on the whole grid. A
+ * separable potential takes no memory beyond its axes, so a state costs one array of the grid: a 512^3 grid
+ * needs 1 GiB per state and 1 GiB of work space.
+ *
+ * Values are stored with axis 0 fastest. The lines of axis 0 are contiguous; the lines of the other axes are
+ * solved in blocks of adjacent lines, the inner loop running across the block, so every cache line loaded
+ * is used in full. Lines and blocks are shared among the threads; sums are reduced in a fixed order, so the
+ * results do not depend on the number of threads.
+ *
+ * ImaginaryTime it(BasisManager::Builder().build(Base::Cartesian, 3, 0.05, 200), {Vx, Vy, Vz}, 8);
+ * ImaginaryTime::Result r = it.setTolerance(1e-10).run(2);
+ */
+class ImaginaryTime {
+public:
+    struct Result {
+        std::vector<double> energies;               // ascending
+        std::vector<double> variances;              // <psi|(H - E)^2|psi> of each state
+        std::vector< std::vector<double> > states;  // on the unknowns, axis 0 fastest; sum |psi|^2 dV = 1
+        int steps;
+        bool converged;
+    };
+
+    //! Energies in the units of config
+    ImaginaryTime(Base base, const std::vector<Potential> &axes, int threads = 1,
+                  const SolverConfig &config = SolverConfig::current());
+
+    //! Adds a non separable term, one value per unknown (axis 0 fastest)
+    ImaginaryTime& setValues(const std::vector<double> &values);
+    //! Largest energy variance of a converged state (default 1e-8)
+    ImaginaryTime& setTolerance(double variance);
+    //! run() stops after this many steps (default 10000)
+    ImaginaryTime& setMaxSteps(int steps);
+    //! Seed of the random starting states
+    ImaginaryTime& setSeed(unsigned int seed);
+
+    //! The lowest states
+    Result run(int states);
+
+    //! Unknowns along each axis
+    const std::vector<int>& getShape() const;
+    std::size_t getPoints() const;
+
+private:
+    int dims;
+    std::vector<int> shape;
+    std::vector<std::size_t> stride;
+    std::size_t points;
+    std::vector<double> mesh;
+    double volume;                         // dV
+    std::vector< std::vector<double> > v;  // potential of each axis on its unknowns
+    std::vector<double> vmin;
+    std::vector<double> extra;             // non separable term, empty if none
+    double minimum;                        // min V
+    double stiffest;                       // largest eigenvalue of the kinetic energy
+    double kinetic;                        // hbar^2 / 2m of the SolverConfig given at construction
+    int threads;
+    double tolerance = 1e-8;
+    int maxSteps = 10000;
+    unsigned int seed = 1;
+
+    template<typename Kernel> void forTasks(std::size_t ntasks, Kernel kernel) const;
+    template<typename Kernel> void reduce(int count, double *sums, Kernel kernel) const;
+    void applyLine(const double *f, std::size_t line, double *out) const;
+    void precondition(double *d, double tau) const;
+    void orthogonalize(double *f, const std::vector< std::vector<double> > &lower, int count) const;
+    void normalize(double *f) const;
+    void rotate(std::vector< std::vector<double> > &states, std::vector<double> &work) const;
+};
+
+#endif
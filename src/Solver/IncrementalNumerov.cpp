@@ -0,0 +1,134 @@
+#include "IncrementalNumerov.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Schroedinger.h"
+
+IncrementalNumerov::IncrementalNumerov(int nbox, int stride, std::size_t bytes)
+{
+    if (nbox < 2)
+        throw std::invalid_argument("IncrementalNumerov needs at least two grid points.");
+    if (stride < 2)
+        throw std::invalid_argument("IncrementalNumerov keeps a state every two grid points at most.");
+    this->nbox     = nbox;
+    this->stride   = stride;
+    this->budget   = bytes;
+}
+
+IncrementalNumerov& IncrementalNumerov::setPotential(const Potential& V)
+{
+    const std::vector<double> &values = V.getValues();
+    if ((int) values.size() < this->nbox)
+        throw std::invalid_argument("The potential holds fewer values than the grid.");
+
+    Potential::Region changed = Potential::changedRegion(this->potential, values);
+    if (changed.empty())
+        return *this;
+
+    // wavefunction[c] depends on the potential up to c: the state at c is kept if c < changed.first
+    std::size_t kept = (changed.first == 0) ? 0 : 2 * ((changed.first - 1) / this->stride);
+    for (auto &entry : this->states) {
+        std::vector<double> &values = entry.second.values;
+        if (values.size() > kept) {
+            this->held -= values.size() - kept;
+            values.resize(kept);
+        }
+    }
+    this->potential = values;
+    return *this;
+}
+
+void IncrementalNumerov::sweep(double Energy, double *wavefunction, const SolverConfig &config)
+{
+    run(Energy, wavefunction, true, config);
+}
+
+void IncrementalNumerov::fullSweep(double Energy, double *wavefunction, const SolverConfig &config)
+{
+    run(Energy, wavefunction, false, config);
+}
+
+void IncrementalNumerov::run(double Energy, double *wavefunction, bool restart, const SolverConfig &config)
+{
+    if (this->potential.empty())
+        throw std::logic_error("IncrementalNumerov: no potential set.");
+
+    // the states hold for the starting values and the mesh and units (SolverConfig) they were swept with
+    const double factor = config.numerovFactor();
+    if (wavefunction[0] != this->start[0] || wavefunction[1] != this->start[1] || factor != this->factor) {
+        clear();
+        this->start[0] = wavefunction[0];
+        this->start[1] = wavefunction[1];
+        this->factor = factor;
+    }
+    auto found = this->states.find(Energy);
+    if (found == this->states.end()) {
+        this->recent.push_front(Energy);
+        found = this->states.emplace(Energy, States{std::vector<double>(), this->recent.begin()}).first;
+    }
+    else
+        this->recent.splice(this->recent.begin(), this->recent, found->second.use);
+    std::vector<double> &kept = found->second.values;
+    const std::size_t before = kept.size();
+
+    int c = 1, from = 2;
+    if (restart && !kept.empty()) {
+        c = (int) (kept.size() / 2) * this->stride;
+        wavefunction[c - 1] = kept[kept.size() - 2];
+        wavefunction[c] = kept[kept.size() - 1];
+        from = c - 1;
+        this->skipped += c - 1;
+    }
+
+    while (c < this->nbox) {
+        int next = std::min(this->nbox, (c / this->stride + 1) * this->stride);
+        step_Numerov(Energy, c + 1, next, from, this->nbox, this->potential.data(), wavefunction, config);
+        this->steps += next - c;
+        c = next;
+
+        if (c % this->stride == 0 && (std::size_t) (c / this->stride) > kept.size() / 2) {
+            kept.push_back(wavefunction[c - 1]);
+            kept.push_back(wavefunction[c]);
+        }
+    }
+    this->held += kept.size() - before;
+    trim();
+}
+
+void IncrementalNumerov::trim()
+{
+    while (this->held * sizeof(double) > this->budget && this->recent.size() > 1) {
+        auto oldest = this->states.find(this->recent.back());
+        this->held -= oldest->second.values.size();
+        this->states.erase(oldest);
+        this->recent.pop_back();
+    }
+}
+
+void IncrementalNumerov::clear()
+{
+    this->states.clear();
+    this->recent.clear();
+    this->held = 0;
+}
+
+int IncrementalNumerov::getNbox() const
+{
+    return this->nbox;
+}
+
+unsigned long IncrementalNumerov::getSteps() const
+{
+    return this->steps;
+}
+
+unsigned long IncrementalNumerov::getSkipped() const
+{
+    return this->skipped;
+}
+
+std::size_t IncrementalNumerov::getBytes() const
+{
+    return this->held * sizeof(double);
+}
@@ -0,0 +1,77 @@
+#ifndef INCREMENTALNUMEROV_H
+#define INCREMENTALNUMEROV_H
+
+#include <cmath>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! IncrementalNumerov solves a sequence of potentials that differ in part of the grid only (a localized
+ * perturbation moved or scaled, the width of a well...). The Numerov sweep runs left to right, so at a given
+ * energy the sweep before the first changed grid point (Potential::changedFrom) is the same as for the
+ * previous potential.
+ *
+ * For every energy it sweeps, IncrementalNumerov keeps the state of the sweep (wavefunction[c - 1], wavefunction[c])
+ * every stride grid points. When the potential changes, the states after its first change are dropped, and
+ * the next sweep at that energy restarts from the last state left. The scan energies Emin + n Estep of
+ * solve_Numerov are the same from one solve to the next, so most of the scan is restarted. The results are
+ * the same, bit for bit, as those of fsol_Numerov and solve_Numerov.
+ *
+ * The states take 2 nbox / stride values per energy; at most bytes of them are kept (64 MiB by default, whatever
+ * the grid: fewer energies on a finer one), the least recently swept energies being dropped first. The energy
+ * being swept is always kept.
+ *
+ * IncrementalNumerov incremental(nbox);
+ * for (double w : widths) {
+ *     V = Potential::Builder(x).setType("well").setWidth(w).build(V);
+ *     E = solve_Numerov(Emin, Emax, Estep, nbox, V, wavefunction, incremental);
+ * }
+ */
+class IncrementalNumerov {
+public:
+    explicit IncrementalNumerov(int nbox, int stride = 32, std::size_t bytes = std::size_t(64) << 20);
+
+    //! Potential of the next sweeps: the states after its first change from the previous one are dropped
+    IncrementalNumerov& setPotential(const Potential& V);
+    /*! Sweep at Energy: wavefunction[nbox] is that of fsol_Numerov, but only the points from the restart on
+     * are written. wavefunction[0], wavefunction[1] hold the starting values, as for fsol_Numerov.
+     */
+    void sweep(double Energy, double *wavefunction, const SolverConfig &config = SolverConfig::current());
+    //! Sweep at Energy from the left wall, every point written (as fsol_Numerov)
+    void fullSweep(double Energy, double *wavefunction, const SolverConfig &config = SolverConfig::current());
+    void clear();
+
+    int getNbox() const;
+    //! Numerov steps done, and steps skipped by the restarts
+    unsigned long getSteps() const;
+    unsigned long getSkipped() const;
+    //! Memory held by the states
+    std::size_t getBytes() const;
+
+private:
+    int nbox;
+    int stride;
+    std::size_t budget;   // bytes
+    std::vector<double> potential;
+    double start[2] = {NAN, NAN};
+    double factor = NAN;  // SolverConfig::numerovFactor of the states
+
+    struct States {
+        std::vector<double> values;       // wavefunction[c - 1], wavefunction[c] for c = stride, 2 stride, ...
+        std::list<double>::iterator use;  // in recent
+    };
+    std::unordered_map<double, States> states;
+    std::list<double> recent;  // energies, most recently swept first
+    std::size_t held = 0;      // values of all the states
+    unsigned long steps = 0, skipped = 0;
+
+    void run(double Energy, double *wavefunction, bool restart, const SolverConfig &config);
+    //! Drops the least recently swept energies beyond the budget
+    void trim();
+};
+
+#endif
@@ -0,0 +1,263 @@
+#include "Observables.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include <MappedBlock.h>
+
+#include "Schroedinger.h"
+
+namespace {
+    const int lanes = 4;           // independent compensated sums, so that the loops vectorize
+    const int chunk = 2048;        // grid points per chunk of expectation values
+    const int tile = 512;          // grid points per tile of matrix elements
+    const int max_parts = 64;      // fixed reduction tree: the result does not depend on threads
+
+    // Neumaier compensated sum, used to combine lanes, chunks and parts
+    struct CompensatedSum {
+        double sum = 0., c = 0.;
+
+        void add(double y) {
+            double t = sum + y;
+            if (std::fabs(sum) >= std::fabs(y))
+                c += (sum - t) + y;
+            else
+                c += (y - t) + sum;
+            sum = t;
+        }
+        double value() const { return sum + c; }
+    };
+
+    inline void kahan(double &s, double &c, double y) {
+        y -= c;
+        double t = s + y;
+        c = (t - s) - y;
+        s = t;
+    }
+
+    // Compensated \sum a[k] b[k] over [0, n)
+    double dot(const double *a, const double *b, int n) {
+        double s[lanes] = {0.}, c[lanes] = {0.};
+        int k = 0;
+        for (; k + lanes <= n; k += lanes)
+            for (int l = 0; l < lanes; l++)
+                kahan(s[l], c[l], a[k + l] * b[k + l]);
+        for (; k < n; k++)
+            kahan(s[0], c[0], a[k] * b[k]);
+
+        CompensatedSum total;
+        for (int l = 0; l < lanes; l++) {
+            total.add(s[l]);
+            total.add(-c[l]);
+        }
+        return total.value();
+    }
+}
+
+Observables::Observables(ContinuousBase base, const Potential &V, Quadrature rule, int threads,
+                         const SolverConfig &config)
+{
+    this->nbox    = (int) base.getNbox();
+    this->start   = base.getStart();
+    this->mesh    = base.getMesh();
+    this->kinetic = config.kineticFactor();
+    this->threads = std::max(1, threads);
+
+    const std::vector<double> &values = V.getValues();
+    if (this->nbox < 2 || (int) values.size() < this->nbox)
+        throw std::invalid_argument("Observables: the potential does not cover the basis grid.");
+
+    this->x.resize(nbox + 1);
+    this->v.resize(nbox + 1);
+    for (int i = 0; i <= nbox; i++) {
+        this->x[i] = this->start + i * this->mesh;
+        this->v[i] = values[std::min(i, nbox - 1)];
+    }
+
+    this->weights.assign(nbox + 1, mesh);
+    if (rule == Simpson) {
+        // Simpson needs an even number of intervals: an odd last one is taken with the trapezoid
+        int even = nbox - nbox % 2;
+        for (int i = 0; i <= even; i++)
+            this->weights[i] = mesh / 3. * ((i == 0 || i == even) ? 1. : (i % 2 ? 4. : 2.));
+        if (even != nbox) {
+            this->weights[even] += mesh / 2.;
+            this->weights[nbox] = mesh / 2.;
+        }
+    }
+    else if (rule == Trapezoid) {
+        this->weights[0] = this->weights[nbox] = mesh / 2.;
+    }
+    else throw std::invalid_argument("Observables: unknown quadrature rule.");
+}
+
+/*! Splits nchunks in at most max_parts contiguous parts and runs kernel(part, first chunk, end chunk)
+on the worker threads; parts are always the same, whatever the number of threads.
+*/
+template<typename Kernel>
+void Observables::forChunks(int nchunks, Kernel kernel)
+{
+    int nparts = std::min(max_parts, nchunks);
+    std::atomic<int> next(0);
+
+    auto worker = [&]() {
+        for (int p = next++; p < nparts; p = next++)
+            kernel(p, (int) ((long) p * nchunks / nparts), (int) ((long) (p + 1) * nchunks / nparts));
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < std::min(this->threads, nparts); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool)
+        t.join();
+}
+
+std::vector<Observables::Expectation> Observables::expectationValues(const std::vector<const double *> &states)
+{
+    const int nstates = (int) states.size();
+    const int npoints = nbox + 1;
+    const int nchunks = (npoints + chunk - 1) / chunk;
+    const int nparts = std::min(max_parts, nchunks);
+    const double kinetic = -this->kinetic / (mesh * mesh);
+
+    // partial sums: [part][state][quantity]
+    std::vector<CompensatedSum> partial((std::size_t) nparts * nstates * 5);
+
+    forChunks(nchunks, [&](int part, int first, int last) {
+        for (int s = 0; s < nstates; s++) {
+            const double *psi = states[s];
+            CompensatedSum *acc = &partial[((std::size_t) part * nstates + s) * 5];
+
+            for (int ch = first; ch < last; ch++) {
+                int lo = ch * chunk, hi = std::min(npoints, lo + chunk);
+                double sum[5][lanes] = {{0.}}, comp[5][lanes] = {{0.}};
+
+                // the walls have no Laplacian term (and psi = 0 there for the solvers' states)
+                int i = std::max(lo, 1), end = std::min(hi, nbox);
+                for (; i + lanes <= end; i += lanes) {
+                    for (int l = 0; l < lanes; l++) {
+                        int k = i + l;
+                        double rho = weights[k] * psi[k] * psi[k];
+                        double lap = psi[k + 1] - 2. * psi[k] + psi[k - 1];
+                        kahan(sum[0][l], comp[0][l], rho);
+                        kahan(sum[1][l], comp[1][l], rho * x[k]);
+                        kahan(sum[2][l], comp[2][l], rho * x[k] * x[k]);
+                        kahan(sum[3][l], comp[3][l], rho * v[k]);
+                        kahan(sum[4][l], comp[4][l], weights[k] * psi[k] * lap);
+                    }
+                }
+                for (; i < end; i++) {
+                    double rho = weights[i] * psi[i] * psi[i];
+                    kahan(sum[0][0], comp[0][0], rho);
+                    kahan(sum[1][0], comp[1][0], rho * x[i]);
+                    kahan(sum[2][0], comp[2][0], rho * x[i] * x[i]);
+                    kahan(sum[3][0], comp[3][0], rho * v[i]);
+                    kahan(sum[4][0], comp[4][0], weights[i] * psi[i] * (psi[i + 1] - 2. * psi[i] + psi[i - 1]));
+                }
+                for (int k : {0, nbox}) {
+                    if (k < lo || k >= hi)
+                        continue;
+                    double rho = weights[k] * psi[k] * psi[k];
+                    kahan(sum[0][0], comp[0][0], rho);
+                    kahan(sum[1][0], comp[1][0], rho * x[k]);
+                    kahan(sum[2][0], comp[2][0], rho * x[k] * x[k]);
+                    kahan(sum[3][0], comp[3][0], rho * v[k]);
+                }
+
+                for (int q = 0; q < 5; q++) {
+                    for (int l = 0; l < lanes; l++) {
+                        acc[q].add(sum[q][l]);
+                        acc[q].add(-comp[q][l]);
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<Expectation> result(nstates);
+    for (int s = 0; s < nstates; s++) {
+        double total[5];
+        for (int q = 0; q < 5; q++) {
+            CompensatedSum t;
+            for (int p = 0; p < nparts; p++)
+                t.add(partial[((std::size_t) p * nstates + s) * 5 + q].value());
+            total[q] = t.value();
+        }
+        Expectation &e = result[s];
+        e.norm = total[0];
+        e.x    = total[1] / total[0];
+        e.x2   = total[2] / total[0];
+        e.V    = total[3] / total[0];
+        e.T    = kinetic * total[4] / total[0];
+    }
+    return result;
+}
+
+std::vector<double> Observables::matrixElements(const std::vector<const double *> &states, const std::vector<double> &O)
+{
+    const int nstates = (int) states.size();
+    const int npoints = nbox + 1;
+    const int ntiles = (npoints + tile - 1) / tile;
+    const int nparts = std::min(max_parts, ntiles);
+
+    if ((int) O.size() < nbox)
+        throw std::invalid_argument("Observables: the operator does not cover the basis grid.");
+
+    std::vector<CompensatedSum> partial((std::size_t) nparts * nstates * nstates);
+
+    forChunks(ntiles, [&](int part, int first, int last) {
+        std::vector<double> weighted(tile);
+        CompensatedSum *acc = &partial[(std::size_t) part * nstates * nstates];
+
+        for (int t = first; t < last; t++) {
+            int lo = t * tile, n = std::min(npoints, lo + tile) - lo;
+            // every state of the tile is read from memory once, the pairs are then done in cache
+            for (int i = 0; i < nstates; i++) {
+                for (int k = 0; k < n; k++)
+                    weighted[k] = weights[lo + k] * O[std::min(lo + k, nbox - 1)] * states[i][lo + k];
+                for (int j = i; j < nstates; j++)
+                    acc[(std::size_t) i * nstates + j].add(dot(weighted.data(), states[j] + lo, n));
+            }
+        }
+    });
+
+    std::vector<double> result((std::size_t) nstates * nstates);
+    for (int i = 0; i < nstates; i++) {
+        for (int j = i; j < nstates; j++) {
+            CompensatedSum t;
+            for (int p = 0; p < nparts; p++)
+                t.add(partial[((std::size_t) p * nstates + i) * nstates + j].value());
+            result[(std::size_t) i * nstates + j] = result[(std::size_t) j * nstates + i] = t.value();
+        }
+    }
+    return result;
+}
+
+std::vector<Observables::Expectation> Observables::expectationValues(MappedBlock &states, std::size_t window)
+{
+    if (states.getColumns() < (std::size_t) nbox + 1)
+        throw std::invalid_argument("The rows of the block are shorter than the grid.");
+    window = std::max<std::size_t>(window, 1);
+
+    std::vector<Expectation> result;
+    states.prefetch(0, window);
+    for (std::size_t first = 0; first < states.getRows(); first += window) {
+        std::size_t last = std::min(first + window, states.getRows());
+        states.prefetch(last, last + window);
+        std::vector<const double *> rows;
+        for (std::size_t r = first; r < last; r++)
+            rows.push_back(states.row(r));
+        for (const Expectation &e : expectationValues(rows))
+            result.push_back(e);
+        states.evict(first, last);
+    }
+    return result;
+}
+
+double Observables::norm(const double *state)
+{
+    return expectationValues(std::vector<const double *>(1, state))[0].norm;
+}
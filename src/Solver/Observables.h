@@ -0,0 +1,62 @@
+#ifndef OBSERVABLES_H
+#define OBSERVABLES_H
+
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+class MappedBlock;
+
+/*! Observables of whole sets of eigenstates, computed in fused passes.
+ *
+ * A state is an array of nbox + 1 values on the grid of base (index nbox is the right wall), as
+ * written by the solvers. Every state is read once for all of its expectation values, and once per
+ * grid tile for all the matrix elements it takes part in.
+ *
+ * The grid is split in fixed size chunks, summed with compensated (Kahan) sums in independent lanes,
+ * and the chunk partials are reduced in chunk order: results do not depend on the number of threads.
+ */
+
+class Observables {
+public:
+    enum Quadrature { Trapezoid = 0, Simpson = 1 };
+
+    struct Expectation {
+        double norm; // \int |psi|^2
+        double x;    // <x>, <x^2>, <V>, <T> are divided by norm
+        double x2;
+        double V;
+        double T;
+    };
+
+    //! <T> in the units of config
+    Observables(ContinuousBase base, const Potential &V, Quadrature rule = Simpson, int threads = 1,
+                const SolverConfig &config = SolverConfig::current());
+
+    //! Norm, <x>, <x^2>, <V> and <T> of every state, one pass over each.
+    std::vector<Expectation> expectationValues(const std::vector<const double *> &states);
+    /*! The same for the rows of a block on disk, window rows at a time: each window is prefetched while the
+     * previous one is summed, and evicted after, so that a block larger than memory is read once.
+     */
+    std::vector<Expectation> expectationValues(MappedBlock &states, std::size_t window = 16);
+    /*! <i|O|j> for every pair of states, O a local operator given on the grid (nbox values).
+     * Returned as a symmetric n x n matrix, row major.
+     */
+    std::vector<double> matrixElements(const std::vector<const double *> &states, const std::vector<double> &O);
+    //! \int |psi|^2 of a single state
+    double norm(const double *state);
+
+private:
+    int nbox;
+    double start, mesh;
+    double kinetic;               // hbar^2 / 2m of the SolverConfig given at construction
+    std::vector<double> weights;  // quadrature weights, nbox + 1
+    std::vector<double> x, v;     // coordinates and potential on the nbox + 1 points
+    int threads;
+
+    template<typename Kernel> void forChunks(int nchunks, Kernel kernel);
+};
+
+#endif
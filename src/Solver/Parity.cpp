@@ -0,0 +1,141 @@
+#include "Parity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include "Bracketing.h"
+#include "Schroedinger.h"
+
+namespace {
+    /*! The half sweep of a sector ends at last, the first point past the center x_{nbox / 2}; mirror is its
+    reflection nbox - last. A level of parity p has psi[last] = p psi[mirror], for odd and even nbox alike.
+    */
+    struct Half {
+        int nbox, last, mirror, parity;
+        Half(int nbox, int parity) : nbox(nbox), last(nbox / 2 + 1), mirror(nbox - (nbox / 2 + 1)), parity(parity) {}
+    };
+
+    /*! psi[last] - p psi[mirror], zero at the levels of the sector, from an energy only half sweep (mirror is
+    last - 2 or last - 1, in the tail of the sweep); nodes, if not null, gets the sign changes of psi[1 .. last - 1]
+    followed by the mismatch. The mismatch is the last pivot of the half problem with the symmetry imposed at the
+    center, so, as for count_nodes_Numerov, this is a Sturm count of the levels of the sector below Energy.
+    */
+    double shoot(double Energy, const Half &h, const double *potential, const double *wavefunction,
+                 const SolverConfig &config, int *nodes = nullptr) {
+        double tail[3];
+        int changes = 0;
+        shoot_Numerov<double>(Energy, h.last, h.nbox, potential, wavefunction[0], wavefunction[1], &changes, tail, config);
+        double mismatch = tail[2] - h.parity * tail[2 - (h.last - h.mirror)];
+
+        if (nodes) {
+            // the sign psi[1 .. last - 1] ends with (psi[last - 1] is zero only by accident)
+            bool positive = (tail[1] != 0) ? tail[1] > 0 : tail[0] > 0;
+            if (tail[2] != 0 && (tail[2] > 0) != positive)
+                changes--;
+            if (mismatch != 0 && (mismatch > 0) != positive)
+                changes++;
+            *nodes = changes;
+        }
+        return mismatch;
+    }
+
+    void check_parity(int parity, int nbox, const Potential &V) {
+        if (parity != 1 && parity != -1)
+            throw std::invalid_argument("The parity must be 1 (even) or -1 (odd).");
+        if (nbox < 4)
+            throw std::invalid_argument("The parity reduction needs at least four grid points.");
+        if ((int) V.getValues().size() < nbox)
+            throw std::invalid_argument("The potential holds fewer values than the grid.");
+    }
+}
+
+bool is_symmetric(int nbox, const Potential &V, double tolerance) {
+    const std::vector<double> &potential = V.getValues();
+    if (nbox < 4 || (int) potential.size() < nbox)
+        return false;
+
+    double scale = 1.;
+    for (int i = 1; i < nbox; i++)
+        scale = std::max(scale, std::fabs(potential[i]));
+    for (int i = 1; i < nbox / 2 + 1; i++) {
+        if (std::fabs(potential[i] - potential[nbox - i]) > tolerance * scale)
+            return false;
+    }
+    return true;
+}
+
+double solve_Numerov_parity(int n, int parity, int nbox, const Potential &V, double *wavefunction, int *sweeps,
+                            double guess, const SolverConfig &config) {
+    check_parity(parity, nbox, V);
+    const double *potential = V.getValues().data();
+    Half h(nbox, parity);
+
+    EnergyBracket b = bracket_levels(n, 2 * n + (parity < 0), nbox, V, [&](double Energy) {
+        int nodes;
+        shoot(Energy, h, potential, wavefunction, config, &nodes);
+        return nodes;
+    }, guess, NAN, config);
+    int count = b.sweeps;
+    double Energy = refine_zero(b.Emin, b.Emax, [&](double E) {
+        return shoot(E, h, potential, wavefunction, config);
+    }, &count, config);
+
+    step_Numerov<double>(Energy, 2, h.last, 2, nbox, potential, wavefunction, config);
+    count++;
+    for (int i = nbox / 2 + 1; i <= nbox; i++)
+        wavefunction[i] = parity * wavefunction[nbox - i];
+
+    std::vector<double> probab(nbox + 1);
+    for (int i = 0; i <= nbox; i++)
+        probab[i] = wavefunction[i] * wavefunction[i];
+    double norm = trap_array(0, nbox, config.getMesh(), probab.data());
+    for (int i = 0; i <= nbox; i++)
+        wavefunction[i] = wavefunction[i] / sqrt(norm);
+
+    if (sweeps)
+        *sweeps += count;
+    return Energy;
+}
+
+Spectrum solve_Numerov_symmetric(int levels, int nbox, const Potential &V, bool wavefunctions,
+                                 const std::vector<double> &guesses, const SolverConfig &config) {
+    if (levels < 1)
+        throw std::invalid_argument("solve_Numerov_symmetric needs at least one level.");
+    check_parity(1, nbox, V);
+
+    // [0] even, [1] odd; the even sector has the ground state, so one level more when levels is odd
+    Spectrum sector[2];
+    int sweeps[2] = {0, 0};
+    // the odd sector runs on its own thread: config is handed to it, not the current one of that thread
+    auto solve = [&](int s) {
+        std::vector<double> psi(nbox + 1);
+        for (int n = 0; n < (levels + 1 - s) / 2; n++) {
+            psi[0] = 0.;
+            psi[1] = 0.01;
+            std::size_t level = 2 * n + s;
+            double guess = (level < guesses.size()) ? guesses[level] : NAN;
+            sector[s].energies.push_back(solve_Numerov_parity(n, s ? -1 : 1, nbox, V, psi.data(), &sweeps[s], guess, config));
+            if (wavefunctions)
+                sector[s].wavefunctions.push_back(psi);
+        }
+    };
+
+    std::thread odd;
+    if (levels > 1)
+        odd = std::thread(solve, 1);
+    solve(0);
+    if (odd.joinable())
+        odd.join();
+
+    Spectrum spectrum;
+    for (int n = 0; n < levels; n++) {
+        spectrum.energies.push_back(sector[n % 2].energies[n / 2]);
+        if (wavefunctions)
+            spectrum.wavefunctions.push_back(std::move(sector[n % 2].wavefunctions[n / 2]));
+    }
+    std::cout << "# parity sectors: " << levels << " levels, half sweeps = " << sweeps[0] << " even, "
+              << sweeps[1] << " odd" << std::endl;
+    return spectrum;
+}
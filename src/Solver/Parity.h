@@ -0,0 +1,41 @@
+#ifndef PARITY_H
+#define PARITY_H
+
+#include <cmath>
+#include <vector>
+
+#include <Potential.h>
+#include "SolverConfig.h"
+#include "Spectrum.h"
+
+/*! Parity reduction of the Numerov problem for potentials symmetric about the center of the grid, as the
+ * built-in shapes are on a ContinuousBase(mesh, nbox): V[i] = V[nbox - i], walls at 0 and nbox.
+ *
+ * The levels are then alternately even (psi[nbox - i] = psi[i]) and odd (psi[nbox - i] = -psi[i]), so each
+ * parity sector is solved on the left half of the grid only: the sweep stops one point past the center, where
+ * the even levels have psi' = 0 and the odd ones psi = 0. The half sweeps are half as long, the levels of a
+ * sector are twice as far apart, and the energies are those of the full grid, since the discretized full
+ * problem splits exactly into the two sectors.
+ */
+
+//! Whether V[i] and V[nbox - i] agree for 0 < i < nbox, to tolerance times the largest |V| (at least 1)
+bool is_symmetric(int nbox, const Potential &V, double tolerance = 1e-9);
+
+/*! Level n (0 is the lowest) of the sector of parity +1 (even) or -1 (odd); it is level 2n or 2n + 1 of V.
+ * The sweeps read only the left half of V, V is taken to be symmetric. The wavefunction (nbox + 1 values) is
+ * completed by reflection and normalized to 1 as in solve_Numerov_level; sweeps, if not null, is increased
+ * by the number of half sweeps done. guess (if not NaN) replaces the WKB estimate of the level.
+ */
+double solve_Numerov_parity(int n, int parity, int nbox, const Potential &V, double *wavefunction,
+                            int *sweeps = nullptr, double guess = NAN,
+                            const SolverConfig &config = SolverConfig::current());
+
+/*! The lowest levels of a symmetric V: the two sectors are solved concurrently, each on its own thread,
+ * and their levels interleaved (even, odd, even ...). guesses, if given, holds an estimate of each level (or NaN).
+ * Both threads solve with config, that of the calling thread if it is left out.
+ */
+Spectrum solve_Numerov_symmetric(int levels, int nbox, const Potential &V, bool wavefunctions = true,
+                                 const std::vector<double> &guesses = {},
+                                 const SolverConfig &config = SolverConfig::current());
+
+#endif
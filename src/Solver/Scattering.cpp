@@ -0,0 +1,210 @@
+#include "Scattering.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <thread>
+
+#include "Schroedinger.h"
+
+namespace {
+    // the amplitudes are rescaled by 1 / big when they grow past it, e.g. through thick barriers
+    const double big = 1e100;
+    const int rescale_every = 64;
+
+    /*! Phase per grid step of the discrete plane waves of a lead (phi_{j+1} + phi_{j-1} = 2 cos(theta) phi_j),
+    false if the lead is closed at this energy.
+    */
+    bool lead_phase(double c, double f, double &cosine, double &sine) {
+        cosine = (1. - 5. * c * f) / (1. + c * f);
+        if (!(f > 0.) || std::fabs(cosine) >= 1.)
+            return false;
+        sine = std::sqrt(1. - cosine * cosine);
+        return true;
+    }
+}
+
+Scattering::Scattering(ContinuousBase base, const Potential &V, int threads, const SolverConfig &config)
+{
+    this->nbox    = (int) base.getNbox();
+    this->mesh    = base.getMesh();
+    this->units   = 2. * config.getMass() / config.getHbar() / config.getHbar();
+    this->threads = std::max(1, threads);
+    if (this->nbox < 2 || !(this->mesh > 0.))
+        throw std::invalid_argument("Scattering needs a grid of at least two points and a positive mesh.");
+    if ((int) V.getValues().size() < this->nbox)
+        throw std::invalid_argument("The potential holds fewer values than the grid.");
+    this->v.assign(V.getValues().begin(), V.getValues().begin() + this->nbox);
+}
+
+Scattering& Scattering::setTolerance(double tolerance)
+{
+    if (!(tolerance > 0.))
+        throw std::invalid_argument("The tolerance must be positive.");
+    this->tolerance = tolerance;
+    return *this;
+}
+
+Scattering& Scattering::setMaxPoints(int points)
+{
+    if (points < 2)
+        throw std::invalid_argument("At least two energies.");
+    this->maxPoints = points;
+    return *this;
+}
+
+/*! phi_j = (1 + c f_j) psi_j obeys phi_{j-1} = g_j phi_j - phi_{j+1}, g_j = 2 (1 - 5 c f_j) / (1 + c f_j), whose
+Wronskian Im(phi_j* phi_{j+1}) is the conserved flux. From phi = e^{i theta_R (j - nbox)} in the right lead, the
+recurrence runs down to j = -1 in the left lead, where phi = A e^{i theta_L j} + B e^{-i theta_L j}:
+T = sin(theta_R) / (|A|^2 sin(theta_L)), R = |B / A|^2.
+*/
+void Scattering::solveBatch(const double *energies, int count, double *T, double *R) const
+{
+    const double c = this->units * (this->mesh * this->mesh / 12.);
+    const double VL = this->v.front(), VR = this->v.back();
+    const double *potential = this->v.data();
+
+    double E[lanes], cosL[lanes], sinL[lanes], cosR[lanes], sinR[lanes];
+    double prev_re[lanes], prev_im[lanes], cur_re[lanes], cur_im[lanes];
+    int rescaled[lanes];
+    bool open[lanes];
+
+    for (int l = 0; l < lanes; l++) {
+        E[l] = energies[std::min(l, count - 1)];  // spare lanes repeat the last energy
+        open[l] = lead_phase(c, E[l] - VL, cosL[l], sinL[l]) && lead_phase(c, E[l] - VR, cosR[l], sinR[l]);
+        if (!open[l])
+            cosR[l] = sinR[l] = 0.;
+        prev_re[l] = 1.;
+        prev_im[l] = 0.;
+        cur_re[l] = cosR[l];
+        cur_im[l] = -sinR[l];
+        rescaled[l] = 0;
+    }
+
+    for (int j = this->nbox - 1; j >= 0; j--) {
+        const double V = potential[j];
+        for (int l = 0; l < lanes; l++) {
+            double f = E[l] - V;
+            double g = 2. * (1. - 5. * c * f) / (1. + c * f);
+            double next_re = g * cur_re[l] - prev_re[l];
+            double next_im = g * cur_im[l] - prev_im[l];
+            prev_re[l] = cur_re[l];
+            prev_im[l] = cur_im[l];
+            cur_re[l] = next_re;
+            cur_im[l] = next_im;
+        }
+        if (j % rescale_every == 0) {
+            for (int l = 0; l < lanes; l++) {
+                if (std::fabs(cur_re[l]) + std::fabs(cur_im[l]) > big) {
+                    prev_re[l] /= big;
+                    prev_im[l] /= big;
+                    cur_re[l] /= big;
+                    cur_im[l] /= big;
+                    rescaled[l]++;
+                }
+            }
+        }
+    }
+
+    for (int l = 0; l < count; l++) {
+        if (!open[l]) {
+            T[l] = 0.;
+            R[l] = 1.;
+            continue;
+        }
+        // prev is phi_0, cur is phi_{-1}
+        std::complex<double> phi0(prev_re[l], prev_im[l]), phi1(cur_re[l], cur_im[l]);
+        std::complex<double> A = (phi0 * std::complex<double>(cosL[l], sinL[l]) - phi1)
+                                 / std::complex<double>(0., 2. * sinL[l]);
+        std::complex<double> B = phi0 - A;
+        double A2 = std::norm(A);
+        T[l] = sinR[l] / (A2 * sinL[l]) * std::pow(big, -2. * rescaled[l]);
+        R[l] = std::norm(B) / A2;
+    }
+}
+
+Scattering::Transmission Scattering::transmission(const std::vector<double> &energies) const
+{
+    Transmission t;
+    const int n = (int) energies.size();
+    t.energies = energies;
+    t.transmission.resize(n);
+    t.reflection.resize(n);
+
+    const int nbatches = (n + lanes - 1) / lanes;
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int b = next++; b < nbatches; b = next++) {
+            int first = b * lanes;
+            solveBatch(&t.energies[first], std::min(lanes, n - first), &t.transmission[first], &t.reflection[first]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < std::min(this->threads, nbatches); i++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+        thread.join();
+    return t;
+}
+
+Scattering::Transmission Scattering::spectrum(double Emin, double Emax, int points) const
+{
+    if (!(Emax > Emin) || points < 2)
+        throw std::invalid_argument("spectrum needs Emin < Emax and at least two energies.");
+    points = std::min(points, this->maxPoints);
+
+    std::vector<double> energies(points);
+    for (int i = 0; i < points; i++)
+        energies[i] = Emin + (Emax - Emin) * i / (points - 1);
+    Transmission all = transmission(energies);
+
+    // intervals [a, b] to check, as indices into all; each round solves all their midpoints at once
+    std::vector< std::pair<int, int> > check;
+    for (int i = 0; i + 1 < points; i++)
+        check.emplace_back(i, i + 1);
+    const double narrowest = 1e-12 * std::max(std::fabs(Emin), std::fabs(Emax));
+
+    while (!check.empty() && (int) all.energies.size() < this->maxPoints) {
+        std::size_t room = this->maxPoints - all.energies.size();
+        if (check.size() > room)
+            check.resize(room);
+
+        std::vector<double> middles;
+        for (auto &ab : check)
+            middles.push_back((all.energies[ab.first] + all.energies[ab.second]) / 2.);
+        Transmission m = transmission(middles);
+
+        std::vector< std::pair<int, int> > refine;
+        for (std::size_t k = 0; k < check.size(); k++) {
+            int a = check[k].first, b = check[k].second, middle = (int) all.energies.size();
+            all.energies.push_back(m.energies[k]);
+            all.transmission.push_back(m.transmission[k]);
+            all.reflection.push_back(m.reflection[k]);
+
+            double linear = (all.transmission[a] + all.transmission[b]) / 2.;
+            if (std::fabs(m.transmission[k] - linear) > this->tolerance
+                && all.energies[b] - all.energies[a] > narrowest) {
+                refine.emplace_back(a, middle);
+                refine.emplace_back(middle, b);
+            }
+        }
+        check.swap(refine);
+    }
+
+    std::vector<int> order(all.energies.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+        order[i] = (int) i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return all.energies[a] < all.energies[b]; });
+
+    Transmission sorted;
+    for (int i : order) {
+        sorted.energies.push_back(all.energies[i]);
+        sorted.transmission.push_back(all.transmission[i]);
+        sorted.reflection.push_back(all.reflection[i]);
+    }
+    return sorted;
+}
@@ -0,0 +1,63 @@
+#ifndef SCATTERING_H
+#define SCATTERING_H
+
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! Transmission and reflection through the potential on the grid of base, between two leads that continue its
+ * first and last values (e.g. a barrier: a finite well of negative height, or any custom profile).
+ *
+ * At every energy the Numerov recurrence is run from the right lead, where only the transmitted wave e^{ikx}
+ * is present, to the left one, where the solution is split into the incoming and reflected waves. The waves of
+ * the leads are those of the discrete recurrence, and the flux is its conserved Wronskian, so that R + T = 1
+ * to rounding for any mesh. Below the bottom of either lead T = 0 and R = 1.
+ *
+ * Energies are solved in batches of lanes, one recurrence step for the whole batch at a time (the inner loop
+ * vectorizes), and the batches are shared among the threads. spectrum() samples an energy window evenly,
+ * then bisects the intervals where T is not linear to within the tolerance, so that narrow resonances are
+ * resolved without a fine grid everywhere.
+ *
+ * Scattering s(ContinuousBase(0.01, 2000), V, 4);
+ * Scattering::Transmission t = s.setTolerance(1e-4).spectrum(0., 2., 200);
+ */
+
+class Scattering {
+public:
+    static constexpr int lanes = 8;
+
+    struct Transmission {
+        std::vector<double> energies;      // as asked; ascending from spectrum()
+        std::vector<double> transmission;  // T(E)
+        std::vector<double> reflection;    // R(E)
+    };
+
+    //! Energies in the units of config
+    Scattering(ContinuousBase base, const Potential &V, int threads = 1,
+               const SolverConfig &config = SolverConfig::current());
+
+    //! Largest |T(midpoint) - linear interpolation| left by spectrum() (default 1e-3)
+    Scattering& setTolerance(double tolerance);
+    //! spectrum() stops refining at this many energies (default 100000)
+    Scattering& setMaxPoints(int points);
+
+    //! T and R at the given energies, in their order
+    Transmission transmission(const std::vector<double> &energies) const;
+    //! points energies evenly spaced in [Emin, Emax], refined around the features of T(E)
+    Transmission spectrum(double Emin, double Emax, int points) const;
+
+private:
+    int nbox;
+    double mesh;
+    double units;  // 2 m / hbar^2 of the SolverConfig given at construction
+    std::vector<double> v;
+    int threads;
+    double tolerance = 1e-3;
+    int maxPoints = 100000;
+
+    void solveBatch(const double *energies, int count, double *T, double *R) const;
+};
+
+#endif
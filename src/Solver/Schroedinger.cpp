@@ -1,9 +1,25 @@
 #include "Schroedinger.h"
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "IncrementalNumerov.h"
+
+namespace {
+    // per thread, so that counting costs nothing to concurrent solves
+    thread_local unsigned long sweep_count = 0;
+}
+
+unsigned long numerov_sweeps() {
+    return sweep_count;
+}
+
 /*! Integrate with the trapezoidal rule method, from a to b position in a function array
 */
-double trap_array(int a, int b, double stepx, double *func) {
-    double trapez_sum = 0.;
+template<typename Real>
+Real trap_array(int a, int b, Real stepx, const Real *func) {
+    Real trapez_sum = 0.;
 
     for (int j = a + 1; j < b; j++) {
         trapez_sum += func[j];
@@ -19,19 +35,10 @@ by considering
 \left( 1+ \frac{h^2}{12} v(x+h) \right) f(x+h) = 2 \left( 1 - \frac{5h^2}{12} v(x) \right) f(x) - \left( 1 + \frac{h^2}{12} v(x-h) \right) f(x-h).
 for the Shroedinger equation v(x) = V(x) - E, where V(x) is the potential and E the eigenenergy
 */
-void fsol_Numerov(double Energy, int nbox, Potential V, double *wavefunction) {
-    double c, x;
-    std::vector<double> potential = V.getValues();
-
-    c = (2. * mass / hbar / hbar) * (dx * dx / 12.);
-    //Build Numerov f(x) solution from left.
-    for (int i = 2; i <= nbox; i++) {
-        x = (-nbox / 2 + i) * dx;
-
-        wavefunction[i] = 2 * (1. - (5 * c) * (Energy - potential[i-1])) * wavefunction[i - 1]
-                  - (1. + (c) * (Energy - potential[i-2])) * wavefunction[i - 2];
-        wavefunction[i] /= (1. + (c) * (Energy - potential[i]));
-    }
+template<typename Real>
+void fsol_Numerov(Real Energy, int nbox, const Real *potential, Real *wavefunction, const SolverConfig &config) {
+    sweep_count++;
+    step_Numerov(Energy, 2, nbox, 2, nbox, potential, wavefunction, config);
 
     /* //right solution
 
@@ -46,6 +53,87 @@ void fsol_Numerov(double Energy, int nbox, Potential V, double *wavefunction) {
     }*/
 }
 
+/*! The steps of fsol_Numerov, so that a sweep can be continued from any grid point: wavefunction[i] only
+depends on wavefunction[i-1], wavefunction[i-2] and the potential at i-2, i-1, i.
+*/
+template<typename Real>
+void step_Numerov(Real Energy, int first, int last, int from, int nbox, const Real *potential, Real *wavefunction,
+                  const SolverConfig &config) {
+    const Real c = config.numerovFactor();
+    // Beyond this the solution is rescaled, so that (float) sweeps through classically forbidden
+    // regions do not overflow. Only the scale changes, not the sign or the zeros. The starting values
+    // wavefunction[0], wavefunction[1] are left untouched, since the next sweep starts from them.
+    static const Real big = std::pow(std::numeric_limits<Real>::max(), (Real) 0.75);
+
+    //Build Numerov f(x) solution from left.
+    for (int i = first; i <= last; i++) {
+        // potential has nbox values: the right wall wavefunction[nbox] takes the last one, since the
+        // value of V there only rescales wavefunction[nbox] and does not move its zero
+        Real v_i = potential[(i < nbox) ? i : nbox - 1];
+
+        wavefunction[i] = 2 * (1. - (5 * c) * (Energy - potential[i-1])) * wavefunction[i - 1]
+                  - (1. + (c) * (Energy - potential[i-2])) * wavefunction[i - 2];
+        wavefunction[i] /= (1. + (c) * (Energy - v_i));
+
+        if (std::fabs(wavefunction[i]) > big) {
+            for (int j = from; j <= i; j++)
+                wavefunction[j] /= big;
+        }
+    }
+}
+
+/*! The sweep of step_Numerov from psi0, psi1 with the three last values kept in registers instead of an array:
+the same arithmetic, rescalings included (psi0, psi1 are never rescaled, as in the array), so the values are
+those fsol_Numerov would write. The sign changes are counted as in count_nodes_Numerov.
+*/
+template<typename Real>
+Real shoot_Numerov(Real Energy, int last, int nbox, const Real *potential, Real psi0, Real psi1, int *nodes, Real *tail,
+                   const SolverConfig &config) {
+    sweep_count++;
+    const Real c = config.numerovFactor();
+    static const Real big = std::pow(std::numeric_limits<Real>::max(), (Real) 0.75);
+
+    Real before = psi0, previous = psi0, current = psi1;  // psi[i - 3], psi[i - 2], psi[i - 1]
+    int count = 0;
+    bool positive = psi1 > 0;
+
+    for (int i = 2; i <= last; i++) {
+        Real v_i = potential[(i < nbox) ? i : nbox - 1];
+
+        Real next = 2 * (1. - (5 * c) * (Energy - potential[i-1])) * current
+                  - (1. + (c) * (Energy - potential[i-2])) * previous;
+        next /= (1. + (c) * (Energy - v_i));
+
+        if (std::fabs(next) > big) {
+            next /= big;
+            if (i - 1 >= 2)
+                current /= big;
+            if (i - 2 >= 2)
+                previous /= big;
+        }
+        if (next != 0 && (next > 0) != positive) {
+            count++;
+            positive = !positive;
+        }
+        before = previous;
+        previous = current;
+        current = next;
+    }
+
+    if (nodes)
+        *nodes = count;
+    if (tail) {
+        tail[0] = before;
+        tail[1] = previous;
+        tail[2] = current;
+    }
+    return current;
+}
+
+void fsol_Numerov(double Energy, int nbox, const Potential &V, double *wavefunction, const SolverConfig &config) {
+    fsol_Numerov<double>(Energy, nbox, V.getValues().data(), wavefunction, config);
+}
+
 /*! \brief a solver of differential equation using Numerov algorithm and selecting non-trivial solutions.
 @param (*potential) is the pointer to the potential function, takes function of 1 variable as input
 @param wavefunction, takes array of @param nbox size as input (for preconditioning)
@@ -58,91 +146,360 @@ is the exponential. But my boundary conditions impose 0 at both beginning and en
 of the wavefunction, so you have to try until you find such solution by finding
  where the exponential solution changes sign.
 */
-double solve_Numerov(double Emin, double Emax, double Estep,
-                   int nbox, Potential V, double *wavefunction) {
+namespace {
+    /*! Sweeps of the scan and the bisection: a sweep gives wavefunction[nbox]; complete() leaves in wavefunction
+    the whole solution of the last energy swept, as if every sweep had written it.
+    */
+    // every sweep from the left wall, energy only (shoot_Numerov), the array written once by complete()
+    template<typename Real>
+    struct FullSweep {
+        int nbox;
+        const Real *potential;
+        const SolverConfig &config;
+        Real last = NAN;
 
-    double c, x, first_step, norm, Energy, Solution_Energy = 0.;
-    int n, sign;
+        Real operator()(Real Energy, Real *wavefunction) {
+            last = Energy;
+            return shoot_Numerov<Real>(Energy, nbox, nbox, potential, wavefunction[0], wavefunction[1], nullptr, nullptr, config);
+        }
+        void complete(Real *wavefunction) {
+            if (!std::isnan(last))
+                fsol_Numerov(last, nbox, potential, wavefunction, config);
+        }
+    };
 
-    double *probab = new double[nbox];
+    // sweeps restarted from the state cached before the change of the potential, completed before the normalization
+    struct RestartedSweep {
+        IncrementalNumerov &incremental;
+        const SolverConfig &config;
+        double last = NAN;
 
-    // scan energies to find when the Numerov solution is =0 at the right extreme of the box.
-    for (n = 0; n < (Emax - Emin) / Estep; n++) {
-        Energy = Emin + n * Estep;
-        // wavefunction[1] = first_step;
+        double operator()(double Energy, double *wavefunction) {
+            incremental.sweep(Energy, wavefunction, config);
+            last = Energy;
+            return wavefunction[incremental.getNbox()];
+        }
+        void complete(double *wavefunction) {
+            if (!std::isnan(last))
+                incremental.fullSweep(last, wavefunction, config);
+        }
+    };
 
-        fsol_Numerov(Energy, nbox, V, wavefunction);
-        // std::coutS << "# Energy = " << Energy << "  " << wavefunction[nbox] << std::endl;
+    /*! Bisection of bisec_Numer. With a control (and its result), the control is checked before every step,
+    and result gets the sweeps, the status and the last bracket; without, a failure is reported on std::cerr.
+    */
+    template<typename Real, typename Sweep>
+    Real bisection(Real Emin, Real Emax, int nbox, Sweep &sweep, Real *wavefunction,
+                   const SolveControl *control, SolveResult *result, const SolverConfig &config) {
+        Real Emiddle = (Emax + Emin) / 2., fx1 = NAN, fb = NAN, fa = NAN;
+        SolveResult::Status status = SolveResult::NotConverged;
+        bool bracketed = true;
+        long sweeps = 0;
+        std::cout.precision(17);
 
+        // The number of iterations that the bisection routine needs can be evaluated in advance
+        const double tolerance = config.getTolerance();
+        int itmax = std::min(config.getMaxIterations(), (int) ceil(log2(Emax - Emin) - log2(tolerance)) - 1);
 
-        if (fabs(wavefunction[nbox]) < err) {
-            std::cout << "#solution found" << wavefunction[nbox] << std::endl;
-            Solution_Energy = Energy;
-            break;
+        std::cout << "#itmax=" << itmax << std::endl;
+        for (int i = 0; i < itmax; i++) {
+            // a step takes up to three sweeps
+            if (control && control->stop(result->sweeps + sweeps, 3, status))
+                break;
+
+            Emiddle = (Emax + Emin) / 2.;
+            fx1 = sweep(Emiddle, wavefunction);
+            fb = sweep(Emax, wavefunction);
+            sweeps += 2;
+
+            if (std::abs(fx1) < tolerance) {
+                std::cout << "#Numerov E=" << Emiddle << "f(nbox=" << nbox << ") = " << fx1 << " " << fb << std::endl;
+                status = SolveResult::Converged;
+                break;
+            }
+
+            if (fb * fx1 < 0.) {
+                Emin = Emiddle;
+            } else {
+                fa = sweep(Emin, wavefunction);
+                sweeps++;
+
+                if (fa * fx1 < 0.) {
+                    Emax = Emiddle;
+                }
+                else {
+                    bracketed = false;  // no sign change: further steps would not move the bracket
+                    break;
+                }
+            }
+
+            if (control)
+                control->report(SolveProgress{"bisection", result->sweeps + sweeps, control->elapsed(), (double) Emin, (double) Emax});
         }
 
-        if (n == 0)
-            sign = (wavefunction[nbox] > 0) ? 1 : -1;
+        // the steps ran out with the bracket below the tolerance
+        if (status == SolveResult::NotConverged && bracketed && Emax - Emin < 4 * tolerance)
+            status = SolveResult::Converged;
 
-        // when the sign changes, means that the solution for f[nbox]=0 is in in the middle, thus calls bisection rule.
-        if (sign * wavefunction[nbox] < 0) {
-          std::cout << "#bisection " << wavefunction[nbox] << std::endl;
-          Solution_Energy = bisec_Numer(Energy - Estep, Energy + Estep, nbox, V, wavefunction);
-            break;
+        if (result) {
+            result->status = status;
+            result->sweeps += sweeps;
+            result->Emin = Emin;
+            result->Emax = Emax;
+            result->bracketed = bracketed;
         }
+        else if (!(std::abs(fx1) < tolerance)) {
+            std::cerr<< "ERROR: Solution not found in bisec_Numer " << (std::isnan(fa) ? fb : fa) << " > " << tolerance << std::endl;
+        }
+        return Emiddle;
     }
 
-    std::cout << "# iteration " << n << "  Energy = " << Solution_Energy << std::endl;
+    /*! Scan of solve_Numerov, then bisection inside the first bracket with a sign change; control and result
+    as in bisection. A solve stopped by the control leaves the wavefunction as it is, without normalization.
+    */
+    template<typename Real, typename Sweep>
+    Real scan(Real Emin, Real Emax, Real Estep, int nbox, Sweep &sweep, Real *wavefunction,
+              const SolveControl *control, SolveResult *result, const SolverConfig &config) {
 
-    for (int i = 0; i <= nbox; i++)
-        probab[i] = wavefunction[i] * wavefunction[i];
+        Real norm, Energy, Solution_Energy = 0., f;
+        int n, sign;
+        bool stopped = false;
 
-    norm = trap_array(0., nbox, dx, probab);
-    std::cout << "# norm=" << norm << std::endl;
+        std::vector<Real> probab(nbox + 1);
+        if (result) {
+            result->status = SolveResult::NotFound;
+            result->Emin = result->Emax = Emin;
+            result->bracketed = false;
+        }
 
-    for (int i = 0; i <= nbox; i++)
-        wavefunction[i] = wavefunction[i] / sqrt(norm);
-    // for (int i = 0; i <= nbox; i++)
-    //     std::cout << (-nbox / 2 + i) * dx << "  " << wavefunction[i] << " " << (*potential)((-nbox / 2 + i) * dx) << std::endl;
-    return Solution_Energy;
+        // scan energies to find when the Numerov solution is =0 at the right extreme of the box.
+        for (n = 0; n < (Emax - Emin) / Estep; n++) {
+            Energy = Emin + n * Estep;
+            // wavefunction[1] = first_step;
+            if (control && control->stop(result->sweeps, 1, result->status)) {
+                stopped = true;
+                break;
+            }
+
+            f = sweep(Energy, wavefunction);
+            if (result)
+                result->sweeps++;
+            // std::coutS << "# Energy = " << Energy << "  " << f << std::endl;
+
+
+            if (fabs(f) < config.getTolerance()) {
+                std::cout << "#solution found" << f << std::endl;
+                Solution_Energy = Energy;
+                if (result) {
+                    result->status = SolveResult::Converged;
+                    result->Emin = result->Emax = Energy;
+                    result->bracketed = true;
+                }
+                break;
+            }
+
+            if (n == 0)
+                sign = (f > 0) ? 1 : -1;
+
+            // when the sign changes, means that the solution for f[nbox]=0 is in in the middle, thus calls bisection rule.
+            if (sign * f < 0) {
+              std::cout << "#bisection " << f << std::endl;
+              Solution_Energy = bisection(Energy - Estep, Energy + Estep, nbox, sweep, wavefunction, control, result, config);
+                stopped = result && result->status >= SolveResult::Cancelled;
+                break;
+            }
+
+            if (control) {
+                result->Emax = Energy;
+                control->report(SolveProgress{"scan", result->sweeps, control->elapsed(), result->Emin, result->Emax});
+            }
+        }
+
+        std::cout << "# iteration " << n << "  Energy = " << Solution_Energy << std::endl;
+        if (stopped)
+            return Solution_Energy;
+
+        sweep.complete(wavefunction);
+        for (int i = 0; i <= nbox; i++)
+            probab[i] = wavefunction[i] * wavefunction[i];
+
+        norm = trap_array(0, nbox, (Real) config.getMesh(), probab.data());
+        std::cout << "# norm=" << norm << std::endl;
+
+        for (int i = 0; i <= nbox; i++)
+            wavefunction[i] = wavefunction[i] / sqrt(norm);
+        return Solution_Energy;
+    }
+
+    // energy of a controlled solve: the solution, or the middle of the bracket it was stopped with
+    void finish(SolveResult &result, double Energy, const SolveControl &control) {
+        if (result.status == SolveResult::Converged || result.status == SolveResult::NotConverged)
+            result.energy = Energy;
+        else if (result.bracketed)
+            result.energy = (result.Emin + result.Emax) / 2.;
+        result.elapsed = control.elapsed();
+    }
+}
+
+template<typename Real>
+Real solve_Numerov(Real Emin, Real Emax, Real Estep,
+                   int nbox, const Real *potential, Real *wavefunction, const SolverConfig &config) {
+    FullSweep<Real> sweep{nbox, potential, config};
+    return scan<Real>(Emin, Emax, Estep, nbox, sweep, wavefunction, nullptr, nullptr, config);
+}
+
+double solve_Numerov(double Emin, double Emax, double Estep,
+                     int nbox, const Potential &V, double *wavefunction, const SolverConfig &config) {
+    return solve_Numerov<double>(Emin, Emax, Estep, nbox, V.getValues().data(), wavefunction, config);
+}
+
+SolveResult solve_Numerov(double Emin, double Emax, double Estep, int nbox, const Potential &V, double *wavefunction,
+                          const SolveControl &control, const SolverConfig &config) {
+    return solve_Numerov(Emin, Emax, Estep, nbox, V.getValues().data(), wavefunction, control, config);
+}
+
+SolveResult solve_Numerov(double Emin, double Emax, double Estep, int nbox, const double *potential, double *wavefunction,
+                          const SolveControl &control, const SolverConfig &config) {
+    SolveResult result;
+    FullSweep<double> sweep{nbox, potential, config};
+    double Energy = scan<double>(Emin, Emax, Estep, nbox, sweep, wavefunction, &control, &result, config);
+    finish(result, Energy, control);
+    return result;
+}
+
+namespace {
+    // the potential covers the grid of psi; the solve takes config with the mesh of psi
+    SolverConfig check_grid(const Potential &V, const Wavefunction &psi, const SolverConfig &config) {
+        if ((int) V.getValues().size() < psi.getNbox())
+            throw std::invalid_argument("The potential holds fewer values than the wavefunction grid.");
+        return SolverConfig(config).setMesh(psi.getMesh());
+    }
+}
+
+double solve_Numerov(double Emin, double Emax, double Estep, const Potential &V, Wavefunction &psi,
+                     const SolverConfig &config) {
+    return solve_Numerov(Emin, Emax, Estep, psi.getNbox(), V, psi.data(), check_grid(V, psi, config));
+}
+
+SolveResult solve_Numerov(double Emin, double Emax, double Estep, const Potential &V, Wavefunction &psi,
+                          const SolveControl &control, const SolverConfig &config) {
+    return solve_Numerov(Emin, Emax, Estep, psi.getNbox(), V, psi.data(), control, check_grid(V, psi, config));
+}
+
+double solve_Numerov(double Emin, double Emax, double Estep, int nbox, const Potential &V, double *wavefunction,
+                     IncrementalNumerov &incremental, const SolverConfig &config) {
+    if (incremental.getNbox() != nbox)
+        throw std::invalid_argument("IncrementalNumerov was made for another grid.");
+    incremental.setPotential(V);
+    RestartedSweep sweep{incremental, config};
+    return scan<double>(Emin, Emax, Estep, nbox, sweep, wavefunction, nullptr, nullptr, config);
 }
 
 /*! Applies a bisection algorith to the numerov method to find
 the energy that gives the non-trivial (non-exponential) solution
 with the correct boundary conditions (@param wavefunction[0] == @param wavefunction[@param nbox] == 0)
 */
-double bisec_Numer(double Emin, double Emax, int nbox, Potential V, double *wavefunction) {
-    double Emiddle, fx1, fb, fa;
-    std::cout.precision(17);
-
-    // The number of iterations that the bisection routine needs can be evaluated in advance
-    int itmax = ceil(log2(Emax - Emin) - log2(err)) - 1;
-
-    std::cout << "#itmax=" << itmax << std::endl;
-    for (int i = 0; i < itmax; i++) {
-        Emiddle = (Emax + Emin) / 2.;
-        fsol_Numerov(Emiddle, nbox, V, wavefunction);
-        fx1 = wavefunction[nbox];
-        fsol_Numerov(Emax, nbox, V, wavefunction);
-        fb = wavefunction[nbox];
-
-        if (std::abs(fx1) < err) {
-            std::cout << "#Numerov E=" << Emiddle << "f(nbox=" << nbox << ") = " << fx1 << " " << wavefunction[nbox] << std::endl;
-            return Emiddle;
-        }
+template<typename Real>
+Real bisec_Numer(Real Emin, Real Emax, int nbox, const Real *potential, Real *wavefunction, const SolverConfig &config) {
+    FullSweep<Real> sweep{nbox, potential, config};
+    Real Energy = bisection<Real>(Emin, Emax, nbox, sweep, wavefunction, nullptr, nullptr, config);
+    sweep.complete(wavefunction);
+    return Energy;
+}
+
+double bisec_Numer(double Emin, double Emax, int nbox, const Potential &V, double *wavefunction,
+                   const SolverConfig &config) {
+    return bisec_Numer<double>(Emin, Emax, nbox, V.getValues().data(), wavefunction, config);
+}
+
+SolveResult bisec_Numer(double Emin, double Emax, int nbox, const Potential &V, double *wavefunction,
+                        const SolveControl &control, const SolverConfig &config) {
+    SolveResult result;
+    FullSweep<double> sweep{nbox, V.getValues().data(), config};
+    double Energy = bisection<double>(Emin, Emax, nbox, sweep, wavefunction, &control, &result, config);
+    sweep.complete(wavefunction);
+    finish(result, Energy, control);
+    return result;
+}
+
+/*! Same scan and bisection as solve_Numerov, but the scan that looks for the sign change of
+wavefunction[nbox] runs in ScanReal (in float, half the memory traffic: the recurrence is a serial
+dependency chain and does not vectorize), while the bisection inside the bracket and the normalization
+run in RefineReal.
+*/
+template<typename ScanReal, typename RefineReal>
+double solve_Numerov_mixed(double Emin, double Emax, double Estep,
+                   int nbox, const Potential &V, double *wavefunction, const SolverConfig &config) {
+
+    const std::vector<double> &values = V.getValues();
+    std::vector<ScanReal> scan_potential(values.begin(), values.end());
+    std::vector<RefineReal> refine_potential(values.begin(), values.end());
 
-        if (fb * fx1 < 0.) {
-            Emin = Emiddle;
-        } else {
-            fsol_Numerov(Emin, nbox, V, wavefunction);
-            fa = wavefunction[nbox];
+    std::vector<RefineReal> refine_wf(nbox + 1);
+    refine_wf[0] = wavefunction[0];
+    refine_wf[1] = wavefunction[1];
 
-            if (fa * fx1 < 0.)
-                Emax = Emiddle;
+    RefineReal Solution_Energy = 0.;
+    int n, sign = 1;
+
+    for (n = 0; n < (Emax - Emin) / Estep; n++) {
+        double Energy = Emin + n * Estep;
+        ScanReal f = shoot_Numerov<ScanReal>(Energy, nbox, nbox, scan_potential.data(),
+                                             wavefunction[0], wavefunction[1], nullptr, nullptr, config);
+
+        if (n == 0)
+            sign = (f > 0) ? 1 : -1;
+
+        if (f == 0 || sign * f < 0) {
+            FullSweep<RefineReal> sweep{nbox, refine_potential.data(), config};
+            Solution_Energy = bisection<RefineReal>(Energy - Estep, Energy + Estep, nbox, sweep,
+                                                    refine_wf.data(), nullptr, nullptr, config);
+            break;
         }
     }
 
-    std::cerr<< "ERROR: Solution not found in bisec_Numer " << wavefunction[nbox] << " > " << err << std::endl;
-//    exit(9);
-    return Emiddle;
+    std::cout << "# iteration " << n << "  Energy = " << Solution_Energy << std::endl;
+
+    fsol_Numerov<RefineReal>(Solution_Energy, nbox, refine_potential.data(), refine_wf.data(), config);
+
+    std::vector<RefineReal> probab(nbox + 1);
+    for (int i = 0; i <= nbox; i++)
+        probab[i] = refine_wf[i] * refine_wf[i];
+    RefineReal norm = trap_array(0, nbox, (RefineReal) config.getMesh(), probab.data());
+
+    for (int i = 0; i <= nbox; i++)
+        wavefunction[i] = refine_wf[i] / std::sqrt(norm);
+    return Solution_Energy;
 }
+
+// --- Explicit instantiations --- //
+
+template float trap_array<float>(int, int, float, const float *);
+template double trap_array<double>(int, int, double, const double *);
+template long double trap_array<long double>(int, int, long double, const long double *);
+
+template void fsol_Numerov<float>(float, int, const float *, float *, const SolverConfig &);
+template void fsol_Numerov<double>(double, int, const double *, double *, const SolverConfig &);
+template void fsol_Numerov<long double>(long double, int, const long double *, long double *, const SolverConfig &);
+
+template float shoot_Numerov<float>(float, int, int, const float *, float, float, int *, float *, const SolverConfig &);
+template double shoot_Numerov<double>(double, int, int, const double *, double, double, int *, double *, const SolverConfig &);
+template long double shoot_Numerov<long double>(long double, int, int, const long double *, long double, long double,
+                                                int *, long double *, const SolverConfig &);
+
+template void step_Numerov<float>(float, int, int, int, int, const float *, float *, const SolverConfig &);
+template void step_Numerov<double>(double, int, int, int, int, const double *, double *, const SolverConfig &);
+template void step_Numerov<long double>(long double, int, int, int, int, const long double *, long double *, const SolverConfig &);
+
+template float solve_Numerov<float>(float, float, float, int, const float *, float *, const SolverConfig &);
+template double solve_Numerov<double>(double, double, double, int, const double *, double *, const SolverConfig &);
+template long double solve_Numerov<long double>(long double, long double, long double, int, const long double *, long double *, const SolverConfig &);
+
+template float bisec_Numer<float>(float, float, int, const float *, float *, const SolverConfig &);
+template double bisec_Numer<double>(double, double, int, const double *, double *, const SolverConfig &);
+template long double bisec_Numer<long double>(long double, long double, int, const long double *, long double *, const SolverConfig &);
+
+template double solve_Numerov_mixed<float, double>(double, double, double, int, const Potential &, double *, const SolverConfig &);
+template double solve_Numerov_mixed<float, long double>(double, double, double, int, const Potential &, double *, const SolverConfig &);
+template double solve_Numerov_mixed<double, double>(double, double, double, int, const Potential &, double *, const SolverConfig &);
+template double solve_Numerov_mixed<double, long double>(double, double, double, int, const Potential &, double *, const SolverConfig &);
@@ -3,12 +3,7 @@
 #ifndef SCHROEDINGER_H
 #define SCHROEDINGER_H
 
-#define dx 0.01
-#define err 1E-10
-
 #define pi 3.14159265359
-#define hbar 1
-#define mass 1
 
 #include <cmath>
 #include <iostream>
@@ -16,11 +11,88 @@
 #include <string>
 
 #include <Potential.h>
+#include "SolveControl.h"
+#include "SolverConfig.h"
+#include "Wavefunction.h"
+
+/*! The defaults of SolverConfig, by their old names. The solvers do not read them: grid step, tolerance and
+ * units are those of the SolverConfig the solve is handed.
+ */
+constexpr double dx = SolverConfig::defaultMesh;
+constexpr double err = SolverConfig::defaultTolerance;
+constexpr double hbar = 1.;
+constexpr double mass = 1.;
+
+/*! The solver kernels are templated on the scalar type Real, and explicitly instantiated
+ * for float, double and long double. They work on plain arrays: potential holds the nbox values
+ * of the potential on the grid, wavefunction holds nbox + 1 values (the last one is the right wall).
+ * The Potential overloads below are the double precision entry points. The grid step, the tolerance and the
+ * units are those of the trailing config, which every entry point takes; left out, it is SolverConfig::current()
+ * of the calling thread, read once at the call.
+ */
+template<typename Real> Real trap_array(int, int, Real, const Real *);
+template<typename Real> void fsol_Numerov(Real, int, const Real *, Real *,
+                                          const SolverConfig &config = SolverConfig::current());
+/*! Steps first..last (2 <= first <= last <= nbox) of the sweep of fsol_Numerov, from wavefunction[first - 2]
+ * and wavefunction[first - 1]; a rescaling divides wavefunction[from..i]. Not counted in numerov_sweeps().
+ */
+template<typename Real> void step_Numerov(Real Energy, int first, int last, int from, int nbox, const Real *, Real *,
+                                          const SolverConfig &config = SolverConfig::current());
+/*! Energy only sweep: psi[last] (last <= nbox) of the sweep of fsol_Numerov from psi[0] = psi0, psi[1] = psi1,
+ * with the recurrence in registers and O(1) memory, equal to the value fsol_Numerov writes. nodes, if not null,
+ * gets the sign changes of psi[1..last], and tail psi[last - 2], psi[last - 1], psi[last]. Counted in numerov_sweeps().
+ * The scans and bisections use it, and write the whole wavefunction once, at the energy they converge to.
+ */
+template<typename Real> Real shoot_Numerov(Real Energy, int last, int nbox, const Real *potential, Real psi0, Real psi1,
+                                           int *nodes = nullptr, Real *tail = nullptr,
+                                           const SolverConfig &config = SolverConfig::current());
+template<typename Real> Real solve_Numerov(Real, Real, Real, int, const Real *, Real *,
+                                           const SolverConfig &config = SolverConfig::current());
+template<typename Real> Real bisec_Numer(Real, Real, int, const Real *, Real *,
+                                         const SolverConfig &config = SolverConfig::current());
+
+void fsol_Numerov(double, int, const Potential &, double *, const SolverConfig &config = SolverConfig::current());
+double solve_Numerov(double, double, double, int, const Potential &, double *,
+                     const SolverConfig &config = SolverConfig::current());
+double bisec_Numer(double, double, int, const Potential &, double *, const SolverConfig &config = SolverConfig::current());
+
+/*! Controlled solves: the same scan and bisection, bounded by the cancellation token, deadline and sweep
+ * budget of the SolveControl. They report how the solve ended in a SolveResult instead of std::cerr.
+ */
+SolveResult solve_Numerov(double Emin, double Emax, double Estep, int nbox, const Potential &V,
+                          double *wavefunction, const SolveControl &control,
+                          const SolverConfig &config = SolverConfig::current());
+//! The same on the nbox values of the potential, read in place
+SolveResult solve_Numerov(double Emin, double Emax, double Estep, int nbox, const double *potential,
+                          double *wavefunction, const SolveControl &control,
+                          const SolverConfig &config = SolverConfig::current());
+SolveResult bisec_Numer(double Emin, double Emax, int nbox, const Potential &V, double *wavefunction,
+                        const SolveControl &control, const SolverConfig &config = SolverConfig::current());
+
+/*! The same on a Wavefunction: nbox and the mesh are those of psi (the mesh of config is replaced by it), and
+ * the solve starts from psi[0], psi[1] (set by the Wavefunction constructor and reset()).
+ */
+double solve_Numerov(double Emin, double Emax, double Estep, const Potential &V, Wavefunction &psi,
+                     const SolverConfig &config = SolverConfig::current());
+SolveResult solve_Numerov(double Emin, double Emax, double Estep, const Potential &V, Wavefunction &psi,
+                          const SolveControl &control, const SolverConfig &config = SolverConfig::current());
+
+class IncrementalNumerov;
+/*! Same scan and bisection as solve_Numerov, with the same result, but every sweep restarts from the state
+ * that incremental kept for its energy before the first grid point where V differs from the previous potential.
+ */
+double solve_Numerov(double Emin, double Emax, double Estep, int nbox, const Potential &V, double *wavefunction,
+                     IncrementalNumerov &incremental, const SolverConfig &config = SolverConfig::current());
 
+/*! Mixed precision solve: the energy scan (most of the cost) runs in ScanReal, the bisection
+ * and the final wavefunction in RefineReal. Instantiated for ScanReal = float, double and
+ * RefineReal = double, long double. The result is written in the double wavefunction.
+ */
+template<typename ScanReal, typename RefineReal>
+double solve_Numerov_mixed(double, double, double, int, const Potential &, double *,
+                          const SolverConfig &config = SolverConfig::current());
 
-double trap_array(int, int, double, double *);
-void fsol_Numerov(double, int, Potential, double *);
-double solve_Numerov(double, double, double, int, Potential, double *);
-double bisec_Numer(double, double, int, Potential, double *);
+//! Number of Numerov sweeps (calls of fsol_Numerov and shoot_Numerov, any precision) done so far by the calling thread.
+unsigned long numerov_sweeps();
 
 #endif
@@ -0,0 +1,251 @@
+#include "SelfConsistent.h"
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+#include "Bracketing.h"
+#include "Schroedinger.h"
+
+namespace {
+    /*! Solves the small dense system a x = b in place (Gaussian elimination with partial pivoting).
+    Returns false if the matrix is numerically singular.
+    */
+    bool solve_linear(std::vector<double> a, std::vector<double> &b, int n) {
+        for (int col = 0; col < n; col++) {
+            int pivot = col;
+            for (int row = col + 1; row < n; row++)
+                if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col]))
+                    pivot = row;
+            if (std::fabs(a[pivot * n + col]) < 1e-300)
+                return false;
+            if (pivot != col) {
+                for (int k = 0; k < n; k++)
+                    std::swap(a[col * n + k], a[pivot * n + k]);
+                std::swap(b[col], b[pivot]);
+            }
+            for (int row = col + 1; row < n; row++) {
+                double f = a[row * n + col] / a[col * n + col];
+                for (int k = col; k < n; k++)
+                    a[row * n + k] -= f * a[col * n + k];
+                b[row] -= f * b[col];
+            }
+        }
+        for (int row = n - 1; row >= 0; row--) {
+            for (int k = row + 1; k < n; k++)
+                b[row] -= a[row * n + k] * b[k];
+            b[row] /= a[row * n + row];
+        }
+        return true;
+    }
+}
+
+HartreeSolver::HartreeSolver(ContinuousBase base, Potential external, int occupied, double coupling,
+                             const SolverConfig &config)
+    : base(base), config(SolverConfig(config).setMesh(base.getMesh())), external(external)
+{
+    if (occupied < 1)
+        throw std::invalid_argument("HartreeSolver needs at least one occupied level.");
+    if (external.getValues().size() < base.getNbox())
+        throw std::invalid_argument("HartreeSolver: the potential does not cover the basis grid.");
+
+    this->nbox     = (int) base.getNbox();
+    this->occupied = occupied;
+    this->coupling = coupling;
+}
+
+HartreeSolver& HartreeSolver::setInteraction(Interaction interaction, double range) {
+    if (range <= 0)
+        throw std::invalid_argument("Interaction range must be positive.");
+    this->interaction = interaction;
+    this->range = range;
+    return *this;
+}
+
+HartreeSolver& HartreeSolver::setMixing(Mixing mixing, double alpha, int history) {
+    if (alpha <= 0 || alpha > 1)
+        throw std::invalid_argument("Mixing parameter alpha must be in (0, 1].");
+    if (history < 1)
+        throw std::invalid_argument("Mixing history must hold at least one iteration.");
+    this->mixing = mixing;
+    this->alpha = alpha;
+    this->history = history;
+    return *this;
+}
+
+HartreeSolver& HartreeSolver::setTolerance(double tolerance) {
+    if (tolerance <= 0)
+        throw std::invalid_argument("Tolerance must be positive.");
+    this->tolerance = tolerance;
+    return *this;
+}
+
+HartreeSolver& HartreeSolver::setMaxIterations(int iterations) {
+    this->maxIterations = iterations;
+    return *this;
+}
+
+double HartreeSolver::dot(const std::vector<double> &a, const std::vector<double> &b) {
+    double sum = 0.;
+    for (std::vector<double>::size_type i = 0; i < a.size(); i++)
+        sum += a[i] * b[i];
+    return sum * base.getMesh();
+}
+
+std::vector<double> HartreeSolver::hartree(const std::vector<double> &density) {
+    std::vector<double> v(nbox);
+    if (this->interaction == Contact) {
+        for (int i = 0; i < nbox; i++)
+            v[i] = coupling * density[i];
+    }
+    else {
+        std::vector<double> x = base.getCoords();
+        for (int i = 0; i < nbox; i++) {
+            double sum = 0.;
+            for (int j = 0; j < nbox; j++)
+                sum += density[j] / std::sqrt((x[i] - x[j]) * (x[i] - x[j]) + range * range);
+            v[i] = coupling * sum * base.getMesh();
+        }
+    }
+    return v;
+}
+
+HartreeSolver::Result HartreeSolver::run() {
+    Result result;
+    result.converged = false;
+    result.iterations = 0;
+    result.sweeps = 0;
+    result.residual = 0.;
+    result.energies.assign(occupied, NAN);
+    result.states.assign(occupied, std::vector<double>(nbox + 1));
+
+    const std::vector<double> &v_ext = external.getValues();
+    Potential V = external;
+    std::vector<double> rho_in(nbox + 1, 0.), rho_out(nbox + 1), residual(nbox + 1);
+    std::vector<double> shift(occupied, NAN);
+    std::deque< std::vector<double> > inputs, residuals;
+
+    for (int it = 1; it <= maxIterations; it++) {
+        result.iterations = it;
+
+        // incremental update of the effective potential, no rebuild through the Builder
+        std::vector<double> v_eff = hartree(rho_in);
+        for (int i = 0; i < nbox; i++)
+            v_eff[i] += v_ext[i];
+        V.setValues(v_eff);
+
+        std::fill(rho_out.begin(), rho_out.end(), 0.);
+        for (int n = 0; n < occupied; n++) {
+            std::vector<double> &wf = result.states[n];
+            wf[0] = 0.;
+            wf[1] = 0.01;
+
+            // warm start: bracket around the previous energy, as wide as its last change
+            double guess = result.energies[n];
+            double delta = std::isnan(shift[n]) ? NAN : std::max(4. * std::fabs(shift[n]), 1e-7);
+            EnergyBracket b = bracket_Numerov(n, nbox, V, wf.data(), guess, delta, config);
+            result.sweeps += b.sweeps;
+            double E = refine_Numer(b.Emin, b.Emax, nbox, V, wf.data(), &result.sweeps, config);
+
+            fsol_Numerov<double>(E, nbox, V.getValues().data(), wf.data(), config);
+            result.sweeps++;
+            double norm = 0.;
+            for (int i = 0; i <= nbox; i++)
+                norm += wf[i] * wf[i];
+            norm = std::sqrt(norm * base.getMesh());
+            for (int i = 0; i <= nbox; i++) {
+                wf[i] /= norm;
+                rho_out[i] += wf[i] * wf[i];
+            }
+
+            shift[n] = std::isnan(result.energies[n]) ? NAN : E - result.energies[n];
+            result.energies[n] = E;
+        }
+
+        for (int i = 0; i <= nbox; i++)
+            residual[i] = rho_out[i] - rho_in[i];
+        result.residual = std::sqrt(dot(residual, residual));
+        std::cout << "# SCF iteration " << it << "  residual = " << result.residual << std::endl;
+
+        if (result.residual < tolerance) {
+            result.converged = true;
+            break;
+        }
+
+        inputs.push_back(rho_in);
+        residuals.push_back(residual);
+        if ((int) inputs.size() > history + 1) {
+            inputs.pop_front();
+            residuals.pop_front();
+        }
+
+        int m = (int) inputs.size() - 1;   // number of differences available
+        bool mixed = false;
+        std::vector<double> next(nbox + 1);
+
+        if (mixing == Anderson && m > 0) {
+            // least squares: min || r_k - sum_j gamma_j (r_{j+1} - r_j) ||
+            std::vector< std::vector<double> > dR(m, std::vector<double>(nbox + 1)), dX(m, std::vector<double>(nbox + 1));
+            for (int j = 0; j < m; j++) {
+                for (int i = 0; i <= nbox; i++) {
+                    dR[j][i] = residuals[j + 1][i] - residuals[j][i];
+                    dX[j][i] = inputs[j + 1][i] - inputs[j][i];
+                }
+            }
+            std::vector<double> a(m * m), gamma(m);
+            double trace = 0.;
+            for (int j = 0; j < m; j++) {
+                for (int l = 0; l < m; l++)
+                    a[j * m + l] = dot(dR[j], dR[l]);
+                gamma[j] = dot(dR[j], residual);
+                trace += a[j * m + j];
+            }
+            for (int j = 0; j < m; j++)
+                a[j * m + j] += 1e-12 * trace;
+
+            if (solve_linear(a, gamma, m)) {
+                for (int i = 0; i <= nbox; i++) {
+                    next[i] = rho_in[i] + alpha * residual[i];
+                    for (int j = 0; j < m; j++)
+                        next[i] -= (dX[j][i] + alpha * dR[j][i]) * gamma[j];
+                }
+                mixed = true;
+            }
+        }
+        else if (mixing == DIIS && m > 0) {
+            // Pulay: min || sum_j c_j r_j || with sum_j c_j = 1, via a Lagrange multiplier
+            int size = m + 2;
+            std::vector<double> b(size * size, 0.), c(size, 0.);
+            for (int j = 0; j <= m; j++) {
+                for (int l = 0; l <= m; l++)
+                    b[j * size + l] = dot(residuals[j], residuals[l]);
+                b[j * size + m + 1] = b[(m + 1) * size + j] = -1.;
+            }
+            c[m + 1] = -1.;
+
+            if (solve_linear(b, c, size)) {
+                for (int i = 0; i <= nbox; i++) {
+                    next[i] = 0.;
+                    for (int j = 0; j <= m; j++)
+                        next[i] += c[j] * (inputs[j][i] + alpha * residuals[j][i]);
+                }
+                mixed = true;
+            }
+        }
+
+        if (!mixed) {
+            for (int i = 0; i <= nbox; i++)
+                next[i] = rho_in[i] + alpha * residual[i];
+        }
+        // extrapolation can overshoot: a density is never negative
+        for (int i = 0; i <= nbox; i++)
+            rho_in[i] = std::max(0., next[i]);
+    }
+
+    if (!result.converged)
+        std::cerr << "ERROR: SCF not converged after " << result.iterations << " iterations, residual "
+                  << result.residual << std::endl;
+
+    result.density = rho_out;
+    return result;
+}
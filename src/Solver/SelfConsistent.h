@@ -0,0 +1,70 @@
+#ifndef SELFCONSISTENT_H
+#define SELFCONSISTENT_H
+
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! HartreeSolver drives a self-consistent mean-field calculation: the lowest `occupied` levels of
+ * V_ext + V_H[rho] are filled (one particle each), their density rho(x) = sum_i |psi_i(x)|^2 gives the
+ * Hartree potential V_H, and the loop runs until the density no longer changes.
+ *
+ * V_H is either a contact interaction, coupling * rho(x), or a soft Coulomb one,
+ * coupling * \int rho(x') / sqrt((x - x')^2 + range^2) dx'.
+ *
+ * The effective Potential is updated in place every iteration (Potential::setValues), and every level
+ * is bracketed starting from its energy of the previous iteration, with a bracket as wide as the last
+ * change of that energy: converging iterations cost a handful of Numerov sweeps per level.
+ * The input density of the next iteration is mixed from the history of inputs and residuals:
+ * - Linear:   rho_in + alpha * residual
+ * - Anderson: Anderson acceleration on the last `history` differences of inputs and residuals
+ * - DIIS:     Pulay's direct inversion in the iterative subspace, on the last `history` residuals
+ */
+class HartreeSolver {
+public:
+    enum Mixing { Linear = 0, Anderson = 1, DIIS = 2 };
+    enum Interaction { Contact = 0, SoftCoulomb = 1 };
+
+    struct Result {
+        bool converged;
+        int iterations;
+        int sweeps;                    // Numerov sweeps over all the iterations
+        double residual;               // || rho_out - rho_in || of the last iteration
+        std::vector<double> energies;  // single particle energies of the occupied levels
+        std::vector<double> density;
+        std::vector< std::vector<double> > states; // nbox + 1 values each, normalized
+    };
+
+    //! The levels are solved with config on the mesh of base
+    HartreeSolver(ContinuousBase base, Potential external, int occupied, double coupling,
+                  const SolverConfig &config = SolverConfig::current());
+
+    HartreeSolver& setInteraction(Interaction interaction, double range = 1.);
+    HartreeSolver& setMixing(Mixing mixing, double alpha = 0.5, int history = 5);
+    HartreeSolver& setTolerance(double tolerance);
+    HartreeSolver& setMaxIterations(int iterations);
+
+    Result run();
+
+private:
+    ContinuousBase base;
+    SolverConfig config;
+    Potential external;
+    int nbox, occupied;
+    double coupling;
+
+    Interaction interaction = Contact;
+    double range            = 1.;
+    Mixing mixing           = Anderson;
+    double alpha            = 0.5;
+    int history             = 5;
+    double tolerance        = 1e-8;
+    int maxIterations       = 200;
+
+    std::vector<double> hartree(const std::vector<double> &density);
+    double dot(const std::vector<double> &, const std::vector<double> &);
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "SolveControl.h"
+
+#include <stdexcept>
+
+const char* SolveResult::describe(Status status)
+{
+    switch (status) {
+        case Converged:        return "converged";
+        case NotFound:         return "not found";
+        case NotConverged:     return "not converged";
+        case Cancelled:        return "cancelled";
+        case DeadlineExceeded: return "timeout";
+        case BudgetExhausted:  return "budget exhausted";
+    }
+    return "unknown";
+}
+
+SolveControl::SolveControl() : start(std::chrono::steady_clock::now()) {}
+
+SolveControl& SolveControl::setToken(const CancelToken& token)
+{
+    this->token = token;
+    this->hasToken = true;
+    return *this;
+}
+
+SolveControl& SolveControl::setTimeout(double seconds)
+{
+    if (!(seconds >= 0))
+        throw std::invalid_argument("Timeout must be a non negative number of seconds.");
+    return setDeadline(std::chrono::steady_clock::now()
+                       + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds)));
+}
+
+SolveControl& SolveControl::setDeadline(std::chrono::steady_clock::time_point deadline)
+{
+    this->deadline = deadline;
+    this->hasDeadline = true;
+    return *this;
+}
+
+SolveControl& SolveControl::setSweepBudget(long sweeps)
+{
+    if (sweeps < 0)
+        throw std::invalid_argument("Sweep budget must be non negative.");
+    this->budget = sweeps;
+    return *this;
+}
+
+SolveControl& SolveControl::setProgress(Progress callback, long interval)
+{
+    this->progress = callback;
+    this->interval = (interval > 0) ? interval : 1;
+    return *this;
+}
+
+bool SolveControl::stop(long sweeps, long next, SolveResult::Status& status) const
+{
+    if (this->hasToken && this->token.cancelled()) {
+        status = SolveResult::Cancelled;
+        return true;
+    }
+    if (this->budget >= 0 && sweeps + next > this->budget) {
+        status = SolveResult::BudgetExhausted;
+        return true;
+    }
+    if (this->hasDeadline && std::chrono::steady_clock::now() >= this->deadline) {
+        status = SolveResult::DeadlineExceeded;
+        return true;
+    }
+    return false;
+}
+
+void SolveControl::report(const SolveProgress& progress) const
+{
+    if (this->progress && ++this->reports % this->interval == 0)
+        this->progress(progress);
+}
+
+double SolveControl::elapsed() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+}
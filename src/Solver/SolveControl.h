@@ -0,0 +1,93 @@
+#ifndef SOLVECONTROL_H
+#define SOLVECONTROL_H
+
+#include <atomic>
+#include <cmath>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+/*! CancelToken is a flag shared by all of its copies: the caller keeps one, the solve gets another,
+ * and cancel() from any thread stops the solve at its next check.
+ */
+class CancelToken {
+public:
+    CancelToken() : flag(std::make_shared< std::atomic<bool> >(false)) {}
+
+    void cancel() const { flag->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr< std::atomic<bool> > flag;
+};
+
+/*! Outcome of a controlled solve.
+ * - Converged: energy is the eigenvalue and the wavefunction is normalized
+ * - NotFound: no sign change of wavefunction[nbox] in the scanned window
+ * - NotConverged: the bisection ended without reaching the tolerance, energy is its last estimate
+ * - Cancelled, DeadlineExceeded, BudgetExhausted: stopped early by the SolveControl; the wavefunction is
+ *   not normalized, [Emin, Emax] is the best bracket so far and energy its middle if bracketed,
+ *   otherwise [Emin, Emax] is the part of the window scanned without finding a sign change and energy is NaN
+ */
+struct SolveResult {
+    enum Status { Converged = 0, NotFound, NotConverged, Cancelled, DeadlineExceeded, BudgetExhausted };
+
+    Status status  = NotFound;
+    double energy  = NAN;
+    double Emin    = NAN, Emax = NAN;
+    bool bracketed = false;   // [Emin, Emax] holds a sign change of wavefunction[nbox]
+    long sweeps    = 0;       // Numerov sweeps done
+    double elapsed = 0.;      // seconds since the SolveControl was made
+
+    bool converged() const { return status == Converged; }
+    static const char* describe(Status status);
+};
+
+//! Reported to the progress callback during a controlled solve
+struct SolveProgress {
+    const char *stage;    // "scan" or "bisection"
+    long sweeps;
+    double elapsed;
+    double Emin, Emax;    // current bracket, or the part of the window scanned so far
+};
+
+/*! SolveControl bounds a solve: a CancelToken, a wall-clock deadline and a budget of Numerov sweeps,
+ * all checked before every step, so that a solve never spends a sweep past its budget and overruns its
+ * deadline by at most one step. The progress callback is called every `interval` steps, on the solving thread.
+ *
+ * SolveControl control;
+ * control.setToken(token).setTimeout(0.05).setSweepBudget(500);
+ * SolveResult r = solve_Numerov(Emin, Emax, Estep, nbox, V, wavefunction, control);
+ */
+class SolveControl {
+public:
+    typedef std::function<void(const SolveProgress&)> Progress;
+
+    SolveControl();
+
+    SolveControl& setToken(const CancelToken& token);
+    SolveControl& setTimeout(double seconds);
+    SolveControl& setDeadline(std::chrono::steady_clock::time_point deadline);
+    SolveControl& setSweepBudget(long sweeps);
+    SolveControl& setProgress(Progress callback, long interval = 1);
+
+    /*! True if the solve must stop before spending `next` more sweeps after `sweeps`;
+     * status is then set to the reason.
+     */
+    bool stop(long sweeps, long next, SolveResult::Status& status) const;
+    //! Calls the progress callback, if any, every interval calls
+    void report(const SolveProgress& progress) const;
+    double elapsed() const;
+
+private:
+    CancelToken token;
+    bool hasToken   = false;
+    bool hasDeadline = false;
+    std::chrono::steady_clock::time_point start, deadline;
+    long budget     = -1;
+    Progress progress;
+    long interval   = 1;
+    mutable long reports = 0;
+};
+
+#endif
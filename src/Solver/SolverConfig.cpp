@@ -0,0 +1,63 @@
+#include "SolverConfig.h"
+
+#include <stdexcept>
+
+namespace {
+    const SolverConfig defaults;
+    // per thread, so that concurrent solves use their own grids
+    thread_local const SolverConfig *active = &defaults;
+}
+
+SolverConfig::SolverConfig(const ContinuousBase &base)
+{
+    *this = current();
+    setMesh(base.getMesh());
+}
+
+SolverConfig& SolverConfig::setMesh(double mesh)
+{
+    if (!(mesh > 0.))
+        throw std::invalid_argument("The mesh must be positive.");
+    this->mesh = mesh;
+    return *this;
+}
+
+SolverConfig& SolverConfig::setTolerance(double tolerance)
+{
+    if (!(tolerance > 0.))
+        throw std::invalid_argument("The tolerance must be positive.");
+    this->tolerance = tolerance;
+    return *this;
+}
+
+SolverConfig& SolverConfig::setUnits(double hbar, double mass)
+{
+    if (!(hbar > 0.) || !(mass > 0.))
+        throw std::invalid_argument("hbar and the mass must be positive.");
+    this->hbar = hbar;
+    this->mass = mass;
+    return *this;
+}
+
+SolverConfig& SolverConfig::setMaxIterations(int iterations)
+{
+    if (iterations < 1)
+        throw std::invalid_argument("At least one iteration.");
+    this->maxIterations = iterations;
+    return *this;
+}
+
+const SolverConfig& SolverConfig::current()
+{
+    return *active;
+}
+
+SolverConfig::Scope::Scope(const SolverConfig &config) : config(config), previous(active)
+{
+    active = &this->config;
+}
+
+SolverConfig::Scope::~Scope()
+{
+    active = this->previous;
+}
@@ -0,0 +1,74 @@
+#ifndef SOLVERCONFIG_H
+#define SOLVERCONFIG_H
+
+#include <ContinuousBase.h>
+
+/*! SolverConfig holds the settings of a Numerov solve: the grid step, the tolerance of the scan and the
+ * bisections (on wavefunction[nbox] and on the energy bracket), the units hbar and mass, and the largest number
+ * of steps of a bisection or a regula falsi.
+ *
+ * The solvers take it as an explicit argument, passed down to the kernels, so that concurrent solves on
+ * different threads each use their own grid and a solve handed to another thread takes its settings along.
+ * The solves handed a grid (a ContinuousBase, a Wavefunction) replace the mesh of the configuration by its mesh.
+ *
+ * The argument defaults to the current configuration of the calling thread, read once when the call is made:
+ * a Scope makes a configuration current until it ends, a convenience for code that does not pass one. Threads
+ * start with the defaults: mesh 0.01, tolerance 1e-10, hbar = mass = 1.
+ *
+ * SolverConfig config(ContinuousBase(0.002, 5000));
+ * config.setTolerance(1e-12);
+ * double E = solve_Numerov_level(3, 5000, V, wavefunction, config);
+ */
+class SolverConfig {
+public:
+    static constexpr double defaultMesh = 0.01;
+    static constexpr double defaultTolerance = 1E-10;
+    static constexpr int defaultMaxIterations = 200;
+
+    SolverConfig() {}
+    //! The current configuration of the calling thread with the mesh of base
+    explicit SolverConfig(const ContinuousBase &base);
+
+    SolverConfig& setMesh(double mesh);
+    SolverConfig& setTolerance(double tolerance);
+    SolverConfig& setUnits(double hbar, double mass);
+    SolverConfig& setMaxIterations(int iterations);
+
+    double getMesh() const { return this->mesh; }
+    double getTolerance() const { return this->tolerance; }
+    double getHbar() const { return this->hbar; }
+    double getMass() const { return this->mass; }
+    int getMaxIterations() const { return this->maxIterations; }
+
+    //! (2 m / hbar^2) (mesh^2 / 12), the coefficient of the Numerov recurrence
+    double numerovFactor() const { return (2. * this->mass / this->hbar / this->hbar) * (this->mesh * this->mesh / 12.); }
+    //! hbar^2 / 2m
+    double kineticFactor() const { return this->hbar * this->hbar / (2. * this->mass); }
+
+    //! The configuration of the solves of the calling thread that are not given one
+    static const SolverConfig& current();
+
+    class Scope;
+
+private:
+    double mesh = defaultMesh;
+    double tolerance = defaultTolerance;
+    double hbar = 1.;
+    double mass = 1.;
+    int maxIterations = defaultMaxIterations;
+};
+
+//! Makes a configuration current on the calling thread, and restores the previous one when it ends
+class SolverConfig::Scope {
+public:
+    explicit Scope(const SolverConfig &config);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    SolverConfig config;
+    const SolverConfig *previous;
+};
+
+#endif
@@ -0,0 +1,458 @@
+#include "Spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "Analytic.h"
+#include "Bracketing.h"
+#include "Parity.h"
+#include "Schroedinger.h"
+
+namespace {
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    /*! Symmetric band matrix (half bandwidth w), stored by rows: lower[i * (w + 1) + k] = A(i, i - k).
+    */
+    struct BandMatrix {
+        int n, w;
+        std::vector<double> lower;
+
+        BandMatrix(int n, int w) : n(n), w(w), lower((std::size_t) n * (w + 1), 0.) {}
+        double& at(int i, int k) { return lower[(std::size_t) i * (w + 1) + k]; }
+        double at(int i, int k) const { return lower[(std::size_t) i * (w + 1) + k]; }
+        // A(i, j) for any i, j
+        double get(int i, int j) const {
+            int k = std::abs(i - j);
+            return (k > w) ? 0. : at(std::max(i, j), k);
+        }
+
+        // bound of |eigenvalue - A(i, i)| (Gershgorin)
+        void bounds(double &lo, double &hi) const {
+            lo = std::numeric_limits<double>::max();
+            hi = -lo;
+            for (int i = 0; i < n; i++) {
+                double radius = 0.;
+                for (int j = std::max(0, i - w); j <= std::min(n - 1, i + w); j++)
+                    if (j != i)
+                        radius += std::fabs(get(i, j));
+                lo = std::min(lo, get(i, i) - radius);
+                hi = std::max(hi, get(i, i) + radius);
+            }
+        }
+
+        /*! Eigenvalues below shift: by Sylvester's law of inertia, the negative pivots of the LDL^T factorization
+        of A - shift (without pivoting, a zero pivot is nudged, which only moves shift by rounding).
+        */
+        int countBelow(double shift, std::vector<double> &L, std::vector<double> &D) const {
+            int count = 0;
+            double tiny = eps * (1. + std::fabs(shift));
+            for (int i = 0; i < n; i++) {
+                // L(i, i - k) for k = 1..w, then D(i)
+                for (int k = w; k >= 1; k--) {
+                    int j = i - k;
+                    if (j < 0) {
+                        L[(std::size_t) i * (w + 1) + k] = 0.;
+                        continue;
+                    }
+                    double sum = at(i, k);
+                    for (int m = std::max(0, i - w); m < j; m++)
+                        sum -= L[(std::size_t) i * (w + 1) + (i - m)] * L[(std::size_t) j * (w + 1) + (j - m)] * D[m];
+                    L[(std::size_t) i * (w + 1) + k] = sum / D[j];
+                }
+                double d = at(i, 0) - shift;
+                for (int m = std::max(0, i - w); m < i; m++) {
+                    double l = L[(std::size_t) i * (w + 1) + (i - m)];
+                    d -= l * l * D[m];
+                }
+                if (std::fabs(d) < tiny)
+                    d = -tiny;
+                D[i] = d;
+                count += (d < 0);
+            }
+            return count;
+        }
+
+        /*! Solves (A - shift) x = b by Gaussian elimination with partial pivoting on the band, for inverse
+        iteration: shift is an eigenvalue to rounding, so a vanishing pivot is replaced by a tiny one.
+        */
+        void solveShifted(double shift, std::vector<double> &b) const {
+            // rows keep the columns [i - w, i + 2 w], the upper band grows by w with the row interchanges
+            const int width = 3 * w + 1;
+            std::vector<double> a((std::size_t) n * width, 0.);
+            auto entry = [&](int i, int j) -> double& { return a[(std::size_t) i * width + (j - i + w)]; };
+            double norm = 0.;
+            for (int i = 0; i < n; i++) {
+                for (int j = std::max(0, i - w); j <= std::min(n - 1, i + w); j++) {
+                    entry(i, j) = get(i, j) - ((i == j) ? shift : 0.);
+                    norm = std::max(norm, std::fabs(entry(i, j)));
+                }
+            }
+            double tiny = eps * std::max(norm, 1.);
+
+            for (int i = 0; i < n; i++) {
+                int last = std::min(n - 1, i + w), pivot = i;
+                for (int r = i + 1; r <= last; r++)
+                    if (std::fabs(entry(r, i)) > std::fabs(entry(pivot, i)))
+                        pivot = r;
+                int end = std::min(n - 1, i + 2 * w);
+                if (pivot != i) {
+                    for (int j = i; j <= end; j++)
+                        std::swap(entry(i, j), entry(pivot, j));
+                    std::swap(b[i], b[pivot]);
+                }
+                if (std::fabs(entry(i, i)) < tiny)
+                    entry(i, i) = tiny;
+                for (int r = i + 1; r <= last; r++) {
+                    double f = entry(r, i) / entry(i, i);
+                    if (f == 0.)
+                        continue;
+                    for (int j = i + 1; j <= end; j++)
+                        entry(r, j) -= f * entry(i, j);
+                    b[r] -= f * b[i];
+                }
+            }
+            for (int i = n - 1; i >= 0; i--) {
+                double sum = b[i];
+                for (int j = i + 1; j <= std::min(n - 1, i + 2 * w); j++)
+                    sum -= entry(i, j) * b[j];
+                b[i] = sum / entry(i, i);
+            }
+        }
+    };
+
+    double pythag(double a, double b) {
+        return std::hypot(a, b);
+    }
+
+    /*! Householder reduction of the symmetric n x n matrix a (row major) to tridiagonal form: d gets the
+    diagonal, e the subdiagonal (e[0] = 0) and, with vectors, a the orthogonal transformation.
+    */
+    void tridiagonalize(int n, std::vector<double> &a, std::vector<double> &d, std::vector<double> &e, bool vectors) {
+        auto z = [&](int i, int j) -> double& { return a[(std::size_t) i * n + j]; };
+        for (int i = n - 1; i > 0; i--) {
+            int l = i - 1;
+            double h = 0., scale = 0.;
+            if (l > 0) {
+                for (int k = 0; k < i; k++)
+                    scale += std::fabs(z(i, k));
+                if (scale == 0.) {
+                    e[i] = z(i, l);
+                }
+                else {
+                    for (int k = 0; k < i; k++) {
+                        z(i, k) /= scale;
+                        h += z(i, k) * z(i, k);
+                    }
+                    double f = z(i, l);
+                    double g = (f >= 0.) ? -std::sqrt(h) : std::sqrt(h);
+                    e[i] = scale * g;
+                    h -= f * g;
+                    z(i, l) = f - g;
+                    f = 0.;
+                    for (int j = 0; j < i; j++) {
+                        if (vectors)
+                            z(j, i) = z(i, j) / h;
+                        g = 0.;
+                        for (int k = 0; k < j + 1; k++)
+                            g += z(j, k) * z(i, k);
+                        for (int k = j + 1; k < i; k++)
+                            g += z(k, j) * z(i, k);
+                        e[j] = g / h;
+                        f += e[j] * z(i, j);
+                    }
+                    double hh = f / (h + h);
+                    for (int j = 0; j < i; j++) {
+                        f = z(i, j);
+                        e[j] = g = e[j] - hh * f;
+                        for (int k = 0; k < j + 1; k++)
+                            z(j, k) -= (f * e[k] + g * z(i, k));
+                    }
+                }
+            }
+            else {
+                e[i] = z(i, l);
+            }
+            d[i] = h;
+        }
+        if (vectors)
+            d[0] = 0.;
+        e[0] = 0.;
+        for (int i = 0; i < n; i++) {
+            if (vectors) {
+                if (d[i] != 0.) {
+                    for (int j = 0; j < i; j++) {
+                        double g = 0.;
+                        for (int k = 0; k < i; k++)
+                            g += z(i, k) * z(k, j);
+                        for (int k = 0; k < i; k++)
+                            z(k, j) -= g * z(k, i);
+                    }
+                }
+                d[i] = z(i, i);
+                z(i, i) = 1.;
+                for (int j = 0; j < i; j++)
+                    z(j, i) = z(i, j) = 0.;
+            }
+            else {
+                d[i] = z(i, i);
+            }
+        }
+    }
+
+    /*! Implicit QL with Wilkinson shifts on the tridiagonal (d, e) of tridiagonalize: d gets the eigenvalues
+    and, with vectors, the columns of z the eigenvectors.
+    */
+    void diagonalize(int n, std::vector<double> &d, std::vector<double> &e, std::vector<double> &zz, bool vectors) {
+        auto z = [&](int i, int j) -> double& { return zz[(std::size_t) i * n + j]; };
+        for (int i = 1; i < n; i++)
+            e[i - 1] = e[i];
+        e[n - 1] = 0.;
+
+        for (int l = 0; l < n; l++) {
+            int iter = 0, m;
+            do {
+                for (m = l; m < n - 1; m++) {
+                    double dd = std::fabs(d[m]) + std::fabs(d[m + 1]);
+                    if (std::fabs(e[m]) <= eps * dd)
+                        break;
+                }
+                if (m != l) {
+                    if (iter++ == 60)
+                        throw std::runtime_error("solve_spectrum: the QL iteration does not converge.");
+                    double g = (d[l + 1] - d[l]) / (2. * e[l]);
+                    double r = pythag(g, 1.);
+                    g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+                    double s = 1., c = 1., p = 0.;
+                    int i;
+                    for (i = m - 1; i >= l; i--) {
+                        double f = s * e[i], b = c * e[i];
+                        e[i + 1] = (r = pythag(f, g));
+                        if (r == 0.) {
+                            d[i + 1] -= p;
+                            e[m] = 0.;
+                            break;
+                        }
+                        s = f / r;
+                        c = g / r;
+                        g = d[i + 1] - p;
+                        r = (d[i] - g) * s + 2. * c * b;
+                        d[i + 1] = g + (p = s * r);
+                        g = c * r - b;
+                        if (vectors) {
+                            for (int k = 0; k < n; k++) {
+                                f = z(k, i + 1);
+                                z(k, i + 1) = s * z(k, i) + c * f;
+                                z(k, i) = c * z(k, i) - s * f;
+                            }
+                        }
+                    }
+                    if (r == 0. && i >= l)
+                        continue;
+                    d[l] -= p;
+                    e[l] = g;
+                    e[m] = 0.;
+                }
+            } while (m != l);
+        }
+    }
+
+    // interior values (points 1 .. nbox - 1) to a wavefunction of nbox + 1 values: walls, norm and sign of solve_Numerov
+    std::vector<double> wavefunction(const std::vector<double> &interior, double mesh) {
+        std::vector<double> psi(interior.size() + 2, 0.);
+        std::copy(interior.begin(), interior.end(), psi.begin() + 1);
+
+        std::vector<double> probab(psi.size());
+        for (std::size_t i = 0; i < psi.size(); i++)
+            probab[i] = psi[i] * psi[i];
+        double norm = std::sqrt(trap_array(0, (int) psi.size() - 1, mesh, probab.data()));
+
+        double largest = 0.;
+        for (double p : psi)
+            largest = std::max(largest, std::fabs(p));
+        for (double p : psi) {
+            if (std::fabs(p) > 1e-3 * largest) {
+                if (p < 0)
+                    norm = -norm;
+                break;
+            }
+        }
+        for (double &p : psi)
+            p /= norm;
+        return psi;
+    }
+
+    void check_levels(int levels, int unknowns) {
+        if (levels < 1)
+            throw std::invalid_argument("solve_spectrum needs at least one level.");
+        if (levels > unknowns)
+            throw std::invalid_argument("solve_spectrum: more levels than grid points.");
+    }
+
+    // the analytic levels of the built-in potentials are the first guesses of the brackets
+    Spectrum numerov_spectrum(int levels, const ContinuousBase &base, const Potential &V, bool vectors,
+                              const SolverConfig &settings) {
+        int nbox = (int) base.getNbox();
+        const SolverConfig config = SolverConfig(settings).setMesh(base.getMesh());
+        std::vector<double> guesses = analytic_states(levels, base, V, false, config).energies;
+        if (is_symmetric(nbox, V))
+            return solve_Numerov_symmetric(levels, nbox, V, vectors, guesses, config);
+        Spectrum spectrum;
+        std::vector<double> psi(nbox + 1);
+        for (int n = 0; n < levels; n++) {
+            psi[0] = 0.;
+            psi[1] = 0.01;
+            double E = solve_Numerov_level(n, nbox, V, psi.data(), config, guesses[n]);
+            spectrum.energies.push_back(E);
+            if (vectors)
+                spectrum.wavefunctions.push_back(psi);
+        }
+        return spectrum;
+    }
+
+    /*! H = -hbar^2 / 2m psi'' + V psi with psi''_i = (psi_{i-3} / 90 - 3 psi_{i-2} / 20 + 3 psi_{i-1} / 2
+    - 49 psi_i / 18 + ...) / h^2, the points beyond the walls reflected as psi_{-m} = -psi_m.
+    */
+    Spectrum fd6_spectrum(int levels, int nbox, double mesh, const Potential &V, bool vectors, const SolverConfig &config) {
+        const int n = nbox - 1, w = 3;
+        const double c[4] = {-49. / 18., 3. / 2., -3. / 20., 1. / 90.};
+        const double t = -config.kineticFactor() / (mesh * mesh);
+        const std::vector<double> &values = V.getValues();
+        check_levels(levels, n);
+
+        BandMatrix H(n, w);
+        // unknown u is grid point u + 1; H is symmetric, so only the columns up to u are added
+        for (int u = 0; u < n; u++) {
+            H.at(u, 0) += values[u + 1];
+            for (int k = -w; k <= w; k++) {
+                int point = u + 1 + k, column = point - 1;
+                double sign = 1.;
+                if (point == 0 || point == nbox)
+                    continue;
+                if (point < 0) {
+                    column = -point - 1;
+                    sign = -1.;
+                }
+                else if (point > nbox) {
+                    column = 2 * nbox - point - 1;
+                    sign = -1.;
+                }
+                if (column <= u)
+                    H.at(u, u - column) += sign * t * c[std::abs(k)];
+            }
+        }
+
+        Spectrum spectrum;
+        std::vector<double> L((std::size_t) n * (w + 1)), D(n);
+        double lo, hi;
+        H.bounds(lo, hi);
+        for (int level = 0; level < levels; level++) {
+            // bisection on the number of eigenvalues below E, from the previous level up
+            double a = spectrum.energies.empty() ? lo : spectrum.energies.back(), b = hi;
+            while (b - a > 4 * eps * std::max(std::fabs(a), std::fabs(b)) + std::numeric_limits<double>::min()) {
+                double middle = (a + b) / 2.;
+                if (middle <= a || middle >= b)
+                    break;
+                if (H.countBelow(middle, L, D) > level)
+                    b = middle;
+                else
+                    a = middle;
+            }
+            double E = (a + b) / 2.;
+            spectrum.energies.push_back(E);
+
+            if (vectors) {
+                std::vector<double> x(n);
+                for (int u = 0; u < n; u++)
+                    x[u] = 1. + 0.1 * std::sin(0.7 * u);
+                for (int iter = 0; iter < 3; iter++) {
+                    H.solveShifted(E, x);
+                    double norm = std::sqrt(std::inner_product(x.begin(), x.end(), x.begin(), 0.));
+                    for (double &v : x)
+                        v /= norm;
+                }
+                spectrum.wavefunctions.push_back(wavefunction(x, mesh));
+            }
+        }
+        return spectrum;
+    }
+
+    /*! Sinc DVR of the box (x_0, x_nbox) with the interior points as grid (Colbert and Miller, JCP 96, 1982):
+    T_ij = hbar^2 / 2m pi^2 / (2 L^2) (-1)^(i-j) [1 / sin^2(pi (i-j) / 2N) - 1 / sin^2(pi (i+j) / 2N)],
+    T_ii = hbar^2 / 2m pi^2 / (2 L^2) [(2 N^2 + 1) / 3 - 1 / sin^2(pi i / N)], with N = nbox, L = nbox h.
+    */
+    Spectrum dvr_spectrum(int levels, int nbox, double mesh, const Potential &V, bool vectors, const SolverConfig &config) {
+        const int n = nbox - 1;
+        const double N = nbox, L = nbox * mesh;
+        const double t = config.kineticFactor() * M_PI * M_PI / (2. * L * L);
+        const std::vector<double> &values = V.getValues();
+        check_levels(levels, n);
+
+        std::vector<double> H((std::size_t) n * n);
+        for (int u = 0; u < n; u++) {
+            int i = u + 1;
+            for (int v = 0; v < u; v++) {
+                int j = v + 1;
+                double si = std::sin(M_PI * (i - j) / (2. * N)), sj = std::sin(M_PI * (i + j) / (2. * N));
+                double T = t * (((i - j) % 2) ? -1. : 1.) * (1. / (si * si) - 1. / (sj * sj));
+                H[(std::size_t) u * n + v] = H[(std::size_t) v * n + u] = T;
+            }
+            double s = std::sin(M_PI * i / N);
+            H[(std::size_t) u * n + u] = t * ((2. * N * N + 1.) / 3. - 1. / (s * s)) + values[i];
+        }
+
+        std::vector<double> d(n), e(n);
+        tridiagonalize(n, H, d, e, vectors);
+        diagonalize(n, d, e, H, vectors);
+
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return d[a] < d[b]; });
+
+        Spectrum spectrum;
+        for (int level = 0; level < levels; level++) {
+            spectrum.energies.push_back(d[order[level]]);
+            if (vectors) {
+                std::vector<double> x(n);
+                for (int u = 0; u < n; u++)
+                    x[u] = H[(std::size_t) u * n + order[level]];
+                spectrum.wavefunctions.push_back(wavefunction(x, mesh));
+            }
+        }
+        return spectrum;
+    }
+}
+
+Spectrum::Engine Spectrum::engine(const std::string& name)
+{
+    if (name == "numerov")
+        return Numerov;
+    if (name == "fd6")
+        return FiniteDifference6;
+    if (name == "dvr")
+        return SincDVR;
+    throw std::invalid_argument("Unknown engine \"" + name + "\" (numerov, fd6 or dvr).");
+}
+
+Spectrum solve_spectrum(Spectrum::Engine engine, int levels, ContinuousBase base, const Potential &V, bool wavefunctions,
+                        const SolverConfig &config)
+{
+    int nbox = (int) base.getNbox();
+    double mesh = base.getMesh();
+    if (nbox < 3)
+        throw std::invalid_argument("solve_spectrum needs at least two interior points.");
+    if ((int) V.getValues().size() < nbox)
+        throw std::invalid_argument("The potential holds fewer values than the grid.");
+
+    switch (engine) {
+        case Spectrum::Numerov:
+            return numerov_spectrum(levels, base, V, wavefunctions, config);
+        case Spectrum::FiniteDifference6:
+            return fd6_spectrum(levels, nbox, mesh, V, wavefunctions, config);
+        case Spectrum::SincDVR:
+            return dvr_spectrum(levels, nbox, mesh, V, wavefunctions, config);
+    }
+    throw std::invalid_argument("Unknown engine.");
+}
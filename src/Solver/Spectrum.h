@@ -0,0 +1,41 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <string>
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include "SolverConfig.h"
+
+/*! Lowest levels of the hard wall problem on a ContinuousBase, with one of three discretizations of the
+ * same grid (the walls are x_0 and x_nbox, the unknowns the nbox - 1 points in between):
+ * - Numerov: solve_Numerov_level for every level, fourth order, with config on the mesh of the grid.
+ *   A symmetric potential (is_symmetric) is solved by parity sectors on the half grid, solve_Numerov_symmetric
+ * - FiniteDifference6: the sixth order seven point stencil of psi'', walls imposed by odd reflection.
+ *   The banded Hamiltonian is never stored dense: levels are isolated by bisection on its inertia
+ *   (the negative pivots of the LDL^T of H - E) and the wavefunctions found by inverse iteration
+ * - SincDVR: the sinc discrete variable representation of a box (Colbert and Miller), spectrally accurate
+ *   for smooth potentials: a few hundred points reach 1e-10 where Numerov needs tens of thousands.
+ *   The dense Hamiltonian is diagonalized by Householder reduction and implicit QL, O(nbox^3)
+ *
+ * All three work on any mesh, in the units (hbar, mass) of config (SolverConfig::current() if it is left out).
+ * Wavefunctions hold nbox + 1 values, vanish at the walls, are normalized to 1 (trapezoidal rule) and their first
+ * lobe is positive, as those of solve_Numerov.
+ *
+ * Spectrum s = solve_spectrum(Spectrum::SincDVR, 4, ContinuousBase(0.1, 200), V);
+ */
+struct Spectrum {
+    enum Engine { Numerov = 0, FiniteDifference6 = 1, SincDVR = 2 };
+
+    std::vector<double> energies;                      // ascending
+    std::vector< std::vector<double> > wavefunctions;  // empty unless asked for
+
+    //! "numerov", "fd6" or "dvr"; throws invalid_argument otherwise
+    static Engine engine(const std::string& name);
+};
+
+Spectrum solve_spectrum(Spectrum::Engine engine, int levels, ContinuousBase base, const Potential &V,
+                        bool wavefunctions = true, const SolverConfig &config = SolverConfig::current());
+
+#endif
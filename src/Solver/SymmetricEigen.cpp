@@ -0,0 +1,45 @@
+#include "SymmetricEigen.h"
+
+#include <cmath>
+
+void symmetric_eigen(std::vector<double> &A, std::vector<double> &U, int n)
+{
+    U.assign((std::size_t) n * n, 0.);
+    for (int i = 0; i < n; i++)
+        U[i * n + i] = 1.;
+
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = 0., diagonal = 0.;
+        for (int p = 0; p < n; p++) {
+            diagonal += A[p * n + p] * A[p * n + p];
+            for (int q = p + 1; q < n; q++)
+                off += A[p * n + q] * A[p * n + q];
+        }
+        if (off <= 1e-32 * diagonal)
+            return;
+
+        for (int p = 0; p < n; p++)
+            for (int q = p + 1; q < n; q++) {
+                if (A[p * n + q] == 0.)
+                    continue;
+                double theta = (A[q * n + q] - A[p * n + p]) / (2. * A[p * n + q]);
+                double t = (theta >= 0. ? 1. : -1.) / (std::fabs(theta) + std::sqrt(theta * theta + 1.));
+                double c = 1. / std::sqrt(t * t + 1.), s = t * c;
+                for (int k = 0; k < n; k++) {
+                    double akp = A[k * n + p], akq = A[k * n + q];
+                    A[k * n + p] = c * akp - s * akq;
+                    A[k * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++) {
+                    double apk = A[p * n + k], aqk = A[q * n + k];
+                    A[p * n + k] = c * apk - s * aqk;
+                    A[q * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++) {
+                    double ukp = U[k * n + p], ukq = U[k * n + q];
+                    U[k * n + p] = c * ukp - s * ukq;
+                    U[k * n + q] = s * ukp + c * ukq;
+                }
+            }
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef SYMMETRICEIGEN_H
+#define SYMMETRICEIGEN_H
+
+#include <vector>
+
+/*! Diagonalizes the symmetric n x n matrix A (row major) by cyclic Jacobi rotations: the eigenvalues are left
+ * on the diagonal of A (unordered), the eigenvectors in the columns of U. For the small dense matrices of the
+ * solvers (Rayleigh-Ritz, matching matrices), up to a few hundred rows.
+ */
+void symmetric_eigen(std::vector<double> &A, std::vector<double> &U, int n);
+
+#endif
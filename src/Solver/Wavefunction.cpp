@@ -0,0 +1,163 @@
+#include "Wavefunction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+WavefunctionPool& WavefunctionPool::global()
+{
+    static WavefunctionPool pool;
+    return pool;
+}
+
+double* WavefunctionPool::acquire(std::size_t size, std::size_t& capacity)
+{
+    // the smallest class is a cache line
+    capacity = alignment / sizeof(double);
+    while (capacity < size)
+        capacity *= 2;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto cached = this->free.find(capacity);
+        if (cached != this->free.end() && !cached->second.empty()) {
+            double *buffer = cached->second.back();
+            cached->second.pop_back();
+            this->reuses++;
+            return buffer;
+        }
+        this->allocations++;
+    }
+
+    void *buffer = std::aligned_alloc(alignment, capacity * sizeof(double));
+    if (!buffer)
+        throw std::bad_alloc();
+    return (double *) buffer;
+}
+
+void WavefunctionPool::release(double* buffer, std::size_t capacity)
+{
+    if (!buffer)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::vector<double*> &cached = this->free[capacity];
+        if (cached.size() < maxCached) {
+            cached.push_back(buffer);
+            return;
+        }
+    }
+    std::free(buffer);
+}
+
+void WavefunctionPool::trim()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto &cls : this->free)
+        for (double *buffer : cls.second)
+            std::free(buffer);
+    this->free.clear();
+}
+
+unsigned long WavefunctionPool::getAllocations()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->allocations;
+}
+
+unsigned long WavefunctionPool::getReuses()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->reuses;
+}
+
+std::size_t WavefunctionPool::getCached()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::size_t cached = 0;
+    for (auto &cls : this->free)
+        cached += cls.second.size();
+    return cached;
+}
+
+WavefunctionPool::~WavefunctionPool()
+{
+    trim();
+}
+
+Wavefunction::Wavefunction(ContinuousBase base)
+    : Wavefunction((int) base.getNbox(), base.getStart(), base.getMesh()) {}
+
+Wavefunction::Wavefunction(int nbox, double start, double mesh)
+{
+    if (nbox < 2)
+        throw std::invalid_argument("A wavefunction needs at least two grid points.");
+    this->nbox   = nbox;
+    this->start  = start;
+    this->mesh   = mesh;
+    this->values = WavefunctionPool::global().acquire(size(), this->capacity);
+    std::fill(begin(), end(), 0.);
+    reset();
+}
+
+Wavefunction::~Wavefunction()
+{
+    WavefunctionPool::global().release(this->values, this->capacity);
+}
+
+Wavefunction::Wavefunction(Wavefunction&& other) noexcept
+    : values(other.values), capacity(other.capacity), nbox(other.nbox), start(other.start), mesh(other.mesh)
+{
+    other.values   = nullptr;
+    other.capacity = 0;
+    other.nbox     = 0;
+}
+
+Wavefunction& Wavefunction::operator=(Wavefunction&& other) noexcept
+{
+    if (this != &other) {
+        WavefunctionPool::global().release(this->values, this->capacity);
+        this->values   = other.values;
+        this->capacity = other.capacity;
+        this->nbox     = other.nbox;
+        this->start    = other.start;
+        this->mesh     = other.mesh;
+        other.values   = nullptr;
+        other.capacity = 0;
+        other.nbox     = 0;
+    }
+    return *this;
+}
+
+Wavefunction Wavefunction::clone() const
+{
+    Wavefunction copy(this->nbox, this->start, this->mesh);
+    std::copy(begin(), end(), copy.begin());
+    return copy;
+}
+
+double Wavefunction::norm() const
+{
+    const double *psi = (const double *) __builtin_assume_aligned(this->values, WavefunctionPool::alignment);
+    double sum = 0.;
+    for (int i = 1; i < this->nbox; i++)
+        sum += psi[i] * psi[i];
+    sum += (psi[0] * psi[0] + psi[this->nbox] * psi[this->nbox]) / 2.;
+    return sum * this->mesh;
+}
+
+void Wavefunction::normalize()
+{
+    double *psi = (double *) __builtin_assume_aligned(this->values, WavefunctionPool::alignment);
+    double scale = 1. / std::sqrt(norm());
+    for (std::size_t i = 0; i < size(); i++)
+        psi[i] *= scale;
+}
+
+void Wavefunction::reset()
+{
+    this->values[0] = 0.;
+    this->values[1] = 0.01;
+}
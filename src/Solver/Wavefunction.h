@@ -0,0 +1,94 @@
+#ifndef WAVEFUNCTION_H
+#define WAVEFUNCTION_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <ContinuousBase.h>
+
+/*! WavefunctionPool recycles the buffers of Wavefunction: buffers are 64 byte aligned and come in size
+ * classes (capacities are powers of two), so that a sweep or a server solving the same grids over and
+ * over allocates once per grid size. At most maxCached buffers of each class are kept; all methods are thread safe.
+ */
+class WavefunctionPool {
+public:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::size_t maxCached = 32;
+
+    //! The pool of every Wavefunction
+    static WavefunctionPool& global();
+
+    //! A buffer of at least size doubles; capacity gets its size class
+    double* acquire(std::size_t size, std::size_t& capacity);
+    void release(double* buffer, std::size_t capacity);
+    //! Frees the cached buffers
+    void trim();
+
+    unsigned long getAllocations();
+    unsigned long getReuses();
+    std::size_t getCached();
+
+    ~WavefunctionPool();
+
+private:
+    std::mutex mutex;
+    std::map< std::size_t, std::vector<double*> > free;
+    unsigned long allocations = 0, reuses = 0;
+};
+
+/*! Wavefunction is a wavefunction on the grid of a ContinuousBase: nbox + 1 values (the last one is the right
+ * wall, written by the Numerov sweep), with the start and mesh of the grid. Its buffer is 64 byte aligned and
+ * taken from (and given back to) the WavefunctionPool. It is move only: copies are explicit, with clone().
+ *
+ * A new Wavefunction is zero, but for the conventional starting values of solve_Numerov: psi[0] = 0, psi[1] = 0.01.
+ *
+ * Wavefunction psi(base);
+ * double E = solve_Numerov(0., 2., 0.01, V, psi);
+ */
+class Wavefunction {
+public:
+    explicit Wavefunction(ContinuousBase base);
+    explicit Wavefunction(int nbox, double start = 0., double mesh = 0.01);
+    ~Wavefunction();
+
+    Wavefunction(Wavefunction&& other) noexcept;
+    Wavefunction& operator=(Wavefunction&& other) noexcept;
+    Wavefunction(const Wavefunction&) = delete;
+    Wavefunction& operator=(const Wavefunction&) = delete;
+
+    Wavefunction clone() const;
+
+    double* data() { return this->values; }
+    const double* data() const { return this->values; }
+    double& operator[](std::size_t i) { return this->values[i]; }
+    double operator[](std::size_t i) const { return this->values[i]; }
+    double* begin() { return this->values; }
+    double* end() { return this->values + size(); }
+    const double* begin() const { return this->values; }
+    const double* end() const { return this->values + size(); }
+
+    //! nbox + 1
+    std::size_t size() const { return (std::size_t) this->nbox + 1; }
+    int getNbox() const { return this->nbox; }
+    double getStart() const { return this->start; }
+    double getMesh() const { return this->mesh; }
+    //! Position of point i
+    double x(std::size_t i) const { return this->start + this->mesh * i; }
+
+    //! Integral of |psi|^2 (trapezoidal rule)
+    double norm() const;
+    //! Scales psi to norm 1
+    void normalize();
+    //! Sets the starting values of a new solve: psi[0] = 0, psi[1] = 0.01
+    void reset();
+
+private:
+    double *values = nullptr;
+    std::size_t capacity = 0;
+    int nbox = 0;
+    double start = 0., mesh = 0.;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "MappedBlock.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // the first tile of the file holds this header, the rows follow
+    struct Header {
+        char magic[8];
+        std::uint64_t rows, columns, tile, stride;
+    };
+    const char magic[8] = {'S', 'C', 'H', 'R', 'B', 'L', 'K', '1'};
+
+    std::runtime_error failure(const std::string &what, const std::string &path) {
+        return std::runtime_error("MappedBlock: " + what + " " + path + ": " + std::strerror(errno));
+    }
+
+    // bytes of a row (a whole number of tiles) and of the file; false if they overflow
+    bool layout(std::size_t rows, std::size_t columns, std::size_t tile, std::size_t &bytes, std::size_t &size) {
+        const std::size_t largest = std::numeric_limits<std::size_t>::max();
+        if (tile == 0 || columns > (largest - (tile - 1)) / sizeof(double))
+            return false;
+        bytes = (columns * sizeof(double) + tile - 1) / tile * tile;
+        if (rows > (largest - tile) / bytes || tile + rows * bytes > (std::size_t) std::numeric_limits<off_t>::max())
+            return false;
+        size = tile + rows * bytes;
+        return true;
+    }
+}
+
+MappedBlock MappedBlock::scratch(const std::string &directory, std::size_t rows, std::size_t columns,
+                                 std::size_t tile)
+{
+    std::string name = directory + "/MappedBlock.XXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0)
+        throw failure("cannot create a scratch file in", directory);
+    unlink(name.c_str());
+
+    MappedBlock block;
+    block.map(fd, rows, columns, tile, true);
+    return block;
+}
+
+MappedBlock MappedBlock::create(const std::string &path, std::size_t rows, std::size_t columns, std::size_t tile)
+{
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw failure("cannot create", path);
+
+    MappedBlock block;
+    block.map(fd, rows, columns, tile, true);
+    return block;
+}
+
+MappedBlock MappedBlock::open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0)
+        throw failure("cannot open", path);
+
+    Header header;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)
+        || std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        close(fd);
+        throw std::runtime_error("MappedBlock: " + path + " is not a block file.");
+    }
+
+    // a truncated or partly written file would map fine and fault on the first missing row
+    std::size_t bytes = 0, size = 0;
+    struct stat status;
+    if (header.rows < 1 || header.columns < 1
+        || !layout(header.rows, header.columns, header.tile, bytes, size) || header.stride != bytes / sizeof(double)
+        || fstat(fd, &status) != 0 || (std::uint64_t) status.st_size < size) {
+        close(fd);
+        throw std::runtime_error("MappedBlock: " + path + " is truncated or its header is inconsistent.");
+    }
+
+    MappedBlock block;
+    block.map(fd, header.rows, header.columns, header.tile, false);
+    return block;
+}
+
+void MappedBlock::map(int fd, std::size_t rows, std::size_t columns, std::size_t tile, bool initialize)
+{
+    const std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE);
+    if (rows < 1 || columns < 1) {
+        close(fd);
+        throw std::invalid_argument("A block needs at least one row and one column.");
+    }
+    if (tile < page || tile % page != 0) {
+        close(fd);
+        throw std::invalid_argument("The tile must be a multiple of the page size.");
+    }
+
+    std::size_t bytes, size;
+    if (!layout(rows, columns, tile, bytes, size)) {
+        close(fd);
+        throw std::invalid_argument("The block does not fit in the address space.");
+    }
+    if (initialize && ftruncate(fd, (off_t) size) != 0) {
+        close(fd);
+        throw failure("cannot size the file of", "a block");
+    }
+
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // the mapping keeps the file
+    if (memory == MAP_FAILED)
+        throw failure("cannot map", "a block");
+
+    this->memory  = memory;
+    this->size    = size;
+    this->data    = reinterpret_cast<double*>(static_cast<char*>(memory) + tile);
+    this->rows    = rows;
+    this->columns = columns;
+    this->stride  = bytes / sizeof(double);
+    this->tile    = tile;
+
+    if (initialize) {
+        Header header;
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.rows    = rows;
+        header.columns = columns;
+        header.tile    = tile;
+        header.stride  = this->stride;
+        std::memcpy(memory, &header, sizeof(header));
+    }
+}
+
+MappedBlock::~MappedBlock()
+{
+    release();
+}
+
+void MappedBlock::release()
+{
+    if (this->memory)
+        munmap(this->memory, this->size);
+    this->memory = nullptr;
+    this->data   = nullptr;
+}
+
+MappedBlock::MappedBlock(MappedBlock &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedBlock& MappedBlock::operator=(MappedBlock &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        this->memory  = std::exchange(other.memory, nullptr);
+        this->data    = std::exchange(other.data, nullptr);
+        this->size    = std::exchange(other.size, 0);
+        this->rows    = std::exchange(other.rows, 0);
+        this->columns = std::exchange(other.columns, 0);
+        this->stride  = std::exchange(other.stride, 0);
+        this->tile    = std::exchange(other.tile, 0);
+    }
+    return *this;
+}
+
+std::vector<const double*> MappedBlock::rowPointers() const
+{
+    std::vector<const double*> pointers(this->rows);
+    for (std::size_t r = 0; r < this->rows; r++)
+        pointers[r] = row(r);
+    return pointers;
+}
+
+void MappedBlock::range(std::size_t first, std::size_t last, char *&begin, std::size_t &length) const
+{
+    last  = std::min(last, this->rows);
+    first = std::min(first, last);
+    begin  = reinterpret_cast<char*>(this->data + first * this->stride);
+    length = (last - first) * this->stride * sizeof(double);
+}
+
+void MappedBlock::prefetch(std::size_t first, std::size_t last)
+{
+    char *begin;
+    std::size_t length;
+    range(first, last, begin, length);
+    if (length)
+        madvise(begin, length, MADV_WILLNEED);
+}
+
+void MappedBlock::sequential()
+{
+    madvise(this->memory, this->size, MADV_SEQUENTIAL);
+}
+
+void MappedBlock::flush(std::size_t first, std::size_t last, bool wait)
+{
+    char *begin;
+    std::size_t length;
+    range(first, last, begin, length);
+    if (length && msync(begin, length, wait ? MS_SYNC : MS_ASYNC) != 0)
+        throw failure("cannot write back", "a block");
+}
+
+void MappedBlock::evict(std::size_t first, std::size_t last)
+{
+    char *begin;
+    std::size_t length;
+    range(first, last, begin, length);
+    if (!length)
+        return;
+    // a shared mapping drops its pages only once they are clean, so they are written first
+    if (msync(begin, length, MS_SYNC) != 0)
+        throw failure("cannot write back", "a block");
+    madvise(begin, length, MADV_DONTNEED);
+}
+
+void MappedBlock::stream(std::size_t window, const std::function<void(std::size_t, double*)> &kernel)
+{
+    window = std::max<std::size_t>(window, 1);
+    prefetch(0, window);
+    std::size_t first = 0;
+    for (; first < this->rows; first += window) {
+        std::size_t last = std::min(first + window, this->rows);
+        prefetch(last, last + window);
+        for (std::size_t r = first; r < last; r++)
+            kernel(r, row(r));
+        if (first >= window)
+            evict(first - window, first);
+    }
+    // the last window is still resident
+    evict(first - window, this->rows);
+}
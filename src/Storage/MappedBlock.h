@@ -0,0 +1,85 @@
+#ifndef MAPPEDBLOCK_H
+#define MAPPEDBLOCK_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*! MappedBlock is a rows x columns array of doubles kept in a memory mapped file instead of memory, for data
+ * larger than RAM: a block of eigenvectors (a row per state, a column per grid point), or a 3D grid (a row per
+ * plane of nx * ny points). The kernel pages rows in on first touch and writes them back to the file, so only
+ * the rows in use need to be resident.
+ *
+ * Layout: every row starts on a tile boundary (a multiple of the page size, 4096 bytes by default), and its
+ * stride is padded to whole tiles, so that a row is prefetched, written back or evicted without touching its
+ * neighbours, and it is aligned for the vector loops of the solvers.
+ *
+ * Residency is steered row range by row range:
+ * - prefetch() asks the kernel to read rows ahead (madvise WILLNEED), sequential() declares a front to back pass
+ * - flush() writes dirty rows back to the file, asynchronously or waiting for the disk (msync)
+ * - evict() writes rows back and drops them from memory (msync, then madvise DONTNEED): they are read
+ *   again from the file when next touched
+ * - stream() runs a kernel over all rows, prefetching the next window of rows and evicting the previous one,
+ *   so that at most about two windows are resident
+ *
+ * A scratch block lives in an unlinked file of a directory (the file goes away with the block, or with the
+ * process); a named block is kept in its file and can be reopened with MappedBlock::open. Move only.
+ *
+ * MappedBlock states = MappedBlock::scratch("/scratch", 500, nx * ny * nz);
+ * double *psi = states.row(17);
+ */
+class MappedBlock {
+public:
+    //! Block in an unlinked temporary file of directory, zero filled
+    static MappedBlock scratch(const std::string& directory, std::size_t rows, std::size_t columns,
+                               std::size_t tile = 4096);
+    //! Block kept in path (created or truncated), zero filled
+    static MappedBlock create(const std::string& path, std::size_t rows, std::size_t columns, std::size_t tile = 4096);
+    //! Block made by create() before; throws std::runtime_error if the file is shorter than its header says
+    static MappedBlock open(const std::string& path);
+
+    ~MappedBlock();
+    MappedBlock(MappedBlock&& other) noexcept;
+    MappedBlock& operator=(MappedBlock&& other) noexcept;
+    MappedBlock(const MappedBlock&) = delete;
+    MappedBlock& operator=(const MappedBlock&) = delete;
+
+    double* row(std::size_t r) { return this->data + r * this->stride; }
+    const double* row(std::size_t r) const { return this->data + r * this->stride; }
+    //! Pointers to every row, e.g. for Observables
+    std::vector<const double*> rowPointers() const;
+
+    std::size_t getRows() const { return this->rows; }
+    std::size_t getColumns() const { return this->columns; }
+    //! Doubles from one row to the next, columns rounded up to whole tiles
+    std::size_t getStride() const { return this->stride; }
+    std::size_t getTile() const { return this->tile; }
+
+    //! Rows [first, last) are read ahead
+    void prefetch(std::size_t first, std::size_t last);
+    //! The whole block is read front to back (larger read ahead, pages dropped soon after use)
+    void sequential();
+    //! Rows [first, last) written back to the file; wait blocks until they are on disk
+    void flush(std::size_t first, std::size_t last, bool wait = false);
+    //! Rows [first, last) written back and dropped from memory
+    void evict(std::size_t first, std::size_t last);
+    /*! kernel(r, row(r)) for every row in order, window rows at a time: the next window is prefetched while
+     * the current one runs, and the previous one evicted.
+     */
+    void stream(std::size_t window, const std::function<void(std::size_t, double*)>& kernel);
+
+private:
+    MappedBlock() {}
+    void map(int fd, std::size_t rows, std::size_t columns, std::size_t tile, bool initialize);
+    // byte range of rows [first, last) in the mapping
+    void range(std::size_t first, std::size_t last, char*& begin, std::size_t& length) const;
+    void release();
+
+    void *memory = nullptr;
+    std::size_t size = 0;      // bytes mapped: the header tile, then the rows
+    double *data = nullptr;
+    std::size_t rows = 0, columns = 0, stride = 0, tile = 0;
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "Checkpoint.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    const char magic[8] = {'S', 'C', 'H', 'C', 'K', 'P', 'T', '1'};
+    // type, level, a, b: the job id follows
+    const std::size_t fixed_payload = 1 + 4 + 8 + 8;
+    const std::size_t max_payload = 1 << 20;
+
+    template<typename T>
+    void put(std::string &buffer, const T &value) {
+        buffer.append((const char *) &value, sizeof(T));
+    }
+
+    template<typename T>
+    T get(const char *data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+}
+
+std::uint32_t crc32(const void *data, std::size_t size)
+{
+    static std::uint32_t table[256] = {0};
+    static bool ready = [] {
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void) ready;
+
+    std::uint32_t crc = 0xFFFFFFFFu;
+    const unsigned char *bytes = (const unsigned char *) data;
+    for (std::size_t i = 0; i < size; i++)
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+Checkpoint::Checkpoint(std::string path, double interval, Writer writer)
+{
+    this->path = path;
+    this->interval = (interval > 0) ? interval : 0.;
+    this->mode = writer;
+    this->period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(this->interval));
+    this->lastSync = std::chrono::steady_clock::now();
+
+    this->fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (this->fd < 0)
+        throw std::runtime_error("Cannot open checkpoint " + path + ": " + std::strerror(errno));
+
+    try {
+        recover();
+    }
+    catch (...) {
+        close(this->fd);
+        throw;
+    }
+    if (this->mode == Threaded)
+        this->writer = std::thread(&Checkpoint::writeLoop, this);
+}
+
+Checkpoint::~Checkpoint()
+{
+    if (this->mode == Inline) {
+        flush();
+        close(this->fd);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_one();
+    this->writer.join();
+    close(this->fd);
+}
+
+/*! Reads the records back and applies them; the file is cut at the first record that is short or
+whose CRC does not match (a write torn by a crash), so that new records follow the last complete one.
+*/
+void Checkpoint::recover()
+{
+    std::ifstream in(this->path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(magic)) {
+        // new (or torn before its header was complete)
+        if (ftruncate(this->fd, 0) != 0 || write(this->fd, magic, sizeof(magic)) != (ssize_t) sizeof(magic))
+            throw std::runtime_error("Cannot write checkpoint " + this->path + ": " + std::strerror(errno));
+        return;
+    }
+    if (std::memcmp(data.data(), magic, sizeof(magic)) != 0)
+        throw std::invalid_argument(this->path + " is not a checkpoint file.");
+
+    std::size_t pos = sizeof(magic);
+    while (pos + 4 <= data.size()) {
+        std::uint32_t size = get<std::uint32_t>(data.data() + pos);
+        if (size < fixed_payload || size > max_payload || pos + 4 + size + 4 > data.size())
+            break;
+        const char *payload = data.data() + pos + 4;
+        if (crc32(payload, size) != get<std::uint32_t>(payload + size))
+            break;
+
+        Record record;
+        record.type  = (Type) get<std::uint8_t>(payload);
+        record.level = get<std::int32_t>(payload + 1);
+        record.a     = get<double>(payload + 5);
+        record.b     = get<double>(payload + 13);
+        record.job.assign(payload + fixed_payload, size - fixed_payload);
+        apply(record);
+
+        this->recovered++;
+        pos += 4 + size + 4;
+    }
+
+    if (pos < data.size()) {
+        this->discarded = data.size() - pos;
+        if (ftruncate(this->fd, (off_t) pos) != 0)
+            throw std::runtime_error("Cannot truncate checkpoint " + this->path + ": " + std::strerror(errno));
+    }
+}
+
+void Checkpoint::apply(const Record& record)
+{
+    Job &job = this->jobs[record.job];
+    if (record.type == Finished) {
+        job.finished = true;
+        return;
+    }
+    if (record.level < 0)
+        return;
+    if ((std::size_t) record.level >= job.levels.size())
+        job.levels.resize(record.level + 1);
+
+    Level &level = job.levels[record.level];
+    if (record.type == Bracket) {
+        level.Emin = record.a;
+        level.Emax = record.b;
+    }
+    else if (record.type == Converged) {
+        level.energy = record.a;
+    }
+}
+
+void Checkpoint::append(Record record)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        apply(record);
+        this->queue.push_back(std::move(record));
+        this->queued++;
+    }
+    this->wake.notify_one();
+}
+
+void Checkpoint::bracket(const std::string& job, int level, double Emin, double Emax)
+{
+    append(Record{Bracket, level, Emin, Emax, job});
+}
+
+void Checkpoint::converged(const std::string& job, int level, double energy)
+{
+    append(Record{Converged, level, energy, 0., job});
+}
+
+void Checkpoint::finished(const std::string& job)
+{
+    append(Record{Finished, -1, 0., 0., job});
+}
+
+void Checkpoint::flush()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (this->mode == Inline) {
+        writeQueue(lock, true);
+        return;
+    }
+    unsigned long target = this->queued;
+    this->flushing = true;
+    this->wake.notify_one();
+    this->written.wait(lock, [&] { return this->synced >= target; });
+}
+
+bool Checkpoint::isFinished(const std::string& job)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->jobs.find(job);
+    return it != this->jobs.end() && it->second.finished;
+}
+
+std::vector<Checkpoint::Level> Checkpoint::levels(const std::string& job)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->jobs.find(job);
+    return (it != this->jobs.end()) ? it->second.levels : std::vector<Level>();
+}
+
+/*! Writes whatever is queued as soon as it is queued (one write per batch), and syncs the file when the
+interval has passed since the last sync, on flush() and at the end. With an interval of 0 every batch is
+synced, and the idle writer sleeps until something is queued.
+*/
+void Checkpoint::writeLoop()
+{
+    auto ready = [&] { return this->stopping || this->flushing || !this->queue.empty(); };
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        // a timed wait of 0 would return at once, and spin
+        if (this->period.count() > 0)
+            this->wake.wait_for(lock, this->period, ready);
+        else
+            this->wake.wait(lock, ready);
+
+        bool stop = this->stopping;
+        writeQueue(lock, stop || this->flushing);
+        if (stop && this->queue.empty())
+            break;
+    }
+}
+
+void Checkpoint::commit()
+{
+    // a threaded checkpoint writes on its own
+    if (this->mode == Threaded)
+        return;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    writeQueue(lock, false);
+}
+
+/*! Takes the queue, writes it with the mutex released and syncs the file if force or the interval has passed.
+Called with the mutex held, by one writer at a time: the writer thread, or the owner of an inline Checkpoint.
+*/
+void Checkpoint::writeQueue(std::unique_lock<std::mutex> &lock, bool force)
+{
+    std::vector<Record> batch;
+    batch.swap(this->queue);
+    unsigned long upto = this->queued;
+    bool sync = force || this->period.count() == 0 || std::chrono::steady_clock::now() - this->lastSync >= this->period;
+    lock.unlock();
+
+    std::string buffer;
+    for (const Record &record : batch) {
+        std::string payload;
+        put(payload, (std::uint8_t) record.type);
+        put(payload, record.level);
+        put(payload, record.a);
+        put(payload, record.b);
+        payload += record.job;
+
+        put(buffer, (std::uint32_t) payload.size());
+        buffer += payload;
+        put(buffer, crc32(payload.data(), payload.size()));
+    }
+
+    std::size_t done = 0;
+    while (done < buffer.size()) {
+        ssize_t n = write(this->fd, buffer.data() + done, buffer.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            if (!this->failed)
+                std::cerr << "ERROR: cannot write checkpoint " << this->path << ": " << std::strerror(errno) << std::endl;
+            this->failed = true;
+            break;
+        }
+        done += n;
+    }
+    this->dirty = this->dirty || !buffer.empty();
+
+    if (sync && this->dirty) {
+        fdatasync(this->fd);
+        this->dirty = false;
+    }
+
+    lock.lock();
+    if (sync) {
+        this->lastSync = std::chrono::steady_clock::now();
+        this->synced = upto;
+        if (this->synced >= this->queued)
+            this->flushing = false;
+        this->written.notify_all();
+    }
+}
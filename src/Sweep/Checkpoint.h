@@ -0,0 +1,103 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*! Checkpoint is an append-only log of the progress of a batch of solves, keyed by job id (any string that
+ * identifies the solve, e.g. its parameters). Three kinds of records are kept:
+ * - bracket: level n of the job is bracketed in [Emin, Emax] (in flight)
+ * - converged: level n of the job is converged to energy
+ * - finished: every level of the job is converged
+ *
+ * Records are queued by the solver and written by a writer thread, so that the solver never waits for
+ * the disk: the file is synced every `interval` seconds, and on flush(). An Inline checkpoint starts no thread:
+ * its owner writes the queue with commit() (synced if the interval has passed) and flush(), so that a process
+ * that forks never does it while another thread may hold a lock (of the checkpoint, of malloc or of a stream).
+ * Each record carries its length and a CRC-32, so a record torn by a crash is detected when the file is
+ * opened again: the file is cut back to the last complete record and the state it holds is resumed.
+ *
+ * File layout: magic "SCHCKPT1", then records of
+ * payload size (uint32), type (uint8), level (int32), a (double), b (double), job id, CRC-32 of the payload (uint32).
+ */
+class Checkpoint {
+public:
+    struct Level {
+        double energy = NAN;           // converged energy, NaN if not converged
+        double Emin = NAN, Emax = NAN; // last bracket, NaN if none
+    };
+
+    enum Writer { Threaded, Inline };
+
+    explicit Checkpoint(std::string path, double interval = 1., Writer writer = Threaded);
+    ~Checkpoint();
+
+    void bracket(const std::string& job, int level, double Emin, double Emax);
+    void converged(const std::string& job, int level, double energy);
+    void finished(const std::string& job);
+    //! Blocks until every record queued so far is written and synced
+    void flush();
+    //! Inline writer: writes the records queued so far, and syncs the file if the interval has passed (no-op if Threaded)
+    void commit();
+
+    bool isFinished(const std::string& job);
+    //! Levels of the job known so far, indexed by level
+    std::vector<Level> levels(const std::string& job);
+    //! Records read back when the file was opened, and bytes of torn records cut from its end
+    std::size_t getRecovered() const { return this->recovered; }
+    std::size_t getDiscarded() const { return this->discarded; }
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+private:
+    enum Type : std::uint8_t { Bracket = 1, Converged = 2, Finished = 3 };
+
+    struct Record {
+        Type type;
+        std::int32_t level;
+        double a, b;
+        std::string job;
+    };
+
+    struct Job {
+        bool finished = false;
+        std::vector<Level> levels;
+    };
+
+    std::string path;
+    double interval;
+    std::chrono::steady_clock::duration period;
+    Writer mode;
+    int fd = -1;
+    std::size_t recovered = 0, discarded = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake, written;
+    std::vector<Record> queue;
+    std::map<std::string, Job> jobs;
+    unsigned long queued = 0, synced = 0;
+    bool flushing = false, stopping = false;
+    std::thread writer;
+    // of the writer only
+    std::chrono::steady_clock::time_point lastSync;
+    bool dirty = false, failed = false;
+
+    void apply(const Record& record);
+    void append(Record record);
+    void recover();
+    void writeLoop();
+    void writeQueue(std::unique_lock<std::mutex> &lock, bool force);
+};
+
+//! CRC-32 (IEEE 802.3) of size bytes
+std::uint32_t crc32(const void *data, std::size_t size);
+
+#endif
@@ -0,0 +1,507 @@
+#include "ShardedSweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <Bracketing.h>
+#include <Schroedinger.h>
+
+#include "Checkpoint.h"
+
+namespace {
+    // state of a shard in the shared table; a claimed shard holds the pid of its worker
+    const int ShardPending = 0, ShardDone = -1, ShardFailed = -2;
+    // progress of a level of a point, published by the worker for the checkpoint
+    const int LevelNone = 0, LevelBracketed = 1, LevelConverged = 2;
+
+    static_assert(std::atomic<int>::is_always_lock_free && std::atomic<unsigned long>::is_always_lock_free,
+                  "the shared table needs address free atomics");
+
+    /*! Views of the mapping shared by the coordinator and the workers. The energies and brackets of a shard
+    fill whole pages of their own (energies, lower ends, upper ends of its points), written only by the worker
+    that solves it, so that its pages are first touched, and placed, by that worker.
+    The energy (or bracket) of a level is written before its progress is stored with release order, so the
+    coordinator reads it once it has seen the progress.
+    */
+    struct SharedTable {
+        void *memory = MAP_FAILED;
+        std::size_t size = 0;
+        std::atomic<unsigned long> *sweeps;
+        std::atomic<int> *state, *attempts, *status, *progress;
+
+        SharedTable(int nshards, int npoints, int levels, int shardSize) : levels(levels), shardSize(shardSize) {
+            std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE);
+            std::size_t values = (std::size_t) npoints * levels;
+            std::size_t counters = 2 * nshards + npoints + values;
+            std::size_t header = sizeof(std::atomic<unsigned long>) + counters * sizeof(std::atomic<int>);
+            header = (header + page - 1) / page * page;
+            this->block = (3 * (std::size_t) shardSize * levels * sizeof(double) + page - 1) / page * page;
+            this->size = header + nshards * this->block;
+
+            this->memory = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (this->memory == MAP_FAILED)
+                throw std::runtime_error("ShardedSweep: cannot map the shared result table.");
+
+            char *p = (char *) this->memory;
+            this->sweeps = new (p) std::atomic<unsigned long>(0);
+            p += sizeof(std::atomic<unsigned long>);
+            this->state = (std::atomic<int> *) p;
+            this->attempts = this->state + nshards;
+            this->status = this->attempts + nshards;
+            this->progress = this->status + npoints;
+            for (std::size_t c = 0; c < counters; c++)
+                new (this->state + c) std::atomic<int>(0);
+            this->values = (char *) this->memory + header;
+        }
+
+        //! Levels of a point
+        double *energies(int point) { return shard(point) + (point % shardSize) * levels; }
+        double *lower(int point)    { return energies(point) + shardSize * levels; }
+        double *upper(int point)    { return energies(point) + 2 * shardSize * levels; }
+
+        ~SharedTable() {
+            if (this->memory != MAP_FAILED)
+                munmap(this->memory, this->size);
+        }
+
+    private:
+        int levels, shardSize;
+        std::size_t block;   // bytes of a shard, whole pages
+        char *values;
+
+        double *shard(int point) { return (double *) (this->values + (point / shardSize) * this->block); }
+    };
+
+    // "0-3,8,10-11" to {0, 1, 2, 3, 8, 10, 11}
+    std::vector<int> parse_cpulist(const std::string &list) {
+        std::vector<int> cpus;
+        std::stringstream ranges(list);
+        std::string range;
+        while (std::getline(ranges, range, ',')) {
+            if (range.find_first_not_of(" \n") == std::string::npos)
+                continue;
+            std::string::size_type dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    /*! Pins the worker to the cpus of a node and makes it allocate its memory on the node it runs on (whatever
+    policy it inherited, e.g. from numactl --interleave), so that the pages it touches first are local to it.
+    Both are only optimizations: a failure leaves the worker where it is.
+    */
+    void pin(const std::vector<int> &cpus) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+            CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+        syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0);
+    }
+}
+
+ShardedSweep::ShardedSweep(std::string type, ContinuousBase base, int levels, const SolverConfig &config)
+    : base(base), config(SolverConfig(config).setMesh(base.getMesh()))
+{
+    if (levels < 1)
+        throw std::invalid_argument("ShardedSweep needs at least one level.");
+    this->type   = type;
+    this->levels = levels;
+
+    // an unknown type is reported here, not by every worker
+    Potential::Builder(this->base.getCoords()).setType(type).build();
+}
+
+ShardedSweep& ShardedSweep::addPoint(double k, double width, double height)
+{
+    this->points.push_back(Parameters{k, width, height});
+    return *this;
+}
+
+ShardedSweep& ShardedSweep::addGrid(const std::vector<double>& k, const std::vector<double>& width,
+                                    const std::vector<double>& height)
+{
+    for (double kk : k)
+        for (double w : width)
+            for (double h : height)
+                addPoint(kk, w, h);
+    return *this;
+}
+
+ShardedSweep& ShardedSweep::setWorkers(int workers)
+{
+    if (workers < 1)
+        throw std::invalid_argument("ShardedSweep needs at least one worker.");
+    this->workers = workers;
+    return *this;
+}
+
+ShardedSweep& ShardedSweep::setShardSize(int points)
+{
+    if (points < 1)
+        throw std::invalid_argument("A shard holds at least one point.");
+    this->shardSize = points;
+    return *this;
+}
+
+ShardedSweep& ShardedSweep::setMaxAttempts(int attempts)
+{
+    if (attempts < 1)
+        throw std::invalid_argument("A shard needs at least one attempt.");
+    this->maxAttempts = attempts;
+    return *this;
+}
+
+ShardedSweep& ShardedSweep::setWorkerHook(WorkerHook hook)
+{
+    this->hook = hook;
+    return *this;
+}
+
+ShardedSweep& ShardedSweep::setCheckpoint(std::string path, double interval)
+{
+    this->checkpointPath = path;
+    this->checkpointInterval = interval;
+    return *this;
+}
+
+std::string ShardedSweep::jobId(int point)
+{
+    // every digit of the parameters: a point resumes only the exact same solve
+    std::ostringstream id;
+    id << std::setprecision(17) << this->type << " nbox=" << this->base.getNbox() << " start=" << this->base.getStart()
+       << " mesh=" << this->base.getMesh() << " k=" << this->points[point].k
+       << " width=" << this->points[point].width << " height=" << this->points[point].height;
+    return id.str();
+}
+
+std::vector< std::vector<int> > ShardedSweep::numaNodes()
+{
+    std::vector< std::pair<int, std::vector<int> > > nodes;
+    std::error_code error;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, 4, "node") != 0 || name.size() == 4
+            || name.find_first_not_of("0123456789", 4) != std::string::npos)
+            continue;
+
+        std::ifstream in(entry.path() / "cpulist");
+        std::string list;
+        std::getline(in, list);
+
+        // only the cpus this process may run on; memory only nodes have none
+        std::vector<int> cpus;
+        for (int cpu : parse_cpulist(list))
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        if (!cpus.empty())
+            nodes.emplace_back(std::stoi(name.substr(4)), cpus);
+    }
+
+    std::sort(nodes.begin(), nodes.end());
+    std::vector< std::vector<int> > result;
+    for (auto &node : nodes)
+        result.push_back(node.second);
+    return result;
+}
+
+ShardedSweep::Result ShardedSweep::run()
+{
+    const int npoints = (int) this->points.size();
+    const int nshards = (npoints + shardSize - 1) / shardSize;
+    const int nbox = (int) this->base.getNbox();
+
+    Result result;
+    result.points = this->points;
+    result.sweeps = 0;
+    result.workers = result.crashes = result.requeued = result.resumed = 0;
+    if (npoints == 0) {
+        result.nodes = 0;
+        return result;
+    }
+
+    SharedTable table(nshards, npoints, levels, shardSize);
+    std::vector< std::vector<int> > nodes = numaNodes();
+    result.nodes = (int) nodes.size();
+
+    // what the checkpoint already holds is published in the table before the workers start; the values stay in
+    // the memory of the coordinator, which the workers inherit, and are copied in the table by the worker that
+    // claims their shard. The coordinator writes the checkpoint itself (Inline): no other thread may be alive,
+    // holding a lock, when it forks a worker
+    std::unique_ptr<Checkpoint> checkpoint;
+    std::vector<std::string> ids;
+    std::vector<int> logged;
+    std::vector<char> finished, resumed(npoints, 0);
+    std::vector<Checkpoint::Level> known;
+    if (!this->checkpointPath.empty()) {
+        checkpoint.reset(new Checkpoint(this->checkpointPath, this->checkpointInterval, Checkpoint::Inline));
+        logged.assign((std::size_t) npoints * levels, LevelNone);
+        finished.assign(npoints, 0);
+        known.resize((std::size_t) npoints * levels);
+        for (int p = 0; p < npoints; p++) {
+            ids.push_back(jobId(p));
+            std::vector<Checkpoint::Level> stored = checkpoint->levels(ids[p]);
+            int converged = 0;
+            for (int n = 0; n < levels && n < (int) stored.size(); n++) {
+                std::size_t i = (std::size_t) p * levels + n;
+                known[i] = stored[n];
+                if (!std::isnan(stored[n].energy)) {
+                    logged[i] = LevelConverged;
+                    converged++;
+                }
+                else if (!std::isnan(stored[n].Emin))
+                    logged[i] = LevelBracketed;
+                table.progress[i].store(logged[i]);
+            }
+            if (converged == levels && checkpoint->isFinished(ids[p])) {
+                table.status[p].store(Done);
+                finished[p] = resumed[p] = 1;
+                result.resumed++;
+            }
+        }
+        for (int s = 0; s < nshards; s++) {
+            bool done = true;
+            for (int p = s * shardSize; p < std::min(npoints, (s + 1) * shardSize); p++)
+                done = done && finished[p];
+            if (done)
+                table.state[s].store(ShardDone);
+        }
+    }
+
+    // logs the progress published since the last call, in one write
+    auto record = [&]() {
+        for (int p = 0; p < npoints; p++) {
+            int converged = 0;
+            for (int n = 0; n < levels; n++) {
+                std::size_t i = (std::size_t) p * levels + n;
+                int progress = table.progress[i].load(std::memory_order_acquire);
+                if (progress > logged[i]) {
+                    if (progress == LevelBracketed)
+                        checkpoint->bracket(ids[p], n, table.lower(p)[n], table.upper(p)[n]);
+                    else
+                        checkpoint->converged(ids[p], n, table.energies(p)[n]);
+                    logged[i] = progress;
+                }
+                converged += (logged[i] == LevelConverged);
+            }
+            if (!finished[p] && converged == levels && table.status[p].load() == Done) {
+                checkpoint->finished(ids[p]);
+                finished[p] = 1;
+            }
+        }
+        checkpoint->commit();
+    };
+
+    auto work = [&]() {
+        const int me = (int) getpid();
+        std::vector<double> coords = this->base.getCoords();
+        Wavefunction wavefunction(this->base);
+
+        while (true) {
+            int shard = -1;
+            for (int s = 0; s < nshards && shard < 0; s++) {
+                int expected = ShardPending;
+                if (table.state[s].load(std::memory_order_relaxed) == ShardPending
+                    && table.state[s].compare_exchange_strong(expected, me))
+                    shard = s;
+            }
+            if (shard < 0)
+                return;
+
+            int first = shard * shardSize, last = std::min(npoints, first + shardSize);
+            // the levels resumed from the checkpoint (the same values again, if an earlier attempt did it)
+            for (int p = first; p < last && !known.empty(); p++) {
+                for (int n = 0; n < levels; n++) {
+                    const Checkpoint::Level &level = known[(std::size_t) p * levels + n];
+                    if (!std::isnan(level.energy))
+                        table.energies(p)[n] = level.energy;
+                    if (!std::isnan(level.Emin)) {
+                        table.lower(p)[n] = level.Emin;
+                        table.upper(p)[n] = level.Emax;
+                    }
+                }
+            }
+            int attempt = ++table.attempts[shard];
+            if (attempt > maxAttempts) {
+                for (int p = first; p < last; p++)
+                    if (table.status[p].load() != Done)
+                        table.status[p].store(Failed);
+                table.state[shard].store(ShardFailed);
+                continue;
+            }
+
+            // consecutive points of a sweep are close: every level starts from the previous point
+            std::vector<double> previous(levels, NAN);
+            for (int p = first; p < last; p++) {
+                std::size_t base = (std::size_t) p * levels;
+                double *energies = table.energies(p);
+                // resumed from the checkpoint, or solved by a worker that crashed later in the shard
+                if (table.status[p].load() == Done) {
+                    std::copy(energies, energies + levels, previous.begin());
+                    continue;
+                }
+                if (this->hook)
+                    this->hook(p, attempt);
+
+                unsigned long sweeps = numerov_sweeps();
+                try {
+                    Potential V = Potential::Builder(coords)
+                            .setType(this->type)
+                            .setK(this->points[p].k)
+                            .setWidth(this->points[p].width)
+                            .setHeight(this->points[p].height)
+                            .build();
+                    for (int n = 0; n < levels; n++) {
+                        std::atomic<int> &progress = table.progress[base + n];
+                        int known = progress.load(std::memory_order_acquire);
+                        if (known == LevelConverged) {
+                            previous[n] = energies[n];
+                            continue;
+                        }
+                        wavefunction.reset();
+                        if (known != LevelBracketed) {
+                            EnergyBracket b = bracket_Numerov(n, nbox, V, wavefunction.data(), previous[n], NAN,
+                                                                  this->config);
+                            table.lower(p)[n] = b.Emin;
+                            table.upper(p)[n] = b.Emax;
+                            progress.store(LevelBracketed, std::memory_order_release);
+                        }
+                        energies[n] = previous[n] = refine_Numer(table.lower(p)[n], table.upper(p)[n], nbox, V,
+                                                                 wavefunction.data(), nullptr, this->config);
+                        progress.store(LevelConverged, std::memory_order_release);
+                    }
+                    table.status[p].store(Done);
+                }
+                catch (const std::exception &e) {
+                    std::cerr << "ERROR: sweep point " << p << ": " << e.what() << std::endl;
+                    std::fill(previous.begin(), previous.end(), NAN);
+                    table.status[p].store(Error);
+                }
+                table.sweeps->fetch_add(numerov_sweeps() - sweeps);
+            }
+            table.state[shard].store(ShardDone);
+        }
+    };
+
+    std::vector<pid_t> slots(std::min(this->workers, nshards), 0);
+    auto spawn = [&](int slot) {
+        // buffered output would be written again by the child
+        std::cout.flush();
+        std::cerr.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (!nodes.empty())
+                pin(nodes[slot % nodes.size()]);
+            int code = 0;
+            try {
+                work();
+            }
+            catch (...) {
+                code = 1;
+            }
+            std::cout.flush();
+            _exit(code);
+        }
+        if (pid < 0) {
+            for (pid_t &other : slots) {
+                if (other > 0) {
+                    kill(other, SIGKILL);
+                    waitpid(other, nullptr, 0);
+                }
+            }
+            throw std::runtime_error("ShardedSweep: cannot fork a worker.");
+        }
+        slots[slot] = pid;
+        result.workers++;
+    };
+
+    for (int slot = 0; slot < (int) slots.size(); slot++)
+        spawn(slot);
+
+    auto period = std::chrono::duration<double>(this->checkpointInterval);
+    auto lastRecord = std::chrono::steady_clock::now();
+    while (true) {
+        if (checkpoint && std::chrono::steady_clock::now() - lastRecord >= period) {
+            record();
+            lastRecord = std::chrono::steady_clock::now();
+        }
+
+        for (pid_t &pid : slots) {
+            int status = 0;
+            if (pid <= 0 || waitpid(pid, &status, WNOHANG) == 0)
+                continue;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                result.crashes++;
+            // whatever the worker still held goes back in the queue
+            for (int s = 0; s < nshards; s++) {
+                int expected = (int) pid;
+                if (table.state[s].compare_exchange_strong(expected, ShardPending))
+                    result.requeued++;
+            }
+            pid = 0;
+        }
+
+        int pending = 0, running = 0, live = 0;
+        for (int s = 0; s < nshards; s++) {
+            int state = table.state[s].load();
+            pending += (state == ShardPending);
+            running += (state > 0);
+        }
+        for (pid_t pid : slots)
+            live += (pid > 0);
+
+        if (pending == 0 && running == 0 && live == 0)
+            break;
+        // replacements for the workers gone, on the same nodes
+        for (int slot = 0; slot < (int) slots.size() && pending > 0; slot++) {
+            if (slots[slot] == 0) {
+                spawn(slot);
+                pending--;
+            }
+        }
+        usleep(1000);
+    }
+
+    if (checkpoint) {
+        record();
+        checkpoint->flush();
+    }
+
+    result.sweeps = table.sweeps->load();
+    result.status.resize(npoints);
+    result.energies.assign(npoints, std::vector<double>(levels, NAN));
+    for (int p = 0; p < npoints; p++) {
+        result.status[p] = (PointStatus) table.status[p].load();
+        // a point finished in the checkpoint is in the table only if a worker claimed its shard
+        if (result.status[p] == Done && resumed[p]) {
+            for (int n = 0; n < levels; n++)
+                result.energies[p][n] = known[(std::size_t) p * levels + n].energy;
+        }
+        else if (result.status[p] == Done)
+            std::copy(table.energies(p), table.energies(p) + levels, result.energies[p].begin());
+    }
+    return result;
+}
@@ -0,0 +1,94 @@
+#ifndef SHARDEDSWEEP_H
+#define SHARDEDSWEEP_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ContinuousBase.h>
+#include <Potential.h>
+#include <SolverConfig.h>
+
+/*! ShardedSweep solves the lowest levels of a potential over a sweep of its Potential::Builder parameters
+ * (k, width, height) with several worker processes instead of threads, so that every worker keeps its
+ * memory on its own NUMA node and a crash takes down one worker only.
+ *
+ * The points are cut in shards of consecutive points. The coordinator forks the workers, each pinned to
+ * the cpus of one NUMA node (round robin over /sys/devices/system/node). The workers claim shards from a
+ * table in shared memory (a compare and swap of the shard state to their pid) and write the energies of
+ * their points straight into the shared result table. Every shard has whole pages of the table to itself,
+ * first touched by the worker that claims it, which allocates on its own node (MPOL_LOCAL), so the pages
+ * are local to it. Inside a shard every point starts from the energies of the previous one.
+ *
+ * The coordinator reaps the workers: the shards held by a worker that crashed are put back in the queue
+ * and a replacement is forked on the same node. A shard claimed maxAttempts times without completing is
+ * given up, and its points are marked Failed.
+ *
+ * With a checkpoint file the coordinator logs the bracket and the energy of every level as the workers
+ * publish them, and every point finished (see Checkpoint). It writes the log itself, between two polls of the
+ * workers, so that no other thread is running when it forks one. A sweep started again on the same file after a
+ * crash or a kill skips the points already finished and refines the brackets already found.
+ *
+ * ShardedSweep sweep("harmonic oscillator", ContinuousBase(dx, 1000), 4);
+ * sweep.addGrid({0.1, 0.2, 0.5}, {5.}, {10.});
+ * ShardedSweep::Result r = sweep.setWorkers(8).run();
+ */
+class ShardedSweep {
+public:
+    enum PointStatus { Pending = 0, Done = 1, Error = 2, Failed = 3 };
+
+    struct Parameters {
+        double k, width, height;
+    };
+
+    struct Result {
+        std::vector<Parameters> points;
+        std::vector< std::vector<double> > energies;  // energies[point][level], NAN unless Done
+        std::vector<PointStatus> status;              // Error: the solve threw, Failed: its shard crashed every attempt
+        unsigned long sweeps;   // Numerov sweeps of all workers, including those that crashed
+        int workers;            // workers forked, replacements included
+        int crashes;            // workers that died with a shard in hand or with a non zero status
+        int requeued;           // shards put back in the queue after a crash
+        int nodes;              // NUMA nodes the workers were pinned to (0: no pinning)
+        int resumed;            // points finished in the checkpoint, not solved again
+    };
+
+    //! Called in the worker before point is solved, attempt counts from 1 (e.g. for fault injection in tests)
+    typedef std::function<void(int point, int attempt)> WorkerHook;
+
+    //! The levels are solved with config on the mesh of base
+    ShardedSweep(std::string type, ContinuousBase base, int levels, const SolverConfig &config = SolverConfig::current());
+
+    ShardedSweep& addPoint(double k, double width, double height);
+    //! Adds every combination of the given values
+    ShardedSweep& addGrid(const std::vector<double>& k, const std::vector<double>& width, const std::vector<double>& height);
+    ShardedSweep& setWorkers(int workers);
+    ShardedSweep& setShardSize(int points);
+    ShardedSweep& setMaxAttempts(int attempts);
+    ShardedSweep& setWorkerHook(WorkerHook hook);
+    //! Logs the progress to path, every interval seconds, and resumes what path already holds
+    ShardedSweep& setCheckpoint(std::string path, double interval = 1.);
+
+    Result run();
+
+    //! Cpus of every online NUMA node; empty if the topology is unknown
+    static std::vector< std::vector<int> > numaNodes();
+
+private:
+    std::string type;
+    ContinuousBase base;
+    SolverConfig config;
+    int levels;
+    std::vector<Parameters> points;
+    int workers     = 1;
+    int shardSize   = 16;
+    int maxAttempts = 3;
+    WorkerHook hook;
+    std::string checkpointPath;
+    double checkpointInterval = 1.;
+
+    //! Checkpoint job id of a point: the potential, the grid and the parameters, every digit
+    std::string jobId(int point);
+};
+
+#endif
@@ -1,11 +1,122 @@
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 #include <BasisManager.h>
 #include <Potential.h>
 #include <Schroedinger.h>
+#include <Server.h>
+#include <ShardedSweep.h>
+
+// "a" or "first:last:count", count evenly spaced values
+static std::vector<double> parse_range(const std::string& range) {
+	std::vector<double> values;
+	std::string::size_type colon = range.find(':');
+	if (colon == std::string::npos) {
+		values.push_back(std::stod(range));
+		return values;
+	}
+	std::string::size_type second = range.find(':', colon + 1);
+	if (second == std::string::npos)
+		throw std::invalid_argument("Range must be first:last:count (" + range + ")");
+	double first = std::stod(range.substr(0, colon));
+	double last = std::stod(range.substr(colon + 1, second - colon - 1));
+	int count = std::stoi(range.substr(second + 1));
+	if (count < 1)
+		throw std::invalid_argument("Range needs at least one value (" + range + ")");
+	for (int i = 0; i < count; i++)
+		values.push_back((count == 1) ? first : first + (last - first) * i / (count - 1));
+	return values;
+}
 
 int main(int argc, char **argv) {
 
+	std::string mode = (argc > 1) ? argv[1] : "";
+
+	// Long-running mode: line-delimited JSON requests on stdin or on a Unix domain socket
+	if (mode == "--server" || mode == "--socket") {
+		std::string socketPath, cacheDirectory;
+		for (int i = 1; i < argc; i++) {
+			std::string arg = argv[i];
+			if (arg == "--socket" && i + 1 < argc)
+				socketPath = argv[++i];
+			else if (arg == "--cache-dir" && i + 1 < argc)
+				cacheDirectory = argv[++i];
+			else if (arg != "--server") {
+				std::cerr << "usage: " << argv[0] << " (--server | --socket <path>) [--cache-dir <dir>]" << std::endl;
+				return 1;
+			}
+		}
+
+		try {
+			Server server(cacheDirectory);
+			if (!socketPath.empty()) {
+				server.serveSocket(socketPath);
+			}
+			else {
+				// Solver diagnostics go to stderr, stdout carries only the answers
+				std::ostream answers(std::cout.rdbuf());
+				std::cout.rdbuf(std::cerr.rdbuf());
+				server.serve(std::cin, answers);
+			}
+		}
+		catch (const std::exception& e) {
+			std::cerr << "ERROR: " << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	// Parameter sweep solved by worker processes pinned to the NUMA nodes, one line per point on stdout
+	if (mode == "--sweep") {
+		if (argc < 3) {
+			std::cerr << "usage: " << argv[0] << " --sweep <potential> [--k a:b:n] [--width a:b:n] [--height a:b:n]"
+					  << " [--levels L] [--nbox N] [--workers W] [--shard S] [--checkpoint FILE]" << std::endl;
+			return 1;
+		}
+		try {
+			std::vector<double> k = {0.5}, width = {5.0}, height = {10.0};
+			int levels = 1, nbox = 1000, workers = (int) std::max(1u, std::thread::hardware_concurrency()), shard = 16;
+			std::string checkpoint;
+			for (int i = 3; i + 1 < argc; i += 2) {
+				std::string arg = argv[i], value = argv[i + 1];
+				if (arg == "--k") k = parse_range(value);
+				else if (arg == "--width") width = parse_range(value);
+				else if (arg == "--height") height = parse_range(value);
+				else if (arg == "--levels") levels = std::stoi(value);
+				else if (arg == "--nbox") nbox = std::stoi(value);
+				else if (arg == "--workers") workers = std::stoi(value);
+				else if (arg == "--shard") shard = std::stoi(value);
+				else if (arg == "--checkpoint") checkpoint = value;
+				else throw std::invalid_argument("Unknown option " + arg);
+			}
+
+			// Solver diagnostics go to stderr, stdout carries only the table
+			std::ostream table(std::cout.rdbuf());
+			std::cout.rdbuf(std::cerr.rdbuf());
+
+			ShardedSweep sweep(argv[2], ContinuousBase(dx, (unsigned int) nbox), levels);
+			if (!checkpoint.empty())
+				sweep.setCheckpoint(checkpoint);
+			ShardedSweep::Result r = sweep.addGrid(k, width, height).setWorkers(workers).setShardSize(shard).run();
+
+			table.precision(12);
+			table << "# k  width  height  E_0 .. E_" << levels - 1 << "  (" << r.workers << " workers on "
+				  << r.nodes << " NUMA nodes, " << r.crashes << " crashes, " << r.sweeps << " sweeps, " << r.resumed << " points resumed)" << std::endl;
+			for (std::vector<double>::size_type p = 0; p < r.points.size(); p++) {
+				table << r.points[p].k << "  " << r.points[p].width << "  " << r.points[p].height;
+				for (double E : r.energies[p])
+					table << "  " << E;
+				table << std::endl;
+			}
+		}
+		catch (const std::exception& e) {
+			std::cerr << "ERROR: " << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
 	BasisManager::Builder b = BasisManager::Builder();
 	BasisManager::getInstance()->addBase( b.addDiscrete(0, 5, 1)
 					   .addContinuous(-5.0, 5.0, 0.01)
@@ -13,4 +124,4 @@ int main(int argc, char **argv) {
 	);
 	std::vector<Base> basis = BasisManager::getInstance()->getBasisList();
 	return 0;
-}
\ No newline at end of file
+}
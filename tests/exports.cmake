@@ -0,0 +1,28 @@
+# Fails unless LIBRARY exports the functions of the C interface (sch_*) and nothing else.
+# cmake -DNM=nm -DLIBRARY=libschroedinger.so -P exports.cmake
+execute_process(COMMAND ${NM} -D --defined-only ${LIBRARY}
+                OUTPUT_VARIABLE symbols
+                RESULT_VARIABLE status)
+if (NOT status EQUAL 0)
+    message(FATAL_ERROR "Cannot list the dynamic symbols of ${LIBRARY}.")
+endif()
+
+string(REPLACE "\n" ";" lines "${symbols}")
+set(exported 0)
+set(foreign "")
+foreach(line ${lines})
+    string(REGEX REPLACE "^.* " "" name "${line}")
+    if (name MATCHES "^sch_")
+        math(EXPR exported "${exported} + 1")
+    elseif (NOT name STREQUAL "")
+        list(APPEND foreign ${name})
+    endif()
+endforeach()
+
+if (foreign)
+    message(FATAL_ERROR "${LIBRARY} exports symbols outside the C interface: ${foreign}")
+endif()
+if (exported EQUAL 0)
+    message(FATAL_ERROR "${LIBRARY} exports no sch_ function.")
+endif()
+message(STATUS "${exported} sch_ functions exported, nothing else.")
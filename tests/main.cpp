@@ -1,9 +1,37 @@
 #define __STDCPP_WANT_MATH_SPEC_FUNCS__ 1
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <type_traits>
+
 #include <gtest/gtest.h>
 
 #include <Schroedinger.h>
+#include <Analytic.h>
+#include <BandStructure.h>
 #include <BasisManager.h>
+#include <SchroedingerC.h>
+#include <Checkpoint.h>
+#include <CoupledChannels.h>
+#include <Bracketing.h>
+#include <EigenCache.h>
+#include <ImaginaryTime.h>
+#include <IncrementalNumerov.h>
+#include <MappedBlock.h>
+#include <Observables.h>
+#include <Parity.h>
+#include <Scattering.h>
+#include <SelfConsistent.h>
+#include <Server.h>
+#include <ShardedSweep.h>
+#include <SolverConfig.h>
+#include <Spectrum.h>
+#include <Wavefunction.h>
 #include "test.h"
 
 double H3(double x) { return 8 * std::pow(x, 3) - 12 * x; }
@@ -12,7 +40,7 @@ double H4(double x) { return 16 * std::pow(x, 4) - 48 * x * x + 12; }
 
 void testWf(unsigned int nbox, std::string potType, double k, double width, double height,
             std::vector<double> x, std::vector<double> *pot,
-            double *numerov_Wf, double *analytic_Wf) {
+            Wavefunction &numerov_Wf, Wavefunction &analytic_Wf) {
 
     Potential::Builder b(x);
     Potential V = b.setType(potType)
@@ -26,15 +54,15 @@ void testWf(unsigned int nbox, std::string potType, double k, double width, doub
     numerov_Wf[0] = 0.0;
     numerov_Wf[1] = 0.01; //later on it gets renormalized, so is just a conventional number
 
-    double E_numerov = solve_Numerov(0., 2., 0.01, nbox, V, numerov_Wf);
+    double E_numerov = solve_Numerov(0., 2., 0.01, V, numerov_Wf);
     double E_analytic;
 
     if (potType == "box") {
-        E_analytic = box_wf(1, nbox, analytic_Wf);
+        E_analytic = box_wf(1, nbox, analytic_Wf.data());
     } else if (potType == "harmonic oscillator") {
-        E_analytic = harmonic_wf(0, nbox, sqrt(2. * k), analytic_Wf);
+        E_analytic = harmonic_wf(0, nbox, sqrt(2. * k), analytic_Wf.data());
     } else if (potType == "well") {
-        E_analytic = finite_well_wf(1, nbox, width, height, analytic_Wf);
+        E_analytic = finite_well_wf(1, nbox, width, height, analytic_Wf.data());
     } else {
         std::cerr << "ERROR! Wrong potential name in set" << std::endl;
         exit(8);
@@ -124,8 +152,8 @@ namespace {
 
         std::string s = "harmonic oscillator";
 
-        double *numerov_Wf = new double[nbox];
-        double *analytic_Wf = new double[nbox];
+        Wavefunction numerov_Wf(x);
+        Wavefunction analytic_Wf(x);
         std::vector<double> pot(nbox);
 
         testWf(nbox, s, 0.500, 0., 0., x.getCoords(), &pot, numerov_Wf, analytic_Wf);
@@ -147,8 +175,8 @@ namespace {
 
         std::string s = "harmonic oscillator";
 
-        double *numerov_Wf = new double[nbox];
-        double *analytic_Wf = new double[nbox];
+        Wavefunction numerov_Wf(x);
+        Wavefunction analytic_Wf(x);
         std::vector<double> pot(nbox);
 
         testWf(nbox, s, 1.0, 0.0, 0.0, x.getCoords(), &pot, numerov_Wf, analytic_Wf);
@@ -171,8 +199,8 @@ namespace {
 
         std::string s = "box";
 
-        double *numerov_Wf = new double[nbox];
-        double *analytic_Wf = new double[nbox];
+        Wavefunction numerov_Wf(x);
+        Wavefunction analytic_Wf(x);
         std::vector<double> pot(nbox);
 
         testWf(nbox, s, 0.0, 0.0, 0.0, x.getCoords(), &pot, numerov_Wf, analytic_Wf);
@@ -194,8 +222,8 @@ namespace {
 
         std::string s = "box";
 
-        double *numerov_Wf = new double[nbox];
-        double *analytic_Wf = new double[nbox];
+        Wavefunction numerov_Wf(x);
+        Wavefunction analytic_Wf(x);
         std::vector<double> pot(nbox);
 
         testWf(nbox, s, 0.0, 0.0, 0.0, x.getCoords(), &pot, numerov_Wf, analytic_Wf);
@@ -219,8 +247,8 @@ namespace {
         std::string s = "well";
 
         double width = 10., height = 3.;
-        double *numerov_Wf = new double[nbox];
-        double *analytic_Wf = new double[nbox];
+        Wavefunction numerov_Wf(x);
+        Wavefunction analytic_Wf(x);
         std::vector<double> pot(nbox);
 
         testWf(nbox, s, 0., width, height, x.getCoords(), &pot, numerov_Wf, analytic_Wf);
@@ -243,8 +271,8 @@ namespace {
         std::string s = "well";
 
         double width = 7.0, height = 5.0;
-        double *numerov_Wf = new double[nbox];
-        double *analytic_Wf = new double[nbox];
+        Wavefunction numerov_Wf(x);
+        Wavefunction analytic_Wf(x);
         std::vector<double> pot(nbox);
 
         testWf(nbox, s, 0.0, width, height, x.getCoords(), &pot, numerov_Wf, analytic_Wf);
@@ -254,6 +282,1586 @@ namespace {
                 std::cout << i << " " << numerov_Wf[i] << " " << analytic_Wf[i] << " "
                           << pot[i] << " " << analytic_Wf[i] - numerov_Wf[i] << std::endl;
         }
+    }
+
+    TEST(Server, SolvesAndCachesRequests) {
+        Server server;
+
+        std::string first = server.handle("{\"id\": 1, \"potential\": \"harmonic oscillator\", \"k\": 0.5}");
+        std::string second = server.handle("{\"id\": 2, \"potential\": \"harmonic oscillator\", \"k\": 0.5}");
+        JsonObject a = JsonObject::parse(first);
+        JsonObject b = JsonObject::parse(second);
+
+        ASSERT_EQ(a.getString("status", ""), "ok");
+        ASSERT_EQ(a.getNumber("id", 0), 1);
+        ASSERT_NEAR(a.getNumber("energy", 0), 0.5, 1e-3);
+        ASSERT_EQ(a.getNumber("energy", 0), b.getNumber("energy", 1));
+
+        JsonObject stats = JsonObject::parse(server.handle("{\"cmd\": \"stats\"}"));
+        ASSERT_EQ(stats.getNumber("potentials", 0), 1);
+        ASSERT_EQ(stats.getNumber("potential_hits", 0), 1);
+    }
+
+    TEST(Server, CachesAreBoundedByCapacity) {
+        // a sweep over three potentials on three grids keeps the two most recent of each
+        Server server("", 2);
+        for (int n = 0; n < 3; n++) {
+            std::string request = "{\"potential\": \"harmonic oscillator\", \"mesh\": 0.05, \"nbox\": "
+                                + std::to_string(200 + 2 * n) + ", \"k\": " + std::to_string(0.5 + n) + "}";
+            ASSERT_EQ(JsonObject::parse(server.handle(request)).getString("status", ""), "ok");
+        }
+
+        JsonObject stats = JsonObject::parse(server.handle("{\"cmd\": \"stats\"}"));
+        ASSERT_EQ(stats.getNumber("bases", 0), 2);
+        ASSERT_EQ(stats.getNumber("base_evictions", 0), 1);
+        ASSERT_EQ(stats.getNumber("potentials", 0), 2);
+        ASSERT_EQ(stats.getNumber("potential_evictions", 0), 1);
+
+        // the first one was evicted: built again, evicting the least recently used
+        server.handle("{\"potential\": \"harmonic oscillator\", \"mesh\": 0.05, \"nbox\": 200, \"k\": 0.5}");
+        stats = JsonObject::parse(server.handle("{\"cmd\": \"stats\"}"));
+        ASSERT_EQ(stats.getNumber("potentials", 0), 2);
+        ASSERT_EQ(stats.getNumber("potential_hits", 1), 0);
+        ASSERT_EQ(stats.getNumber("potential_evictions", 0), 2);
+    }
+
+    TEST(Server, MalformedRequestsAreAnswered) {
+        Server server;
+
+        JsonObject broken = JsonObject::parse(server.handle("{\"id\": 3, \"nbox\": "));
+        ASSERT_EQ(broken.getString("status", ""), "error");
+
+        JsonObject unknown = JsonObject::parse(server.handle("{\"id\": 4, \"potential\": \"unknownType\"}"));
+        ASSERT_EQ(unknown.getString("status", ""), "error");
+        ASSERT_EQ(unknown.getNumber("id", 0), 4);
+    }
+
+    TEST(Server, RejectsNumbersOutsideJsonAndTheirRange) {
+        Server server;
+
+        for (std::string number : {"inf", "nan", "-inf", "0x10", "1e400", ".5", "01", "1.", "+1"}) {
+            JsonObject answer = JsonObject::parse(server.handle("{\"id\": 7, \"emin\": " + number + "}"));
+            ASSERT_EQ(answer.getString("status", ""), "error") << number;
+            ASSERT_NE(answer.getString("message", "").find("Malformed JSON"), std::string::npos) << number;
+        }
+        ASSERT_EQ(JsonObject::parse("{\"a\": -0.5e-3, \"b\": 0, \"c\": 12E+2}").getNumber("c", 0), 1200);
+
+        // valid JSON, but out of the range of the casts
+        for (std::string request : {"{\"nbox\": 1e300}", "{\"nbox\": 1e12}", "{\"max_sweeps\": 1e30}",
+                                    "{\"max_sweeps\": -1}", "{\"timeout\": 1e300}",
+                                    "{\"engine\": \"dvr\", \"level\": 1e12}", "{\"engine\": \"dvr\", \"level\": 1000}"}) {
+            JsonObject answer = JsonObject::parse(server.handle(request));
+            ASSERT_EQ(answer.getString("status", ""), "error") << request;
+            ASSERT_EQ(answer.getString("message", "").find("Malformed"), std::string::npos) << request;
+        }
+    }
+
+    TEST(EigenCache, HitReturnsStoredSolution) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        EigenCache cache(4);
+
+        std::vector<double> first(nbox + 1), second(nbox + 1);
+        first[1] = second[1] = 0.01;
+        double E1 = cached_solve_Numerov(cache, 0., 2., 0.01, base, V, first.data());
+        double E2 = cached_solve_Numerov(cache, 0., 2., 0.01, base, V, second.data());
+
+        ASSERT_EQ(E1, E2);
+        ASSERT_EQ(first, second);
+        ASSERT_EQ(cache.getHits(), 1);
+        ASSERT_EQ(cache.getMisses(), 1);
+    }
+
+    TEST(EigenCache, EvictsLeastRecentlyUsed) {
+        EigenCache cache(2);
+        double energy;
+        std::vector<double> wf;
+
+        cache.store("a", 1., {1.});
+        cache.store("b", 2., {2.});
+        ASSERT_TRUE(cache.lookup("a", energy, wf));
+        cache.store("c", 3., {3.});
+
+        ASSERT_EQ(cache.size(), 2);
+        ASSERT_TRUE(cache.lookup("a", energy, wf));
+        ASSERT_FALSE(cache.lookup("b", energy, wf));
+        ASSERT_TRUE(cache.lookup("c", energy, wf));
+        ASSERT_EQ(energy, 3.);
+    }
+
+    TEST(EigenCache, PersistsAcrossInstances) {
+        std::string directory = testing::TempDir() + "eigencache_test";
+        {
+            EigenCache cache(4, directory);
+            cache.store("problem", 0.5, {0., 1., 0.});
+        }
+
+        EigenCache cache(4, directory);
+        double energy = 0.;
+        std::vector<double> wf;
+        ASSERT_TRUE(cache.lookup("problem", energy, wf));
+        ASSERT_EQ(energy, 0.5);
+        ASSERT_EQ(wf, std::vector<double>({0., 1., 0.}));
+        ASSERT_FALSE(cache.lookup("other problem", energy, wf));
+    }
+
+    TEST(EigenCache, IgnoresFilesWithAnImpossibleCount) {
+        std::string directory = testing::TempDir() + "eigencache_count_test";
+        {
+            EigenCache cache(4, directory);
+            cache.store("problem", 0.5, {0., 1., 0.});
+        }
+
+        // a count of 2^61 values in a file of three: lookup must miss, not allocate
+        char name[40];
+        std::snprintf(name, sizeof(name), "/v%u-%016llx.eig", EigenCache::version,
+                      (unsigned long long) EigenCache::hash("problem"));
+        {
+            std::fstream file(directory + name, std::ios::binary | std::ios::in | std::ios::out);
+            std::uint64_t n = 1ULL << 61;
+            file.seekp(8 + 4 + 7 + 8);
+            file.write((const char*) &n, sizeof(n));
+        }
+
+        EigenCache cache(4, directory);
+        double energy = 0.;
+        std::vector<double> wf;
+        ASSERT_FALSE(cache.lookup("problem", energy, wf));
+        ASSERT_EQ(cache.getMisses(), 1);
+    }
+
+    TEST(EigenCache, CollidingCustomPotentialsAreToldApart) {
+        // every key in one bucket: only the full key, with all the values of the potential, tells them apart
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential narrow = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        Potential wide = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        std::vector<double> values = narrow.getValues();
+        narrow.setValues(values);
+        values[nbox / 2] += 1e-3;
+        wide.setValues(values);
+        EigenCache cache(4, "", [](const std::string&) -> std::uint64_t { return 42; });
+
+        std::vector<double> first(nbox + 1), second(nbox + 1);
+        first[1] = second[1] = 0.01;
+        ASSERT_NE(EigenCache::describe(base, narrow, 0., 2., 0.01, first.data()),
+                  EigenCache::describe(base, wide, 0., 2., 0.01, second.data()));
+        double E1 = cached_solve_Numerov(cache, 0., 2., 0.01, base, narrow, first.data());
+        double E2 = cached_solve_Numerov(cache, 0., 2., 0.01, base, wide, second.data());
+
+        std::vector<double> direct(nbox + 1);
+        direct[1] = 0.01;
+        ASSERT_NE(E1, E2);
+        ASSERT_EQ(E2, solve_Numerov(0., 2., 0.01, nbox, wide, direct.data(), SolverConfig(base)));
+        ASSERT_EQ(second, direct);
+        ASSERT_EQ(cache.getHits(), 0);
+        ASSERT_EQ(cache.getMisses(), 2);
+    }
+
+    TEST(EigenCache, HitsAreConfirmedAgainstThePotentialValues) {
+        // same key, other values: as after a collision of the digest of a custom potential
+        std::string directory = testing::TempDir() + "eigencache_values_test";
+        std::vector<double> stored = {0., 1., 4.}, other = {0., 1., 4.000000000000001};
+        {
+            EigenCache cache(4, directory);
+            cache.store("problem", 0.5, {0., 1., 0.}, stored);
+
+            double energy = 0.;
+            std::vector<double> wf;
+            ASSERT_FALSE(cache.lookup("problem", energy, wf, other));
+            ASSERT_FALSE(cache.lookup("problem", energy, wf));
+            ASSERT_TRUE(cache.lookup("problem", energy, wf, stored));
+        }
+
+        EigenCache cache(4, directory);
+        double energy = 0.;
+        std::vector<double> wf;
+        ASSERT_FALSE(cache.lookup("problem", energy, wf, other));
+        ASSERT_TRUE(cache.lookup("problem", energy, wf, stored));
+        ASSERT_EQ(energy, 0.5);
+    }
+
+    TEST(MixedPrecision, FloatScanMatchesDoubleSolve) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+
+        std::vector<double> reference(nbox + 1), mixed(nbox + 1), extended(nbox + 1);
+        reference[1] = mixed[1] = extended[1] = 0.01;
+
+        double E_double = solve_Numerov(0., 2., 0.01, nbox, V, reference.data());
+        double E_mixed = solve_Numerov_mixed<float, double>(0., 2., 0.01, nbox, V, mixed.data());
+        double E_extended = solve_Numerov_mixed<float, long double>(0., 2., 0.01, nbox, V, extended.data());
+
+        ASSERT_NEAR(E_mixed, E_double, 1e-8);
+        ASSERT_NEAR(E_extended, E_double, 1e-8);
+        // near the right wall the reference holds the last bisection sweep, not the one at E_double
+        for (unsigned int i = 0; i <= 3 * nbox / 4; i++)
+            ASSERT_NEAR(mixed[i], reference[i], 1e-6);
+    }
+
+    TEST(MixedPrecision, FloatSweepIsRenormalized) {
+        // A stiff oscillator: in the forbidden regions the float sweep would overflow without rescaling
+        unsigned int nbox = 2000;
+        double k = 50.;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(k).build();
+
+        std::vector<float> potential(V.getValues().begin(), V.getValues().end());
+        std::vector<float> wf(nbox + 1);
+        wf[1] = 0.01f;
+        fsol_Numerov<float>(1.f, nbox, potential.data(), wf.data());
+        for (unsigned int i = 0; i <= nbox; i++)
+            ASSERT_TRUE(std::isfinite(wf[i]));
+
+        std::vector<double> mixed(nbox + 1);
+        mixed[1] = 0.01;
+        double E = solve_Numerov_mixed<float, double>(0., 10., 0.1, nbox, V, mixed.data());
+        ASSERT_NEAR(E, 0.5 * sqrt(2. * k), 1e-3);
+    }
+
+    TEST(Bracketing, NodesCountLevelsBelow) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("box").build();
+        std::vector<double> wf(nbox + 1);
+        wf[1] = 0.01;
+
+        // box of length L = nbox * dx: E_n = (n + 1)^2 pi^2 / (2 L^2)
+        double L = nbox * dx;
+        for (int n = 0; n < 4; n++) {
+            double E_n = (n + 1) * (n + 1) * pi * pi / 2. / L / L;
+            ASSERT_EQ(count_nodes_Numerov(E_n * 0.99, nbox, V.getValues().data(), wf.data()), n);
+            ASSERT_EQ(count_nodes_Numerov(E_n * 1.01, nbox, V.getValues().data(), wf.data()), n + 1);
+        }
+    }
+
+    TEST(Bracketing, SolvesLevelsWithoutEnergyWindow) {
+        unsigned int nbox = 1000;
+        double k = 0.5;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(k).build();
+        std::vector<double> wf(nbox + 1);
+
+        for (int n = 0; n < 6; n++) {
+            wf[0] = 0.;
+            wf[1] = 0.01;
+            EnergyBracket b = bracket_Numerov(n, nbox, V, wf.data());
+            ASSERT_LT(b.sweeps, 20);
+
+            double E = solve_Numerov_level(n, nbox, V, wf.data());
+            ASSERT_GT(E, b.Emin);
+            ASSERT_LT(E, b.Emax);
+            ASSERT_NEAR(E, sqrt(2. * k) * (n + 0.5), 1e-4); // the walls at |x| = 5 shift the upper levels
+        }
+
+        // the ground state agrees with the fixed step scan
+        std::vector<double> scanned(nbox + 1);
+        scanned[1] = wf[1] = 0.01;
+        ASSERT_NEAR(solve_Numerov_level(0, nbox, V, wf.data()),
+                    solve_Numerov(0., 2., 0.01, nbox, V, scanned.data()), 1e-8);
+    }
+
+    TEST(Observables, HarmonicOscillatorExpectations) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+
+        std::vector< std::vector<double> > wf(4, std::vector<double>(nbox + 1));
+        std::vector<const double *> states;
+        std::vector<double> energies;
+        for (int n = 0; n < 4; n++) {
+            wf[n][1] = 0.01;
+            energies.push_back(solve_Numerov_level(n, nbox, V, wf[n].data()));
+            states.push_back(wf[n].data());
+        }
+
+        Observables obs(base, V, Observables::Simpson);
+        std::vector<Observables::Expectation> e = obs.expectationValues(states);
+        for (int n = 0; n < 4; n++) {
+            ASSERT_NEAR(e[n].norm, 1., 1e-6);
+            ASSERT_NEAR(e[n].x, 0., 1e-6);
+            ASSERT_NEAR(e[n].x2, n + 0.5, 1e-3);
+            // virial theorem for the oscillator: <T> = <V> = E / 2
+            ASSERT_NEAR(e[n].V, energies[n] / 2., 1e-3);
+            ASSERT_NEAR(e[n].T, energies[n] / 2., 1e-3);
+        }
+
+        std::vector<double> identity = obs.matrixElements(states, std::vector<double>(nbox, 1.));
+        std::vector<double> position = obs.matrixElements(states, base.getCoords());
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                ASSERT_NEAR(identity[i * 4 + j], i == j ? 1. : 0., 1e-6);
+                // <n|x|n+1> = sqrt((n + 1) / 2) for omega = 1
+                double x_ij = (std::abs(i - j) == 1) ? sqrt((std::max(i, j)) / 2.) : 0.;
+                ASSERT_NEAR(std::fabs(position[i * 4 + j]), x_ij, 1e-4);
+            }
+        }
+    }
+
+    TEST(Observables, ReductionDoesNotDependOnThreads) {
+        unsigned int nbox = 100000;
+        ContinuousBase base(1e-4, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(3.).build();
+
+        std::vector< std::vector<double> > wf(3, std::vector<double>(nbox + 1));
+        std::vector<const double *> states;
+        for (int s = 0; s < 3; s++) {
+            for (unsigned int i = 1; i < nbox; i++)
+                wf[s][i] = sin((s + 1) * pi * i / nbox) * (1. + 1e-3 * i);
+            states.push_back(wf[s].data());
+        }
+
+        Observables serial(base, V, Observables::Trapezoid, 1);
+        Observables parallel(base, V, Observables::Trapezoid, 4);
+        std::vector<Observables::Expectation> a = serial.expectationValues(states);
+        std::vector<Observables::Expectation> b = parallel.expectationValues(states);
+        for (int s = 0; s < 3; s++) {
+            ASSERT_EQ(a[s].norm, b[s].norm);
+            ASSERT_EQ(a[s].x2, b[s].x2);
+            ASSERT_EQ(a[s].T, b[s].T);
+        }
+        ASSERT_EQ(serial.matrixElements(states, V.getValues()), parallel.matrixElements(states, V.getValues()));
+    }
+
+    TEST(SelfConsistent, NonInteractingIsTheBareSpectrum) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+
+        HartreeSolver::Result r = HartreeSolver(base, V, 3, 0.).run();
+        ASSERT_TRUE(r.converged);
+        for (int n = 0; n < 3; n++)
+            ASSERT_NEAR(r.energies[n], n + 0.5, 1e-5);
+        ASSERT_NEAR(trap_array(0, (int) nbox, (double) dx, r.density.data()), 3., 1e-6);
+    }
+
+    TEST(SelfConsistent, AcceleratedMixingConvergesFaster) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+
+        HartreeSolver::Result linear = HartreeSolver(base, V, 2, 2.)
+                .setMixing(HartreeSolver::Linear, 0.3).run();
+        HartreeSolver::Result anderson = HartreeSolver(base, V, 2, 2.)
+                .setMixing(HartreeSolver::Anderson, 0.3).run();
+        HartreeSolver::Result diis = HartreeSolver(base, V, 2, 2.)
+                .setMixing(HartreeSolver::DIIS, 0.3).run();
+
+        ASSERT_TRUE(linear.converged);
+        ASSERT_TRUE(anderson.converged);
+        ASSERT_TRUE(diis.converged);
+        ASSERT_LT(anderson.iterations, linear.iterations);
+        ASSERT_LT(diis.iterations, linear.iterations);
+        for (int n = 0; n < 2; n++) {
+            ASSERT_GT(anderson.energies[n], n + 0.5); // repulsion lifts the levels
+            ASSERT_NEAR(anderson.energies[n], linear.energies[n], 1e-6);
+            ASSERT_NEAR(diis.energies[n], linear.energies[n], 1e-6);
+        }
+
+        HartreeSolver::Result coulomb = HartreeSolver(base, V, 2, 0.5)
+                .setInteraction(HartreeSolver::SoftCoulomb, 1.).run();
+        ASSERT_TRUE(coulomb.converged);
+    }
+
+    TEST(BandStructure, EmptyLatticeIsTheFreeParabola) {
+        // V = 0 on a cell of length a = 2: E(k) = (k + 2 pi m / a)^2 / 2, folded into [0, pi / a]
+        ContinuousBase cell(0., 2., 200u);
+        cell.setBoundary(ContinuousBase::Periodic);
+        Potential V = Potential::Builder(cell.getCoords()).setType("box").build();
+
+        BandStructure bands(cell, V, 3, 4);
+        BandStructure::Result r = bands.compute(21);
+        double G = 2. * pi / bands.getPeriod();
+        for (int j = 0; j < 21; j++) {
+            double k = r.k[j];
+            ASSERT_NEAR(r.energies[j][0], k * k / 2., 1e-4);
+            ASSERT_NEAR(r.energies[j][1], (G - k) * (G - k) / 2., 1e-4);
+            ASSERT_NEAR(r.energies[j][2], (G + k) * (G + k) / 2., 1e-4);
+        }
+
+        // the blocks of the threads start cold, the result does not depend on them
+        BandStructure::Result serial = BandStructure(cell, V, 3, 1).compute(21);
+        for (int j = 0; j < 21; j++)
+            for (int n = 0; n < 3; n++)
+                ASSERT_NEAR(serial.energies[j][n], r.energies[j][n], 1e-8);
+    }
+
+    TEST(BandStructure, KronigPenneyBands) {
+        // wells of width 1 between barriers of height 5 and width 1; the edges of the well fall between grid points
+        ContinuousBase cell(-1.005, 0.995, 200u);
+        cell.setBoundary(ContinuousBase::Periodic);
+        Potential V = Potential::Builder(cell.getCoords()).setType("well").setWidth(1.).setHeight(5.).build();
+
+        BandStructure bands(cell, V, 2, 2);
+        BandStructure::Result r = bands.compute(101);
+        ASSERT_THROW(BandStructure(ContinuousBase(0., 2., 200u), V, 2), std::invalid_argument);
+
+        for (int j = 0; j < 101; j++) {
+            double E = r.energies[j][0];
+            ASSERT_NEAR(E, kronig_penney_energy(r.k[j], 1., 1., 5.), 1e-3);
+            ASSERT_NEAR(bands.blochTrace(E), cos(r.k[j] * bands.getPeriod()), 1e-8);
+            if (j > 0)
+                ASSERT_GT(r.energies[j][0], r.energies[j - 1][0]);
+        }
+        // a gap opens between the bands, and it holds the hard wall level of the cell
+        ASSERT_LT(r.energies[100][0], bands.getDirichletLevels()[0]);
+        ASSERT_GT(r.energies[100][1], bands.getDirichletLevels()[0]);
+        ASSERT_LT(r.energies[100][0] + 0.1, r.energies[100][1]);
+        // cold solve agrees with the tracked bands
+        std::vector<double> cold = bands.solve(r.k[50]);
+        ASSERT_NEAR(cold[0], r.energies[50][0], 1e-8);
+        ASSERT_NEAR(cold[1], r.energies[50][1], 1e-8);
+    }
+
+    TEST(SolveControl, BoundedSolvesReportTheirBracket) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        std::vector<double> legacy(nbox + 1), wf(nbox + 1);
+        legacy[1] = 0.01;
+        double E = solve_Numerov(0., 2., 0.01, nbox, V, legacy.data());
+
+        // unbounded: the same solution as the plain solve
+        wf[1] = 0.01;
+        SolveResult full = solve_Numerov(0., 2., 0.01, nbox, V, wf.data(), SolveControl());
+        ASSERT_EQ(full.status, SolveResult::Converged);
+        ASSERT_EQ(full.energy, E);
+        ASSERT_EQ(wf, legacy);
+
+        // the budget runs out during the scan: no bracket yet, but no level below what was scanned
+        SolveResult scanning = solve_Numerov(0., 2., 0.01, nbox, V, wf.data(), SolveControl().setSweepBudget(30));
+        ASSERT_EQ(scanning.status, SolveResult::BudgetExhausted);
+        ASSERT_EQ(scanning.sweeps, 30);
+        ASSERT_FALSE(scanning.bracketed);
+        ASSERT_TRUE(std::isnan(scanning.energy));
+        ASSERT_LT(scanning.Emax, 0.5);
+
+        // and during the bisection: the bracket holds the level
+        SolveResult bisecting = solve_Numerov(0., 2., 0.01, nbox, V, wf.data(), SolveControl().setSweepBudget(70));
+        ASSERT_EQ(bisecting.status, SolveResult::BudgetExhausted);
+        ASSERT_LE(bisecting.sweeps, 70);
+        ASSERT_TRUE(bisecting.bracketed);
+        ASSERT_LE(bisecting.Emin, E);
+        ASSERT_GE(bisecting.Emax, E);
+        ASSERT_LT(bisecting.Emax - bisecting.Emin, 0.02);
+
+        SolveResult late = solve_Numerov(0., 2., 0.01, nbox, V, wf.data(), SolveControl().setTimeout(0.));
+        ASSERT_EQ(late.status, SolveResult::DeadlineExceeded);
+        ASSERT_EQ(late.sweeps, 0);
+    }
+
+    TEST(SolveControl, CancelFromProgressCallback) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        std::vector<double> wf(nbox + 1);
+        wf[1] = 0.01;
+
+        CancelToken token;
+        int reports = 0;
+        SolveControl control;
+        control.setToken(token).setProgress([&](const SolveProgress &p) {
+            reports++;
+            ASSERT_EQ(std::string(p.stage), "scan");
+            if (p.sweeps == 10)
+                token.cancel();
+        }, 5);
+        SolveResult r = solve_Numerov(0., 2., 0.01, nbox, V, wf.data(), control);
+        ASSERT_EQ(r.status, SolveResult::Cancelled);
+        ASSERT_EQ(r.sweeps, 10);
+        ASSERT_EQ(reports, 2);
+
+        // the server answers with the status, and the bracket reached
+        Server server;
+        JsonObject budget = JsonObject::parse(server.handle("{\"id\": 5, \"potential\": \"ho\", \"max_sweeps\": 70}"));
+        ASSERT_EQ(budget.getString("status", ""), "budget exhausted");
+        ASSERT_LE(budget.getNumber("emin", 1.), 0.5);
+        ASSERT_GE(budget.getNumber("emax", 0.), 0.5);
+        JsonObject cancelled = JsonObject::parse(server.handle("{\"id\": 6, \"potential\": \"ho\"}", token));
+        ASSERT_EQ(cancelled.getString("status", ""), "cancelled");
+        ASSERT_EQ(cancelled.getNumber("sweeps", 1), 0);
+    }
+
+    TEST(ShardedSweep, WorkersSolveTheWholeSweep) {
+        unsigned int nbox = 2000;
+        ShardedSweep sweep("harmonic oscillator", ContinuousBase(dx, nbox), 3);
+        std::vector<double> ks;
+        for (int i = 0; i < 12; i++)
+            ks.push_back(0.25 + 0.05 * i);
+        ShardedSweep::Result r = sweep.addGrid(ks, {5.}, {10.}).setWorkers(3).setShardSize(4).run();
+
+        ASSERT_EQ(r.crashes, 0);
+        ASSERT_EQ(r.requeued, 0);
+        ASSERT_GT(r.sweeps, 0u);
+        for (int p = 0; p < 12; p++) {
+            ASSERT_EQ(r.status[p], ShardedSweep::Done);
+            // V = k x^2: omega = sqrt(2 k)
+            for (int n = 0; n < 3; n++)
+                ASSERT_NEAR(r.energies[p][n], sqrt(2. * ks[p]) * (n + 0.5), 1e-5);
+        }
+        ASSERT_THROW(ShardedSweep("unknownType", ContinuousBase(dx, nbox), 1), std::invalid_argument);
+    }
+
+    TEST(ShardedSweep, CrashedShardsAreRequeued) {
+        unsigned int nbox = 1000;
+        ShardedSweep sweep("harmonic oscillator", ContinuousBase(dx, nbox), 1);
+        for (int i = 0; i < 8; i++)
+            sweep.addPoint(0.5 + 0.1 * i, 5., 10.);
+
+        // point 3 kills its first worker, point 6 every worker that tries it
+        ShardedSweep::Result r = sweep.setWorkers(2).setShardSize(1).setMaxAttempts(2)
+                .setWorkerHook([](int point, int attempt) {
+                    if ((point == 3 && attempt == 1) || point == 6)
+                        raise(SIGKILL);
+                })
+                .run();
+
+        ASSERT_EQ(r.crashes, 3);
+        ASSERT_EQ(r.requeued, 3);
+        for (int p = 0; p < 8; p++) {
+            if (p == 6) {
+                ASSERT_EQ(r.status[p], ShardedSweep::Failed);
+                ASSERT_TRUE(std::isnan(r.energies[p][0]));
+            }
+            else {
+                ASSERT_EQ(r.status[p], ShardedSweep::Done);
+                ASSERT_NEAR(r.energies[p][0], sqrt(2. * (0.5 + 0.1 * p)) * 0.5, 1e-5);
+            }
+        }
+    }
+
+    TEST(Checkpoint, TornRecordsAreDiscarded) {
+        std::string path = (std::filesystem::temp_directory_path() / "schroedinger_checkpoint_records").string();
+        std::filesystem::remove(path);
+        {
+            Checkpoint checkpoint(path, 0.);
+            checkpoint.bracket("job a", 0, 0.4, 0.6);
+            checkpoint.converged("job a", 0, 0.5);
+            checkpoint.bracket("job a", 1, 1.4, 1.6);
+            checkpoint.converged("job b", 0, 2.5);
+            checkpoint.finished("job b");
+        }
+        // a record torn by a crash in the middle of its write
+        std::uintmax_t complete = std::filesystem::file_size(path);
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::app);
+            out.write("\x21\x00\x00\x00\x02\x00", 6);
+        }
+
+        Checkpoint checkpoint(path);
+        ASSERT_EQ(checkpoint.getRecovered(), 5u);
+        ASSERT_EQ(checkpoint.getDiscarded(), 6u);
+        ASSERT_EQ(std::filesystem::file_size(path), complete);
+        ASSERT_FALSE(checkpoint.isFinished("job a"));
+        ASSERT_TRUE(checkpoint.isFinished("job b"));
+        std::vector<Checkpoint::Level> levels = checkpoint.levels("job a");
+        ASSERT_EQ(levels.size(), 2u);
+        ASSERT_EQ(levels[0].energy, 0.5);
+        ASSERT_TRUE(std::isnan(levels[1].energy));
+        ASSERT_EQ(levels[1].Emin, 1.4);
+        ASSERT_EQ(levels[1].Emax, 1.6);
+        ASSERT_TRUE(checkpoint.levels("job c").empty());
+        ASSERT_EQ(crc32("123456789", 9), 0xCBF43926u);
+
+        std::string other = (std::filesystem::temp_directory_path() / "schroedinger_checkpoint_other").string();
+        std::ofstream(other) << "not a checkpoint";
+        ASSERT_THROW(Checkpoint checkpoint(other), std::invalid_argument);
+        std::filesystem::remove(other);
+        std::filesystem::remove(path);
+    }
+
+    TEST(Checkpoint, IdleWriterSleeps) {
+        // with an interval of 0 the writer syncs every batch, and waits for the next one without spinning
+        std::string path = (std::filesystem::temp_directory_path() / "schroedinger_checkpoint_idle").string();
+        std::filesystem::remove(path);
+        {
+            Checkpoint checkpoint(path, 0.);
+            checkpoint.converged("job", 0, 0.5);
+            checkpoint.flush();
+
+            std::clock_t start = std::clock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            ASSERT_LT(double(std::clock() - start) / CLOCKS_PER_SEC, 0.02);
+
+            checkpoint.finished("job");
+            checkpoint.flush();
+        }
+        Checkpoint checkpoint(path);
+        ASSERT_EQ(checkpoint.getRecovered(), 2u);
+        ASSERT_TRUE(checkpoint.isFinished("job"));
+        std::filesystem::remove(path);
+    }
+
+    TEST(Checkpoint, InlineWriterStartsNoThread) {
+        // a process that forks must not have another thread holding a lock: the owner writes the records
+        std::string path = (std::filesystem::temp_directory_path() / "schroedinger_checkpoint_inline").string();
+        std::filesystem::remove(path);
+        auto threads = [] {
+            return std::distance(std::filesystem::directory_iterator("/proc/self/task"),
+                                 std::filesystem::directory_iterator());
+        };
+        auto before = threads();
+        {
+            Checkpoint checkpoint(path, 0., Checkpoint::Inline);
+            ASSERT_EQ(threads(), before);
+            checkpoint.bracket("job", 0, 0.4, 0.6);
+            checkpoint.commit();
+            std::uintmax_t size = std::filesystem::file_size(path);
+            ASSERT_GT(size, 8u);
+            checkpoint.converged("job", 0, 0.5);
+            ASSERT_EQ(std::filesystem::file_size(path), size);
+            checkpoint.flush();
+            ASSERT_GT(std::filesystem::file_size(path), size);
+            checkpoint.finished("job");
+        }
+        Checkpoint checkpoint(path);
+        ASSERT_EQ(checkpoint.getRecovered(), 3u);
+        ASSERT_TRUE(checkpoint.isFinished("job"));
+        std::filesystem::remove(path);
+    }
+
+    TEST(ShardedSweep, ResumesFromCheckpoint) {
+        std::string path = (std::filesystem::temp_directory_path() / "schroedinger_checkpoint_sweep").string();
+        std::filesystem::remove(path);
+        unsigned int nbox = 1000;
+        ShardedSweep sweep("harmonic oscillator", ContinuousBase(dx, nbox), 2);
+        for (int i = 0; i < 6; i++)
+            sweep.addPoint(0.5 + 0.1 * i, 5., 10.);
+        sweep.setWorkers(2).setShardSize(1).setMaxAttempts(1).setCheckpoint(path, 0.);
+
+        // point 4 is killed: everything else is in the checkpoint
+        ShardedSweep::Result killed = sweep.setWorkerHook([](int point, int) {
+            if (point == 4)
+                raise(SIGKILL);
+        }).run();
+        ASSERT_EQ(killed.status[4], ShardedSweep::Failed);
+        ASSERT_EQ(killed.resumed, 0);
+
+        ShardedSweep::Result resumed = sweep.setWorkerHook(nullptr).run();
+        ASSERT_EQ(resumed.resumed, 5);
+        ASSERT_GT(resumed.sweeps, 0u);
+        ASSERT_LT(resumed.sweeps, killed.sweeps);
+        for (int p = 0; p < 6; p++) {
+            ASSERT_EQ(resumed.status[p], ShardedSweep::Done);
+            for (int n = 0; n < 2; n++) {
+                ASSERT_NEAR(resumed.energies[p][n], sqrt(2. * (0.5 + 0.1 * p)) * (n + 0.5), 1e-5);
+                if (p != 4)
+                    ASSERT_EQ(resumed.energies[p][n], killed.energies[p][n]);
+            }
+        }
+
+        // nothing is left to solve
+        ASSERT_EQ(sweep.run().sweeps, 0u);
+        std::filesystem::remove(path);
+    }
+
+    TEST(ShardedSweep, ResumesPartlyFinishedShards) {
+        // shard 0 is finished in the checkpoint and never claimed again; shard 1 resumes from its point 3
+        std::string path = (std::filesystem::temp_directory_path() / "schroedinger_checkpoint_shards").string();
+        std::filesystem::remove(path);
+        unsigned int nbox = 1000;
+        ShardedSweep sweep("harmonic oscillator", ContinuousBase(dx, nbox), 2);
+        for (int i = 0; i < 6; i++)
+            sweep.addPoint(0.5 + 0.1 * i, 5., 10.);
+        sweep.setWorkers(2).setShardSize(3).setMaxAttempts(1).setCheckpoint(path, 0.);
+
+        ShardedSweep::Result killed = sweep.setWorkerHook([](int point, int) {
+            if (point == 4)
+                raise(SIGKILL);
+        }).run();
+        ASSERT_EQ(killed.status[3], ShardedSweep::Done);
+        ASSERT_EQ(killed.status[4], ShardedSweep::Failed);
+        ASSERT_EQ(killed.status[5], ShardedSweep::Failed);
+
+        ShardedSweep::Result resumed = sweep.setWorkerHook(nullptr).run();
+        ASSERT_EQ(resumed.resumed, 4);
+        for (int p = 0; p < 6; p++) {
+            ASSERT_EQ(resumed.status[p], ShardedSweep::Done);
+            for (int n = 0; n < 2; n++) {
+                ASSERT_NEAR(resumed.energies[p][n], sqrt(2. * (0.5 + 0.1 * p)) * (n + 0.5), 1e-5);
+                if (p < 4)
+                    ASSERT_EQ(resumed.energies[p][n], killed.energies[p][n]);
+            }
+        }
+        std::filesystem::remove(path);
+    }
+
+    TEST(Potential, ReportsChangedRegion) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential narrow = Potential::Builder(base.getCoords()).setType("well").setWidth(4.).build();
+        ASSERT_EQ(narrow.getChanged().first, 0u);
+        ASSERT_EQ(narrow.getChanged().last, nbox);
+
+        // the well edges move by 0.5 on both sides: x in (-2.5, -2] and [2, 2.5)
+        Potential wide = Potential::Builder(base.getCoords()).setType("well").setWidth(5.).build(narrow);
+        Potential::Region changed = wide.getChanged();
+        ASSERT_NEAR(base.getCoords()[changed.first], -2.49, 1e-9);
+        ASSERT_NEAR(base.getCoords()[changed.last - 1], 2.49, 1e-9);
+        ASSERT_TRUE(wide.changedFrom(wide).empty());
+
+        std::vector<double> values = wide.getValues();
+        values[700] += 1.;
+        wide.setValues(values);
+        ASSERT_EQ(wide.getChanged().first, 700u);
+        ASSERT_EQ(wide.getChanged().last, 701u);
+    }
+
+    TEST(IncrementalNumerov, SameSolveFromRestartedSweeps) {
+        int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        const std::vector<double> ho = V.getValues();
+        std::vector<double> full(nbox + 1), restarted(nbox + 1);
+        IncrementalNumerov incremental(nbox);
+
+        // a bump moved through the right half of the box
+        for (int center = 600; center <= 900; center += 50) {
+            std::vector<double> values = ho;
+            for (int i = center - 10; i <= center + 10; i++)
+                values[i] += 2.;
+            V.setValues(values);
+
+            full[0] = restarted[0] = 0.;
+            full[1] = restarted[1] = 0.01;
+            double E = solve_Numerov(0., 2., 0.01, nbox, V, full.data());
+            double Einc = solve_Numerov(0., 2., 0.01, nbox, V, restarted.data(), incremental);
+            ASSERT_EQ(E, Einc);
+            for (int i = 0; i <= nbox; i++)
+                ASSERT_EQ(full[i], restarted[i]);
+        }
+        // every solve after the first restarts its scan past the middle of the box
+        ASSERT_GT(incremental.getSkipped(), incremental.getSteps());
+        ASSERT_THROW(solve_Numerov(0., 2., 0.01, nbox / 2, V, full.data(), incremental), std::invalid_argument);
+    }
+
+    TEST(IncrementalNumerov, KeepsTheMostRecentEnergiesWithinItsBudget) {
+        int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        std::vector<double> wf(nbox + 1);
+        wf[1] = 0.01;
+
+        // 2 * 1000 / 10 values of 8 bytes per energy: room for two energies
+        IncrementalNumerov incremental(nbox, 10, 3200);
+        incremental.setPotential(V);
+        incremental.sweep(0.5, wf.data());
+        incremental.sweep(1.5, wf.data());
+        ASSERT_EQ(incremental.getBytes(), 3200u);
+        incremental.sweep(0.5, wf.data());   // 0.5 is now the most recent
+        incremental.sweep(2.5, wf.data());   // 1.5 is dropped
+        ASSERT_EQ(incremental.getBytes(), 3200u);
+
+        unsigned long skipped = incremental.getSkipped();
+        incremental.sweep(0.5, wf.data());
+        ASSERT_GT(incremental.getSkipped(), skipped);
+        skipped = incremental.getSkipped();
+        incremental.sweep(1.5, wf.data());
+        ASSERT_EQ(incremental.getSkipped(), skipped);
+        ASSERT_EQ(incremental.getBytes(), 3200u);
+
+        // a whole solve stays within the budget, with the same result
+        std::vector<double> full(nbox + 1);
+        full[1] = 0.01;
+        ASSERT_EQ(solve_Numerov(0., 2., 0.01, nbox, V, wf.data(), incremental),
+                  solve_Numerov(0., 2., 0.01, nbox, V, full.data()));
+        ASSERT_LE(incremental.getBytes(), 3200u);
+    }
+
+    TEST(Spectrum, SincDVRIsSpectrallyAccurate) {
+        // 199 points for the lowest levels of the oscillator (omega = 1) to 1e-10
+        ContinuousBase base(0.1, 200);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        Spectrum s = solve_spectrum(Spectrum::SincDVR, 4, base, V);
+
+        ASSERT_EQ(s.energies.size(), 4u);
+        for (int n = 0; n < 4; n++)
+            ASSERT_NEAR(s.energies[n], n + 0.5, 1e-10);
+
+        std::vector<double> x = base.getCoords();
+        ASSERT_EQ(s.wavefunctions[0].size(), 201u);
+        ASSERT_EQ(s.wavefunctions[0][0], 0.);
+        ASSERT_EQ(s.wavefunctions[0][200], 0.);
+        for (int i = 0; i < 200; i++)
+            ASSERT_NEAR(s.wavefunctions[0][i], std::exp(-x[i] * x[i] / 2.) / std::pow(M_PI, 0.25), 1e-8);
+        // first lobe positive, as in solve_Numerov
+        ASSERT_GT(s.wavefunctions[1][50], 0.);
+        ASSERT_LT(s.wavefunctions[1][150], 0.);
+
+        ASSERT_EQ(Spectrum::engine("dvr"), Spectrum::SincDVR);
+        ASSERT_THROW(Spectrum::engine("chebyshev"), std::invalid_argument);
+        // Numerov on the same grid, fourth order in the mesh
+        ASSERT_NEAR(solve_spectrum(Spectrum::Numerov, 1, base, V).energies[0], 0.5, 1e-4);
+    }
+
+    TEST(Spectrum, FiniteDifference6IsSixthOrder) {
+        std::vector<double> error;
+        for (double mesh : {0.2, 0.1}) {
+            ContinuousBase base(mesh, (unsigned int) std::lround(20. / mesh));
+            Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+            Spectrum s = solve_spectrum(Spectrum::FiniteDifference6, 3, base, V);
+            error.push_back(std::fabs(s.energies[2] - 2.5));
+
+            Spectrum dvr = solve_spectrum(Spectrum::SincDVR, 3, base, V);
+            double overlap = 0.;
+            for (std::size_t i = 0; i < s.wavefunctions[2].size(); i++)
+                overlap += s.wavefunctions[2][i] * dvr.wavefunctions[2][i] * mesh;
+            ASSERT_NEAR(overlap, 1., 1e-4);
+        }
+        // halving the mesh divides the error by 2^6
+        ASSERT_LT(error[1], 1e-6);
+        ASSERT_GT(error[0] / error[1], 50.);
+
+        // the Numerov engine is solve_Numerov_level (solve_Numerov_symmetric for symmetric potentials)
+        ContinuousBase base(dx, 1000);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        Spectrum symmetric = solve_spectrum(Spectrum::Numerov, 2, base, V);
+        std::vector<double> guesses = analytic_states(2, base, V, false).energies;
+        ASSERT_EQ(symmetric.energies, solve_Numerov_symmetric(2, 1000, V, true, guesses).energies);
+
+        std::vector<double> tilted = V.getValues();
+        for (std::size_t i = 0; i < tilted.size(); i++)
+            tilted[i] += 0.01 * base.getCoords()[i];
+        V.setValues(tilted);
+        std::vector<double> wf(1001);
+        wf[0] = 0.;
+        wf[1] = 0.01;
+        double E1 = solve_Numerov_level(1, 1000, V, wf.data());
+        Spectrum numerov = solve_spectrum(Spectrum::Numerov, 2, base, V);
+        ASSERT_EQ(numerov.energies[1], E1);
+        ASSERT_EQ(numerov.wavefunctions[1], wf);
+    }
+
+    TEST(CApi, SolvesInCallerBuffers) {
+        int nbox = 1000;
+        sch_base *base = nullptr;
+        ASSERT_EQ(sch_base_create(dx, nbox, &base), SCH_OK);
+        std::vector<double> x(nbox);
+        ASSERT_EQ(sch_base_coords(base, x.data(), x.size()), SCH_OK);
+
+        // the caller owns the potential: the handle reads it in place
+        std::vector<double> values(nbox);
+        for (int i = 0; i < nbox; i++)
+            values[i] = 0.5 * x[i] * x[i];
+        sch_potential *wrapped = nullptr;
+        ASSERT_EQ(sch_potential_wrap(base, values.data(), values.size(), &wrapped), SCH_OK);
+        const double *read = nullptr;
+        ASSERT_EQ(sch_potential_values(wrapped, &read), SCH_OK);
+        ASSERT_EQ(read, values.data());
+
+        std::vector<double> wf(nbox + 1), expected(nbox + 1);
+        double E = 0.;
+        ASSERT_EQ(sch_solve(wrapped, 0., 2., 0.01, wf.data(), wf.size(), &E), SCH_OK);
+        Potential V = Potential::Builder(x).setType("harmonic oscillator").setK(0.5).build();
+        expected[0] = 0.;
+        expected[1] = 0.01;
+        ASSERT_EQ(E, solve_Numerov(0., 2., 0.01, nbox, V, expected.data()));
+        ASSERT_EQ(wf, expected);
+
+        // a change of the caller buffer is seen by the next solve
+        for (double &v : values)
+            v *= 4.;
+        ASSERT_EQ(sch_solve_level(wrapped, 1, wf.data(), wf.size(), &E), SCH_OK);
+        ASSERT_NEAR(E, 3., 1e-6);
+
+        sch_potential *ho = nullptr;
+        ASSERT_EQ(sch_potential_create(base, "harmonic oscillator", 0.5, 5., 10., &ho), SCH_OK);
+        std::vector<double> energies(3), wavefunctions(3 * (nbox + 1));
+        ASSERT_EQ(sch_solve_spectrum(ho, SCH_ENGINE_FD6, 3, energies.data(), wavefunctions.data(), wavefunctions.size()), SCH_OK);
+        for (int n = 0; n < 3; n++)
+            ASSERT_NEAR(energies[n], n + 0.5, 1e-6);
+        ASSERT_EQ(wavefunctions[nbox + 1], 0.);
+
+        sch_potential_destroy(ho);
+        sch_potential_destroy(wrapped);
+        sch_base_destroy(base);
+    }
+
+    TEST(CApi, ReportsErrorsAndSharesHandlesAcrossThreads) {
+        int nbox = 1000;
+        sch_base *base = nullptr;
+        sch_potential *V = nullptr;
+        ASSERT_EQ(sch_abi_version(), SCH_ABI_VERSION);
+        ASSERT_EQ(sch_base_create(-1., nbox, &base), SCH_INVALID_ARGUMENT);
+        ASSERT_EQ(base, nullptr);
+        ASSERT_STRNE(sch_last_error(), "");
+        ASSERT_EQ(sch_base_create(dx, nbox, &base), SCH_OK);
+        ASSERT_STREQ(sch_last_error(), "");
+        ASSERT_EQ(sch_potential_create(base, "no such type", 0.5, 5., 10., &V), SCH_INVALID_ARGUMENT);
+        ASSERT_EQ(sch_potential_create(base, "harmonic oscillator", 0.5, 5., 10., &V), SCH_OK);
+
+        std::vector<double> wf(nbox + 1);
+        double E = 0.;
+        ASSERT_EQ(sch_solve(V, 0., 2., 0.01, wf.data(), nbox, &E), SCH_INVALID_ARGUMENT);
+        ASSERT_EQ(sch_solve(V, 0., 2., 0.01, (double *) ((char *) wf.data() + 1), nbox + 1, &E), SCH_INVALID_ARGUMENT);
+        ASSERT_EQ(sch_solve(V, 0.6, 1.4, 0.01, wf.data(), wf.size(), &E), SCH_NOT_FOUND);
+        ASSERT_STREQ(sch_status_message(SCH_NOT_FOUND), "not found");
+
+        // one handle, a buffer per thread
+        std::vector<double> energies(4);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&, t] {
+                std::vector<double> own(nbox + 1);
+                if (sch_solve_level(V, t, own.data(), own.size(), &energies[t]) != SCH_OK)
+                    energies[t] = NAN;
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+        for (int t = 0; t < 4; t++)
+            ASSERT_NEAR(energies[t], t + 0.5, 1e-5);
+
+        sch_potential_destroy(V);
+        sch_base_destroy(base);
+    }
+
+    TEST(Wavefunction, AlignedPooledAndMoveOnly) {
+        static_assert(!std::is_copy_constructible<Wavefunction>::value, "Wavefunction is move only");
+
+        ContinuousBase base(0.01, 777);
+        WavefunctionPool &pool = WavefunctionPool::global();
+        const double *first;
+        {
+            Wavefunction psi(base);
+            first = psi.data();
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(psi.data()) % WavefunctionPool::alignment, 0u);
+            EXPECT_EQ(psi.size(), 778u);
+            EXPECT_EQ(psi.getNbox(), 777);
+            EXPECT_DOUBLE_EQ(psi.getMesh(), 0.01);
+            EXPECT_DOUBLE_EQ(psi.x(0), base.getStart());
+            EXPECT_DOUBLE_EQ(psi[0], 0.);
+            EXPECT_DOUBLE_EQ(psi[1], 0.01);
+            EXPECT_DOUBLE_EQ(psi[777], 0.);
+
+            Wavefunction moved(std::move(psi));
+            EXPECT_EQ(moved.data(), first);
+            EXPECT_EQ(psi.data(), nullptr);
+        }
+        unsigned long reuses = pool.getReuses();
+        Wavefunction again(base);
+        EXPECT_EQ(again.data(), first);
+        EXPECT_EQ(pool.getReuses(), reuses + 1);
+
+        Wavefunction copy = again.clone();
+        EXPECT_NE(copy.data(), again.data());
+        EXPECT_DOUBLE_EQ(copy[1], again[1]);
+    }
+
+    TEST(Wavefunction, SolvesLikeRawBuffers) {
+        int nbox = 1000;
+        ContinuousBase base(0.01, nbox);
+        Potential V = Potential::Builder(base.getCoords())
+                .setType("harmonic oscillator")
+                .setK(0.5)
+                .build();
+
+        std::vector<double> raw(nbox + 1);
+        raw[0] = 0.;
+        raw[1] = 0.01;
+        double E = solve_Numerov(0., 2., 0.01, nbox, V, raw.data());
+
+        Wavefunction psi(base);
+        EXPECT_DOUBLE_EQ(solve_Numerov(0., 2., 0.01, V, psi), E);
+        for (int i = 0; i <= nbox; i++)
+            EXPECT_DOUBLE_EQ(psi[i], raw[i]);
+        EXPECT_NEAR(psi.norm(), 1., 1e-6);
+
+        raw[0] = 0.;
+        raw[1] = 0.01;
+        double E1 = solve_Numerov_level(1, nbox, V, raw.data());
+        psi.reset();
+        EXPECT_DOUBLE_EQ(solve_Numerov_level(1, V, psi), E1);
+
+        // the solve takes the mesh of the wavefunction
+        Wavefunction coarse(nbox, base.getStart(), 0.02);
+        std::vector<double> rawCoarse(nbox + 1);
+        rawCoarse[1] = 0.01;
+        double Ecoarse = solve_Numerov(0., 2., 0.01, nbox, V, rawCoarse.data(), SolverConfig().setMesh(0.02));
+        EXPECT_DOUBLE_EQ(solve_Numerov(0., 2., 0.01, V, coarse), Ecoarse);
+        EXPECT_NE(Ecoarse, E);
+    }
+
+    TEST(Parity, SectorsMatchTheFullGrid) {
+        for (int nbox : {1000, 999}) {
+            ContinuousBase base(0.01, nbox);
+            Potential V = Potential::Builder(base.getCoords())
+                    .setType("harmonic oscillator")
+                    .setK(0.5)
+                    .build();
+            ASSERT_TRUE(is_symmetric(nbox, V));
+
+            std::vector<double> full(nbox + 1), half(nbox + 1);
+            for (int n = 0; n < 4; n++) {
+                full[0] = half[0] = 0.;
+                full[1] = half[1] = 0.01;
+                double E = solve_Numerov_level(n, nbox, V, full.data());
+                int sweeps = 0;
+                ASSERT_NEAR(solve_Numerov_parity(n / 2, (n % 2) ? -1 : 1, nbox, V, half.data(), &sweeps), E, 1e-9);
+                ASSERT_GT(sweeps, 0);
+                for (int i = 0; i <= nbox; i++)
+                    ASSERT_NEAR(half[i], full[i], 1e-5);
+            }
+        }
+    }
+
+    TEST(Parity, SymmetricSpectrumInterleavesTheSectors) {
+        int nbox = 1000;
+        ContinuousBase base(0.01, nbox);
+        Potential box = Potential::Builder(base.getCoords()).setType("box").build();
+        Spectrum s = solve_Numerov_symmetric(5, nbox, box);
+        ASSERT_EQ(s.energies.size(), 5u);
+        ASSERT_EQ(s.wavefunctions.size(), 5u);
+        double L = nbox * 0.01;
+        for (int n = 0; n < 5; n++) {
+            ASSERT_NEAR(s.energies[n], (n + 1) * (n + 1) * M_PI * M_PI / 2. / L / L, 1e-6);
+            double parity = (n % 2) ? -1. : 1.;
+            ASSERT_NEAR(s.wavefunctions[n][300], parity * s.wavefunctions[n][nbox - 300], 1e-12);
+        }
+
+        // the Numerov engine picks the sectors up by itself
+        Spectrum detected = solve_spectrum(Spectrum::Numerov, 5, base, box);
+        for (int n = 0; n < 5; n++)
+            ASSERT_NEAR(detected.energies[n], s.energies[n], 1e-10);
+
+        std::vector<double> tilted = box.getValues();
+        tilted[10] = 1.;
+        box.setValues(tilted);
+        ASSERT_FALSE(is_symmetric(nbox, box));
+        std::vector<double> psi(nbox + 1);
+        ASSERT_THROW(solve_Numerov_parity(0, 0, nbox, box, psi.data()), std::invalid_argument);
+    }
+
+    TEST(Analytic, HermiteRecurrenceIsNormalizedToHighLevels) {
+        std::vector<double> x(4001);
+        for (std::size_t i = 0; i < x.size(); i++)
+            x[i] = -40. + 0.02 * i;
+        AnalyticStates ho = harmonic_states(200, x, 1.);
+        ASSERT_EQ(ho.values.size(), 200u * x.size());
+        ASSERT_DOUBLE_EQ(ho.energies[199], 199.5);
+
+        for (int n : {0, 1, 7, 150, 199}) {
+            std::vector<double> probab(x.size());
+            for (std::size_t i = 0; i < x.size(); i++)
+                probab[i] = ho.level(n)[i] * ho.level(n)[i];
+            double norm = trap_array(0, (int) x.size() - 1, 0.02, probab.data());
+            ASSERT_NEAR(norm, 1., 1e-9) << "level " << n;
+        }
+        double overlap = 0.;
+        for (std::size_t i = 0; i < x.size(); i++)
+            overlap += ho.level(150)[i] * ho.level(152)[i] * 0.02;
+        ASSERT_NEAR(overlap, 0., 1e-9);
+
+        // the explicit formula, with the factorial in floating point, for a level past int factorials
+        int n = 20;
+        double xi = 1.3;
+        double explicit_value = std::hermite(n, xi) * std::exp(-xi * xi / 2.)
+                / std::sqrt(std::pow(2., n) * std::tgamma(n + 1.) * std::sqrt(M_PI));
+        std::vector<double> psi(1000);
+        harmonic_wf(n, 1000, 1., psi.data());
+        ASSERT_NEAR(psi[630], explicit_value, 1e-12);
+    }
+
+    TEST(Analytic, HermiteLevelsPastTheUnderflowOfTheGroundState) {
+        // exp(-xi^2 / 2) is 0 past |xi| = 38.6, inside the turning point sqrt(2 n + 1) = 44.7 of level 999
+        std::vector<double> x(5501);
+        for (std::size_t i = 0; i < x.size(); i++)
+            x[i] = -55. + 0.02 * i;
+        AnalyticStates ho = harmonic_states(1000, x, 1.);
+
+        for (int n : {799, 999}) {
+            std::vector<double> probab(x.size());
+            for (std::size_t i = 0; i < x.size(); i++)
+                probab[i] = ho.level(n)[i] * ho.level(n)[i];
+            ASSERT_NEAR(trap_array(0, (int) x.size() - 1, 0.02, probab.data()), 1., 1e-6) << "level " << n;
+        }
+        double overlap = 0.;
+        for (std::size_t i = 0; i < x.size(); i++)
+            overlap += ho.level(999)[i] * ho.level(997)[i] * 0.02;
+        ASSERT_NEAR(overlap, 0., 1e-6);
+        // the classically allowed region reaches x = 42: level 999 is not small there
+        ASSERT_GT(std::fabs(ho.level(999)[(std::size_t) ((42. + 55.) / 0.02)]), 1e-3);
+        ASSERT_LT(std::fabs(ho.level(999)[0]), 1e-50);
+    }
+
+    TEST(Analytic, BuiltInPotentialsAndWarmStarts) {
+        int nbox = 1000;
+        ContinuousBase base(0.01, nbox);
+        Potential box = Potential::Builder(base.getCoords()).setType("box").build();
+        AnalyticStates states = analytic_states(6, base, box);
+        ASSERT_EQ(states.points, (std::size_t) nbox + 1);
+        Spectrum numerov = solve_spectrum(Spectrum::Numerov, 6, base, box);
+        for (int n = 0; n < 6; n++) {
+            ASSERT_NEAR(states.energies[n], numerov.energies[n], 1e-5);
+            for (int i = 0; i <= nbox; i += 50)
+                ASSERT_NEAR(states.level(n)[i], numerov.wavefunctions[n][i], 1e-4);
+        }
+
+        Potential well = Potential::Builder(base.getCoords()).setType("well").setWidth(5.).setHeight(10.).build();
+        AnalyticStates bound = analytic_states(12, base, well);
+        ASSERT_TRUE(std::isnan(bound.energies[11]));
+        ASSERT_EQ(bound.level(11)[500], 0.);
+        Spectrum levels = solve_spectrum(Spectrum::Numerov, 3, base, well);
+        // the steps of the well fall between grid points: the levels move by O(dx)
+        for (int n = 0; n < 3; n++)
+            ASSERT_NEAR(levels.energies[n], bound.energies[n], 1e-2);
+        ASSERT_NEAR(std::fabs(bound.level(0)[500]), std::fabs(levels.wavefunctions[0][500]), 1e-3);
+
+        std::vector<double> values = well.getValues();
+        well.setValues(values);
+        ASSERT_TRUE(std::isnan(analytic_states(2, base, well).energies[0]));
+    }
+
+    TEST(Scattering, RectangularBarrier) {
+        ContinuousBase base(0.001, 10000);
+        // a finite well of negative height: leads at -1, a barrier of height 1 and width 1 in between
+        Potential V = Potential::Builder(base.getCoords()).setType("well").setWidth(1.).setHeight(-1.).build();
+        Scattering scattering(base, V, 2);
+
+        std::vector<double> energies = {-1.5, -0.5, 0.5, 2.};
+        Scattering::Transmission t = scattering.transmission(energies);
+        ASSERT_EQ(t.transmission[0], 0.);
+        ASSERT_EQ(t.reflection[0], 1.);
+        for (int i = 1; i < 4; i++) {
+            double E = energies[i] + 1., V0 = 1., a = 1.;
+            double T;
+            if (E < V0) {
+                double s = std::sinh(std::sqrt(2. * (V0 - E)) * a);
+                T = 1. / (1. + V0 * V0 * s * s / (4. * E * (V0 - E)));
+            }
+            else {
+                double s = std::sin(std::sqrt(2. * (E - V0)) * a);
+                T = 1. / (1. + V0 * V0 * s * s / (4. * E * (E - V0)));
+            }
+            ASSERT_NEAR(t.transmission[i], T, 5e-3) << "E = " << E;
+            ASSERT_NEAR(t.transmission[i] + t.reflection[i], 1., 1e-10);
+        }
+
+        Potential flat = Potential::Builder(base.getCoords()).setType("box").build();
+        Scattering::Transmission free = Scattering(base, flat).transmission({0.1, 1., 10.});
+        for (double T : free.transmission)
+            ASSERT_NEAR(T, 1., 1e-10);
+    }
+
+    TEST(Scattering, RefinesAroundResonances) {
+        ContinuousBase base(0.01, 800);
+        std::vector<double> x = base.getCoords(), values(x.size(), 0.);
+        for (std::size_t i = 0; i < x.size(); i++) {
+            if (std::fabs(x[i]) > 1. && std::fabs(x[i]) < 1.5)
+                values[i] = 4.;
+        }
+        Potential V = Potential::Builder(x).build();
+        V.setValues(values);
+
+        Scattering scattering(base, V, 4);
+        Scattering::Transmission coarse = scattering.transmission({0.1, 0.3, 0.5, 0.7, 0.9});
+        Scattering::Transmission t = scattering.setTolerance(1e-4).spectrum(0.1, 0.9, 5);
+        ASSERT_GT(t.energies.size(), 5u);
+        ASSERT_TRUE(std::is_sorted(t.energies.begin(), t.energies.end()));
+        // the resonance of the double barrier (T = 1), between the coarse energies
+        ASSERT_LT(*std::max_element(coarse.transmission.begin(), coarse.transmission.end()), 0.5);
+        ASSERT_GT(*std::max_element(t.transmission.begin(), t.transmission.end()), 0.99);
+
+        // the same energies, whatever the threads and batches
+        Scattering::Transmission serial = Scattering(base, V, 1).transmission(t.energies);
+        ASSERT_EQ(serial.transmission, t.transmission);
+        for (std::size_t i = 0; i < t.energies.size(); i++)
+            ASSERT_NEAR(t.transmission[i] + t.reflection[i], 1., 1e-10);
+    }
+
+    TEST(Streaming, ShootEqualsTheArraySweep) {
+        int nbox = 3000;
+        ContinuousBase base(0.01, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        const std::vector<double> &values = V.getValues();
+        std::vector<float> fvalues(values.begin(), values.end());
+
+        std::vector<double> wf(nbox + 1);
+        std::vector<float> fwf(nbox + 1);
+        wf[0] = 0.;
+        wf[1] = 0.01;
+        fwf[0] = 0.f;
+        fwf[1] = 0.01f;
+        // the float sweeps at high energy overflow and are rescaled on the way
+        for (double E : {0.3, 0.5, 1.7, 20.}) {
+            fsol_Numerov<double>(E, nbox, values.data(), wf.data());
+            double tail[3];
+            int nodes = -1;
+            unsigned long before = numerov_sweeps();
+            ASSERT_EQ(shoot_Numerov<double>(E, nbox, nbox, values.data(), 0., 0.01, &nodes, tail), wf[nbox]);
+            ASSERT_EQ(numerov_sweeps(), before + 1);
+            ASSERT_EQ(tail[0], wf[nbox - 2]);
+            ASSERT_EQ(tail[1], wf[nbox - 1]);
+            ASSERT_EQ(nodes, count_nodes_Numerov<double>(E, nbox, values.data(), wf.data()));
+
+            fsol_Numerov<float>((float) E, nbox, fvalues.data(), fwf.data());
+            ASSERT_EQ(shoot_Numerov<float>((float) E, nbox, nbox, fvalues.data(), 0.f, 0.01f), fwf[nbox]);
+            ASSERT_EQ(shoot_Numerov<double>(E, 1500, nbox, values.data(), 0., 0.01), wf[1500]);
+        }
+    }
+
+    TEST(Streaming, SolvesWriteTheWavefunctionOnce) {
+        int nbox = 1000;
+        ContinuousBase base(0.01, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+
+        // a guard value past the starting values survives every energy only sweep of the bracketing
+        std::vector<double> wf(nbox + 1, 0.);
+        wf[1] = 0.01;
+        wf[nbox] = 123.;
+        EnergyBracket b = bracket_Numerov(2, nbox, V, wf.data());
+        refine_Numer(b.Emin, b.Emax, nbox, V, wf.data());
+        ASSERT_EQ(wf[nbox], 123.);
+
+        // the wavefunction of solve_Numerov is that of its energy
+        double E = solve_Numerov(0., 2., 0.01, nbox, V, wf.data());
+        std::vector<double> check(nbox + 1, 0.);
+        check[1] = 0.01;
+        fsol_Numerov(E, nbox, V, check.data());
+        double scale = wf[nbox / 2] / check[nbox / 2];
+        for (int i = 200; i <= 800; i += 100)
+            ASSERT_NEAR(wf[i], scale * check[i], 1e-6);
+        ASSERT_NEAR(E, 0.5, 1e-4);
+    }
+
+    TEST(MappedBlock, TileAlignedRowsPersistInTheFile) {
+        std::string path = (std::filesystem::temp_directory_path() / "mapped_block_test.bin").string();
+        {
+            MappedBlock block = MappedBlock::create(path, 5, 1001);
+            ASSERT_EQ(block.getStride() * sizeof(double) % block.getTile(), 0u);
+            ASSERT_GE(block.getStride(), 1001u);
+            for (std::size_t r = 0; r < block.getRows(); r++) {
+                ASSERT_EQ((std::uintptr_t) block.row(r) % block.getTile(), 0u);
+                for (std::size_t i = 0; i < block.getColumns(); i++)
+                    block.row(r)[i] = r * 10000. + i;
+            }
+            block.flush(0, 2, true);
+            // evicted rows are read back from the file
+            block.evict(0, block.getRows());
+            ASSERT_EQ(block.row(3)[1000], 31000.);
+
+            MappedBlock moved(std::move(block));
+            ASSERT_EQ(moved.row(4)[7], 40007.);
+        }
+
+        MappedBlock reopened = MappedBlock::open(path);
+        ASSERT_EQ(reopened.getRows(), 5u);
+        ASSERT_EQ(reopened.getColumns(), 1001u);
+        for (std::size_t r = 0; r < 5; r++)
+            ASSERT_EQ(reopened.row(r)[500], r * 10000. + 500.);
+        std::filesystem::remove(path);
+
+        ASSERT_THROW(MappedBlock::scratch(std::filesystem::temp_directory_path().string(), 2, 10, 1000),
+                     std::invalid_argument);
+        ASSERT_THROW(MappedBlock::open(path), std::runtime_error);
+    }
+
+    TEST(MappedBlock, RejectsTruncatedAndInconsistentFiles) {
+        std::string path = (std::filesystem::temp_directory_path() / "mapped_block_truncated.bin").string();
+        MappedBlock::create(path, 4, 1000);
+        const std::uintmax_t full = std::filesystem::file_size(path);
+        ASSERT_EQ(MappedBlock::open(path).getRows(), 4u);
+
+        // a partly written file: the last row is missing
+        std::filesystem::resize_file(path, full - 1);
+        ASSERT_THROW(MappedBlock::open(path), std::runtime_error);
+        std::filesystem::resize_file(path, full);
+
+        // a stride that is not the one of (columns, tile)
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            std::uint64_t stride = 3;
+            file.seekp(8 + 3 * sizeof(std::uint64_t));
+            file.write((const char *) &stride, sizeof(stride));
+        }
+        ASSERT_THROW(MappedBlock::open(path), std::runtime_error);
+        std::filesystem::remove(path);
+
+        ASSERT_THROW(MappedBlock::scratch(std::filesystem::temp_directory_path().string(), SIZE_MAX / 2, 1000),
+                     std::invalid_argument);
+    }
+
+    TEST(MappedBlock, StreamsObservablesOutOfCore) {
+        unsigned int nbox = 1000;
+        ContinuousBase base(dx, nbox);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+
+        MappedBlock block = MappedBlock::scratch(std::filesystem::temp_directory_path().string(), 6, nbox + 1);
+        std::vector< std::vector<double> > wf(6, std::vector<double>(nbox + 1));
+        std::vector<const double *> states;
+        for (int n = 0; n < 6; n++) {
+            wf[n][1] = 0.01;
+            solve_Numerov_level(n, nbox, V, wf[n].data());
+            states.push_back(wf[n].data());
+        }
+        // the kernel sees every row once, in order
+        std::size_t visited = 0;
+        block.stream(4, [&](std::size_t r, double *row) {
+            ASSERT_EQ(r, visited++);
+            std::copy(wf[r].begin(), wf[r].end(), row);
+        });
+        ASSERT_EQ(visited, 6u);
+
+        Observables obs(base, V, Observables::Simpson);
+        std::vector<Observables::Expectation> inCore = obs.expectationValues(states);
+        std::vector<Observables::Expectation> outOfCore = obs.expectationValues(block, 4);
+        ASSERT_EQ(outOfCore.size(), 6u);
+        for (int n = 0; n < 6; n++) {
+            ASSERT_EQ(outOfCore[n].norm, inCore[n].norm);
+            ASSERT_EQ(outOfCore[n].x2, inCore[n].x2);
+            ASSERT_EQ(outOfCore[n].T, inCore[n].T);
+        }
+    }
+
+    TEST(SolverConfig, MeshToleranceAndUnitsOfASolve) {
+        ASSERT_EQ(SolverConfig::current().getMesh(), dx);
+        ASSERT_EQ(SolverConfig::current().getTolerance(), err);
+
+        // the same oscillator on a grid twice as fine, the mesh taken from the basis
+        ContinuousBase fine(0.005, 2000);
+        Potential V = Potential::Builder(fine.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        Spectrum s = solve_spectrum(Spectrum::Numerov, 3, fine, V);
+        for (int n = 0; n < 3; n++)
+            ASSERT_NEAR(s.energies[n], n + 0.5, 1e-7);
+        ASSERT_EQ(SolverConfig::current().getMesh(), dx);
+
+        // m = 2: omega = sqrt(2 k / m)
+        SolverConfig heavy(fine);
+        heavy.setUnits(1., 2.);
+        std::vector<double> psi(2001);
+        psi[1] = 0.01;
+        double E = solve_Numerov_level(1, 2000, V, psi.data(), heavy);
+        ASSERT_NEAR(E, 1.5 * std::sqrt(0.5), 1e-7);
+        {
+            SolverConfig::Scope scope(heavy);
+            ASSERT_EQ(SolverConfig::current().getMass(), 2.);
+            ASSERT_NEAR(analytic_states(2, fine, V, false).energies[1], E, 1e-7);
+        }
+        ASSERT_EQ(SolverConfig::current().getMass(), 1.);
+
+        // a looser tolerance stops the bisection earlier
+        ContinuousBase base(dx, 1000);
+        Potential W = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        std::vector<double> wf(1001);
+        wf[1] = 0.01;
+        unsigned long before = numerov_sweeps();
+        double tight = solve_Numerov(0., 2., 0.01, 1000, W, wf.data());
+        unsigned long tightSweeps = numerov_sweeps() - before;
+        before = numerov_sweeps();
+        double loose = solve_Numerov(0., 2., 0.01, 1000, W, wf.data(), SolverConfig().setTolerance(1e-4));
+        ASSERT_LT(numerov_sweeps() - before, tightSweeps);
+        ASSERT_NEAR(loose, tight, 1e-3);
+
+        ASSERT_THROW(SolverConfig().setMesh(0.), std::invalid_argument);
+        ASSERT_THROW(SolverConfig().setUnits(1., -1.), std::invalid_argument);
+    }
+
+    TEST(SolverConfig, ConcurrentSolvesOnDifferentGrids) {
+        // one box of length 10 on three meshes, solved concurrently, each as if alone
+        const double meshes[3] = {0.01, 0.005, 0.0025};
+        double serial[3], concurrent[3];
+        auto solve = [&](int g, double *out) {
+            int nbox = (int) std::lround(10. / meshes[g]);
+            ContinuousBase base(meshes[g], nbox);
+            Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+            Wavefunction psi(base);
+            out[g] = solve_Numerov_level(2, V, psi);
+        };
+        for (int g = 0; g < 3; g++)
+            solve(g, serial);
+
+        std::vector<std::thread> threads;
+        for (int g = 0; g < 3; g++)
+            threads.emplace_back(solve, g, concurrent);
+        for (auto &t : threads)
+            t.join();
+        for (int g = 0; g < 3; g++) {
+            ASSERT_EQ(concurrent[g], serial[g]);
+            ASSERT_NEAR(serial[g], 2.5, 1e-6);
+        }
+
+        // the server answers each request on its own mesh
+        Server server;
+        JsonObject answer = JsonObject::parse(server.handle(
+            "{\"potential\": \"harmonic oscillator\", \"k\": 0.5, \"mesh\": 0.005, \"nbox\": 2000, \"tolerance\": 1e-8}"));
+        ASSERT_EQ(answer.getString("status", ""), "ok");
+        ASSERT_NEAR(answer.getNumber("energy", 0.), 0.5, 1e-6);
+    }
+
+    TEST(SolverConfig, GivenConfigOverridesTheCurrentOne) {
+        ContinuousBase base(dx, 1000);
+        Potential V = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        // m = 2: omega = sqrt(2 k / m)
+        const SolverConfig heavy = SolverConfig(base).setUnits(1., 2.);
+        const double omega = std::sqrt(0.5);
+
+        SolverConfig::Scope scope(SolverConfig(base).setUnits(1., 0.5));
+        ASSERT_NEAR(analytic_states(2, base, V, false, heavy).energies[1], 1.5 * omega, 1e-12);
+
+        // the odd sector is solved on a thread of its own, whose current configuration is the default one
+        Spectrum s = solve_spectrum(Spectrum::Numerov, 2, base, V, true, heavy);
+        ASSERT_NEAR(s.energies[0], 0.5 * omega, 1e-6);
+        ASSERT_NEAR(s.energies[1], 1.5 * omega, 1e-6);
+
+        std::vector<double> psi(1001);
+        psi[1] = 0.01;
+        ASSERT_NEAR(solve_Numerov(0.3, 0.4, 0.01, 1000, V, psi.data(), heavy), 0.5 * omega, 1e-6);
+
+        // <T> = E / 2 for the oscillator; hbar^2 / 2m of the current configuration is four times that of heavy
+        const std::vector<const double *> states = {s.wavefunctions[0].data()};
+        double T = Observables(base, V, Observables::Simpson, 1, heavy).expectationValues(states)[0].T;
+        ASSERT_NEAR(T, 0.25 * omega, 1e-4);
+        ASSERT_NEAR(Observables(base, V).expectationValues(states)[0].T, 4. * T, 1e-10);
+    }
+
+    TEST(ImaginaryTime, BoxLevelsAreTheExactDifferenceLevels) {
+        // anisotropic 3D box: the levels of the second order Laplacian are sums of (2 / h^2)(1 - cos(pi m / nbox)) / 2
+        std::vector<ContinuousBase> axes = {ContinuousBase(0.25, 16), ContinuousBase(0.2, 20), ContinuousBase(0.15, 24)};
+        std::vector<Potential> V;
+        for (ContinuousBase &axis : axes)
+            V.push_back(Potential::Builder(axis.getCoords()).setType("box").build());
+        Base base(Base::Cartesian, 3, axes, std::vector<DiscreteBase>());
+
+        std::vector<double> exact;
+        for (int i = 1; i <= 3; i++)
+            for (int j = 1; j <= 3; j++)
+                for (int k = 1; k <= 3; k++) {
+                    int m[3] = {i, j, k};
+                    double E = 0.;
+                    for (int a = 0; a < 3; a++) {
+                        double h = axes[a].getMesh();
+                        E += (1. - std::cos(M_PI * m[a] / axes[a].getNbox())) / (h * h);
+                    }
+                    exact.push_back(E);
+                }
+        std::sort(exact.begin(), exact.end());
+
+        ImaginaryTime it(base, V);
+        ASSERT_EQ(it.getPoints(), 15u * 19u * 23u);
+        ImaginaryTime::Result r = it.setTolerance(1e-10).run(3);
+        ASSERT_TRUE(r.converged);
+        for (int n = 0; n < 3; n++) {
+            ASSERT_NEAR(r.energies[n], exact[n], 1e-8);
+            ASSERT_LT(r.variances[n], 1e-10);
+        }
+
+        // orthonormal with the volume element, and the same on any number of threads
+        double dV = 0.25 * 0.2 * 0.15, norm = 0., overlap = 0.;
+        for (std::size_t i = 0; i < it.getPoints(); i++) {
+            norm += r.states[0][i] * r.states[0][i] * dV;
+            overlap += r.states[0][i] * r.states[1][i] * dV;
+        }
+        ASSERT_NEAR(norm, 1., 1e-12);
+        ASSERT_NEAR(overlap, 0., 1e-8);
+        ImaginaryTime::Result threaded = ImaginaryTime(base, V, 3).setTolerance(1e-10).run(3);
+        ASSERT_EQ(threaded.steps, r.steps);
+        for (int n = 0; n < 3; n++)
+            ASSERT_EQ(threaded.energies[n], r.energies[n]);
+
+        ASSERT_THROW(ImaginaryTime(base, {V[0], V[1]}), std::invalid_argument);
+        ASSERT_THROW(it.run(0), std::invalid_argument);
+    }
+
+    TEST(ImaginaryTime, OscillatorOnTheWholeGrid) {
+        // 2D isotropic oscillator (omega = 1): 1, 2, 2 up to the O(h^2) error of the grid
+        BasisManager::Builder builder;
+        Base base = builder.build(Base::Cartesian, 2, 0.1, 100);
+        ContinuousBase axis = base.getContinuous()[0];
+        Potential ho = Potential::Builder(axis.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        Potential box = Potential::Builder(axis.getCoords()).setType("box").build();
+
+        ImaginaryTime::Result separable = ImaginaryTime(base, {ho, ho}, 2).run(3);
+        ASSERT_TRUE(separable.converged);
+        ASSERT_NEAR(separable.energies[0], 1., 1e-3);
+        ASSERT_NEAR(separable.energies[1], 2., 2e-3);
+        ASSERT_NEAR(separable.energies[2], 2., 2e-3);
+
+        // the same potential as a non separable term on an empty box
+        const std::vector<double> &v = ho.getValues();
+        std::vector<double> values;
+        for (int j = 1; j < 100; j++)
+            for (int i = 1; i < 100; i++)
+                values.push_back(v[i] + v[j]);
+        ImaginaryTime whole(base, {box, box}, 2);
+        ImaginaryTime::Result r = whole.setValues(values).run(3);
+        ASSERT_TRUE(r.converged);
+        for (int n = 0; n < 3; n++)
+            ASSERT_NEAR(r.energies[n], separable.energies[n], 1e-7);
+        ASSERT_THROW(whole.setValues(std::vector<double>(10, 0.)), std::invalid_argument);
+    }
+
+    TEST(CoupledChannels, UncoupledChannelsAreTheScalarLevels) {
+        ContinuousBase base(0.05, 200);
+        Potential soft = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        Potential stiff = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(2.).build();
+
+        // the scalar Numerov levels on the same grid
+        std::vector<double> scalar, wavefunction(201, 0.);
+        wavefunction[1] = 0.01;
+        for (int n = 0; n < 4; n++) {
+            scalar.push_back(solve_Numerov_level(n, 200, soft, wavefunction.data(), SolverConfig(base)));
+            scalar.push_back(solve_Numerov_level(n, 200, stiff, wavefunction.data(), SolverConfig(base)));
+        }
+        std::sort(scalar.begin(), scalar.end());
+
+        CoupledChannels single(base, DiscreteBase(0, 1, 1), {soft});
+        ASSERT_NEAR(single.solve(1).energy, 1.5, 1e-5);
+        ASSERT_NEAR(single.solve(1).energy, scalar[2], 1e-9);
+
+        CoupledChannels cc(base, DiscreteBase(0, 2, 1), {soft, stiff});
+        ASSERT_EQ(cc.getChannels().size(), 2u);
+        std::vector<double> energies = cc.levels(5);
+        for (int n = 0; n < 5; n++)
+            ASSERT_NEAR(energies[n], scalar[n], 1e-9);
+        // levels 0.5 1 1.5 2.5 3
+        ASSERT_EQ(cc.count(2.), 3);
+        ASSERT_EQ(cc.count(2.6), 4);
+
+        // the ground state lives in the soft channel alone
+        CoupledChannels::Level ground = cc.solve(0);
+        std::vector<double> x = base.getCoords();
+        for (int i = 1; i < 200; i++) {
+            ASSERT_NEAR(ground.channels[0][i], std::exp(-x[i] * x[i] / 2.) / std::pow(M_PI, 0.25), 1e-4);
+            ASSERT_NEAR(ground.channels[1][i], 0., 1e-10);
+        }
+        ASSERT_THROW(cc.setCoupling(0, 0, soft), std::invalid_argument);
+        ASSERT_THROW(CoupledChannels(base, DiscreteBase(0, 2, 1), {soft}), std::invalid_argument);
+    }
+
+    TEST(CoupledChannels, ConstantCouplingShiftsTheLevels) {
+        // V = v(x) 1 + C, C constant: the levels are those of v shifted by the eigenvalues of C
+        ContinuousBase base(0.05, 200);
+        Potential ho = Potential::Builder(base.getCoords()).setType("harmonic oscillator").setK(0.5).build();
+        std::vector<double> wavefunction(201, 0.);
+        wavefunction[1] = 0.01;
+        double E0 = solve_Numerov_level(0, 200, ho, wavefunction.data(), SolverConfig(base));
+
+        // two channels (the kernel of fixed size), coupled by 0.25: even and odd combinations at E0 -+ 0.25
+        std::vector<double> coupling(200, 0.25);
+        Potential quarter = Potential::Builder(base.getCoords()).setType("box").build();
+        quarter.setValues(coupling);
+        CoupledChannels pair(base, DiscreteBase(-1, 2, 2), {ho, ho});
+        pair.setCoupling(0, 1, quarter);
+        CoupledChannels::Level even = pair.solve(0);
+        ASSERT_NEAR(even.energy, E0 - 0.25, 1e-9);
+        ASSERT_NEAR(pair.solve(1).energy, E0 + 0.25, 1e-9);
+        for (int i = 1; i < 200; i++)
+            ASSERT_NEAR(even.channels[0][i], -even.channels[1][i], 1e-7);
+
+        // 24 channels in a chain (the kernel of run time size): C tridiagonal, eigenvalues 2 t cos(pi k / 25)
+        const int n = 24;
+        const double t = 0.1;
+        std::vector<double> hopping(200, t);
+        Potential chain = Potential::Builder(base.getCoords()).setType("box").build();
+        chain.setValues(hopping);
+        CoupledChannels many(base, DiscreteBase(0, n, 1), std::vector<Potential>(n, ho));
+        for (int a = 0; a + 1 < n; a++)
+            many.setCoupling(a, a + 1, chain);
+        std::vector<double> energies = many.levels(3);
+        for (int k = 0; k < 3; k++)
+            ASSERT_NEAR(energies[k], E0 - 2. * t * std::cos(M_PI * (k + 1) / (n + 1)), 1e-8);
     }/*
 */
 }
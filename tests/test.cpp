@@ -1,3 +1,6 @@
+#include <algorithm>
+
+#include <Analytic.h>
 #include <Schroedinger.h>
 
 /*! Calculates the analytical wavefunction of a particle in a box
@@ -104,12 +107,12 @@ double finite_well_wf(int nlevel, int nbox, double pot_width, double pot_height,
 
 
     // Final Normalization
-    double *probab = new double[nbox];
+    std::vector<double> probab(nbox + 1);
 
     for (int i = 0; i <= nbox; i++)
         probab[i] = wavefunction[i] * wavefunction[i];
 
-    double norm = trap_array(0., nbox, dx, probab);
+    double norm = trap_array(0, nbox, (double) dx, probab.data());
     for (int i = 0; i <= nbox; i++)
         wavefunction[i] = wavefunction[i] / sqrt(norm);
     //
@@ -117,18 +120,37 @@ double finite_well_wf(int nlevel, int nbox, double pot_width, double pot_height,
     return E_n;
 }
 
-inline int factorial(int x, int result = 1) {
-    if (x == 1 || x == 0) return result; else return factorial(x - 1, x * result);
-}
-
+/*! Level nlevel of the harmonic oscillator on the grid of the tests, from the normalized Hermite recurrence
+of harmonic_states (no factorial, any level).
+*/
 double harmonic_wf(int nlevel, int nbox, double omega, double* wavefunction) {
-    double c = mass * omega / hbar;
-    double E_n = hbar * omega * (nlevel + 0.5);
+    std::vector<double> x(nbox);
+    for (int i = 0; i < nbox; i++)
+        x[i] = (-nbox / 2 + i) * dx;
 
-    for (int i = 0; i < nbox; i++) {
-        double x = (-nbox / 2 + i) * dx;
-        wavefunction[i] = sqrt(1 / pow(2, nlevel) / factorial(nlevel) * sqrt(c / pi))
-            * exp(-c / 2. * x*x) * std::hermite(nlevel, sqrt(c)*x);
+    AnalyticStates states = harmonic_states(nlevel + 1, x, omega);
+    std::copy(states.level(nlevel), states.level(nlevel) + nbox, wavefunction);
+    return states.energies[nlevel];
+}
+
+/*! Lowest band of the Kronig-Penney lattice (wells of width w, barriers of height V0 and width b) at
+crystal momentum k, from cos(k (w + b)) = cos(alpha w) cosh(beta b) + (beta^2 - alpha^2) / (2 alpha beta) sin(alpha w) sinh(beta b).
+*/
+double kronig_penney_energy(double k, double w, double b, double V0) {
+    auto D = [&](double E) {
+        double alpha = sqrt(2. * mass * E) / hbar, beta = sqrt(2. * mass * (V0 - E)) / hbar;
+        return cos(alpha * w) * cosh(beta * b)
+            + (beta * beta - alpha * alpha) / (2. * alpha * beta) * sin(alpha * w) * sinh(beta * b);
+    };
+    // D decreases across the band, from D > 1 at its bottom
+    double Emin = 1e-12, Emax = std::min(V0, pi * pi * hbar * hbar / 2. / mass / w / w) - 1e-12;
+    double target = cos(k * (w + b));
+    for (int i = 0; i < 200; i++) {
+        double Emiddle = (Emin + Emax) / 2.;
+        if (D(Emiddle) > target)
+            Emin = Emiddle;
+        else
+            Emax = Emiddle;
     }
-    return E_n;
+    return (Emin + Emax) / 2.;
 }
@@ -1,3 +1,4 @@
 double box_wf(int, int, double*);
 double finite_well_wf(int, int, double, double, double*);
 double harmonic_wf(int, int, double, double*);
+double kronig_penney_energy(double, double, double, double);